@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <optional>
+#include <unders_helpers/small_vector.hpp>
 #include <unders_helpers/term_colors.hpp>
 
 #include "rerror/error.hpp"
@@ -58,7 +59,7 @@ struct std::formatter<re::AnyError> {
     }
 
     // Get all causes
-    std::vector<const re::AnyError*> causes{};
+    uh::small_vector<const re::AnyError*, 8> causes{};
     auto cause = std::ref(value->cause());
     while (cause.get() != std::nullopt) {
       auto* current_cause = &cause.get().value();
@@ -147,7 +148,7 @@ struct std::formatter<re::Error<TKind>> {
     }
 
     // Get all causes
-    std::vector<const re::AnyError*> causes{};
+    uh::small_vector<const re::AnyError*, 8> causes{};
     auto cause = std::ref(value.cause());
     while (cause.get() != std::nullopt) {
       auto* current_cause = &cause.get().value();
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_extension/string_extension.hpp>
 #include <string_view>
+#include <unders_helpers/small_vector.hpp>
 #include <unders_helpers/term_colors.hpp>
 #include <unders_helpers/types.hpp>
 #include <vector>
@@ -82,7 +83,7 @@ struct std::formatter<std::source_location> {
 
     // Parse function signature
     // Parse function name
-    std::vector<std::string_view> function_full_name_parts = se::split(function_full_name, "::");
+    uh::small_vector<std::string_view, 8> function_full_name_parts = se::split(function_full_name, "::");
     // Manual join as function_name (i.e. last of function_full_name_parts) is different
     std::string displayed_function_name;
     // Reserve for fullname + 1st namespace color + all but one delimitor styling + function actual name + default color end
@@ -111,7 +112,7 @@ struct std::formatter<std::source_location> {
     std::string_view function_return_type = function_signature.substr(0, function_name_begin_index - 1);
 
     std::string_view function_parameters = function_signature.substr(parameter_begin_index + 1, function_signature.size() - parameter_begin_index - 2);
-    std::vector<std::string_view> split_function_parameters = se::split(function_parameters, ", ");
+    uh::small_vector<std::string_view, 8> split_function_parameters = se::split(function_parameters, ", ");
     std::string displayed_function_parameters = split_function_parameters |
                                                 std::views::join_with(std::format("{0}, {1}", LOW_COLOR, TYPE_COLOR)) |
                                                 std::ranges::to<std::string>();
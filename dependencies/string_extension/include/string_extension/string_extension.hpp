@@ -1,12 +1,13 @@
 #include <string>
 #include <string_view>
-#include <vector>
+#include <unders_helpers/small_vector.hpp>
 
 namespace se {
 
 // Splits a given string into parts given a delimitor (delimitor excluded)
 // Can be replaced by std::ranges::view::split or std::ranges::split_view
 // But I had issue with it, it was simpler for me to implement one that's less generic
-auto split(std::string_view value, std::string delimitor) -> std::vector<std::string_view>;
+// Up to 8 parts are stored inline, no allocation for the usual short splits
+auto split(std::string_view value, std::string delimitor) -> uh::small_vector<std::string_view, 8>;
 
 } // namespace se
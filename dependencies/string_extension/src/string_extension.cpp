@@ -2,10 +2,10 @@
 
 #include <unders_helpers/types.hpp>
 
-auto se::split(std::string_view value, std::string delimitor) -> std::vector<std::string_view> {
+auto se::split(std::string_view value, std::string delimitor) -> uh::small_vector<std::string_view, 8> {
   const usize delimitor_length = delimitor.length();
 
-  std::vector<std::string_view> parts;
+  uh::small_vector<std::string_view, 8> parts;
   usize current_index = 0, next_index;
 
   // Finds all delimitor until end of value, taking each substring in between
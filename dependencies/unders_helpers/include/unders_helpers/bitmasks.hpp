@@ -32,3 +32,50 @@ constexpr E operator~(E flag) noexcept {
   using Underlying = std::underlying_type_t<E>;
   return static_cast<E>(~static_cast<Underlying>(flag));
 }
+
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr E operator^(E lhs, E rhs) noexcept {
+  using Underlying = std::underlying_type_t<E>;
+  return static_cast<E>(static_cast<Underlying>(lhs) ^ static_cast<Underlying>(rhs));
+}
+
+// Compound assignments
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr E& operator|=(E& lhs, E rhs) noexcept {
+  return lhs = lhs | rhs;
+}
+
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr E& operator&=(E& lhs, E rhs) noexcept {
+  return lhs = lhs & rhs;
+}
+
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr E& operator^=(E& lhs, E rhs) noexcept {
+  return lhs = lhs ^ rhs;
+}
+
+// Tests
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr bool has_any(E value, E flags) noexcept {
+  using Underlying = std::underlying_type_t<E>;
+  return (static_cast<Underlying>(value) & static_cast<Underlying>(flags)) != 0;
+}
+
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr bool has_all(E value, E flags) noexcept {
+  using Underlying = std::underlying_type_t<E>;
+  return (static_cast<Underlying>(value) & static_cast<Underlying>(flags)) == static_cast<Underlying>(flags);
+}
+
+template <typename E>
+  requires BitmaskEnum<E>
+constexpr bool has_none(E value, E flags) noexcept {
+  return !has_any(value, flags);
+}
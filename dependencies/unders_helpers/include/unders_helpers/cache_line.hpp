@@ -0,0 +1,13 @@
+#pragma once
+
+#include <unders_helpers/types.hpp>
+
+namespace uh {
+// Destructive interference size used to pad data written by different threads
+// Fixed instead of std::hardware_destructive_interference_size, which may change between compilers/flags (and warns on GCC)
+#if defined(__APPLE__) && defined(__aarch64__)
+constexpr usize CACHE_LINE_SIZE = 128;
+#else
+constexpr usize CACHE_LINE_SIZE = 64;
+#endif
+} // namespace uh
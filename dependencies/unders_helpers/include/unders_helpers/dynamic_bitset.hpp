@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace uh {
+// Runtime sized set of bits stored in 64 bit words (component signatures, dirty chunks, visibility masks, ...)
+// Set operations work a word at a time (4 words at a time with AVX2), counting uses popcount and iterating the set bits
+// only visits non-zero words, jumping from bit to bit with std::countr_zero
+// Bits past size() are always 0 so whole words can be compared/counted without masking
+// Binary operations take bitsets of any size, the shorter one reads as 0 past its size() and the left one keeps its size
+class dynamic_bitset {
+ public:
+  using word_type = u64;
+  static constexpr usize WORD_BITS = 64;
+  static constexpr usize NPOS = ~usize{0};
+
+ private:
+  /* Members */
+  std::vector<word_type> _words;
+  usize _size = 0;
+
+ public:
+  /* Constructors */
+  dynamic_bitset() noexcept = default;
+  explicit dynamic_bitset(usize size, bool value = false) { resize(size, value); }
+
+  /* Capacity */
+  [[nodiscard]] usize size() const noexcept { return _size; }
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] usize word_count() const noexcept { return _words.size(); }
+  [[nodiscard]] std::span<const word_type> words() const noexcept { return _words; }
+
+  // New bits take value
+  void resize(usize size, bool value = false) {
+    const usize old_size = _size;
+    _words.resize(words_for(size), value ? ~word_type{0} : word_type{0});
+    _size = size;
+
+    // The unused bits of the previous last word become part of the set
+    if (value && size > old_size && old_size % WORD_BITS != 0)
+      _words[old_size / WORD_BITS] |= ~word_type{0} << (old_size % WORD_BITS);
+    clear_unused_bits();
+  }
+
+  // Size 0, keeps the allocation
+  void clear() noexcept {
+    _words.clear();
+    _size = 0;
+  }
+
+  /* Bits */
+  [[nodiscard]] bool test(usize index) const noexcept { return (_words[index / WORD_BITS] >> (index % WORD_BITS)) & 1; }
+  [[nodiscard]] bool operator[](usize index) const noexcept { return test(index); }
+
+  void set(usize index) noexcept { _words[index / WORD_BITS] |= word_type{1} << (index % WORD_BITS); }
+  void set(usize index, bool value) noexcept { value ? set(index) : reset(index); }
+  void reset(usize index) noexcept { _words[index / WORD_BITS] &= ~(word_type{1} << (index % WORD_BITS)); }
+  void flip(usize index) noexcept { _words[index / WORD_BITS] ^= word_type{1} << (index % WORD_BITS); }
+
+  // Whole set
+  void set() noexcept {
+    std::fill(_words.begin(), _words.end(), ~word_type{0});
+    clear_unused_bits();
+  }
+  void reset() noexcept { std::fill(_words.begin(), _words.end(), word_type{0}); }
+  void flip() noexcept {
+    for (word_type& word : _words)
+      word = ~word;
+    clear_unused_bits();
+  }
+
+  /* Set operations */
+  dynamic_bitset& operator&=(const dynamic_bitset& other) noexcept { return apply<Operation::And>(other); }
+  dynamic_bitset& operator|=(const dynamic_bitset& other) noexcept { return apply<Operation::Or>(other); }
+  dynamic_bitset& operator^=(const dynamic_bitset& other) noexcept { return apply<Operation::Xor>(other); }
+  // this &= ~other
+  dynamic_bitset& and_not(const dynamic_bitset& other) noexcept { return apply<Operation::AndNot>(other); }
+
+  [[nodiscard]] friend dynamic_bitset operator&(dynamic_bitset lhs, const dynamic_bitset& rhs) { return lhs &= rhs; }
+  [[nodiscard]] friend dynamic_bitset operator|(dynamic_bitset lhs, const dynamic_bitset& rhs) { return lhs |= rhs; }
+  [[nodiscard]] friend dynamic_bitset operator^(dynamic_bitset lhs, const dynamic_bitset& rhs) { return lhs ^= rhs; }
+
+  [[nodiscard]] friend bool operator==(const dynamic_bitset& lhs, const dynamic_bitset& rhs) noexcept {
+    return lhs._size == rhs._size && lhs._words == rhs._words;
+  }
+
+  /* Queries */
+  [[nodiscard]] usize count() const noexcept {
+    const usize word_count = _words.size();
+    const word_type* words = _words.data();
+    usize i = 0, total = 0;
+
+#ifdef __AVX2__
+    // Per byte popcount with a nibble lookup table, summed by _mm256_sad_epu8 into 4 u64 lanes
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i sums = _mm256_setzero_si256();
+    for (; i + 4 <= word_count; i += 4) {
+      const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+      const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(block, low_mask));
+      const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(block, 4), low_mask));
+      sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    alignas(32) u64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    total = static_cast<usize>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#endif
+
+    for (; i < word_count; i++)
+      total += static_cast<usize>(std::popcount(words[i]));
+    return total;
+  }
+
+  [[nodiscard]] bool any() const noexcept { return any_word<Operation::Or>(_words.data(), _words.data(), _words.size()); }
+  [[nodiscard]] bool none() const noexcept { return !any(); }
+  [[nodiscard]] bool all() const noexcept { return count() == _size; }
+
+  // Whether a bit is set in both (e.g. a visibility mask against a layer mask)
+  [[nodiscard]] bool intersects(const dynamic_bitset& other) const noexcept {
+    return any_word<Operation::And>(_words.data(), other._words.data(), std::min(_words.size(), other._words.size()));
+  }
+
+  // Whether every bit set here is set in other (e.g. a system's required components against an entity signature)
+  [[nodiscard]] bool is_subset_of(const dynamic_bitset& other) const noexcept {
+    const usize common = std::min(_words.size(), other._words.size());
+    if (any_word<Operation::AndNot>(_words.data(), other._words.data(), common))
+      return false;
+    // Bits here past other's size are not in other
+    return std::all_of(_words.begin() + static_cast<std::ptrdiff_t>(common), _words.end(), [](word_type word) { return word == 0; });
+  }
+
+  /* Iteration */
+  // First set bit at or after index, NPOS if none
+  [[nodiscard]] usize find_next(usize index) const noexcept {
+    if (index >= _size)
+      return NPOS;
+
+    usize word_index = index / WORD_BITS;
+    word_type word = _words[word_index] & (~word_type{0} << (index % WORD_BITS));
+    while (word == 0) {
+      if (++word_index == _words.size())
+        return NPOS;
+      word = _words[word_index];
+    }
+    return word_index * WORD_BITS + static_cast<usize>(std::countr_zero(word));
+  }
+  [[nodiscard]] usize find_first() const noexcept { return find_next(0); }
+
+  // Calls function(index) for every set bit, in increasing order
+  template <typename TFunction>
+  void for_each_set(TFunction&& function) const {
+    const usize word_count = _words.size();
+    usize word_index = 0;
+
+#ifdef __AVX2__
+    // Skips 256 bits at once in sparse sets
+    for (; word_index + 4 <= word_count; word_index += 4) {
+      const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_words.data() + word_index));
+      if (_mm256_testz_si256(block, block))
+        continue;
+
+      for (usize i = word_index; i < word_index + 4; i++)
+        for_each_set_in_word(_words[i], i, function);
+    }
+#endif
+
+    for (; word_index < word_count; word_index++)
+      for_each_set_in_word(_words[word_index], word_index, function);
+  }
+
+ private:
+  [[nodiscard]] static constexpr usize words_for(usize bits) noexcept { return (bits + WORD_BITS - 1) / WORD_BITS; }
+
+  void clear_unused_bits() noexcept {
+    if (const usize used = _size % WORD_BITS; used != 0)
+      _words.back() &= ~word_type{0} >> (WORD_BITS - used);
+  }
+
+  template <typename TFunction>
+  static void for_each_set_in_word(word_type word, usize word_index, TFunction& function) {
+    for (; word != 0; word &= word - 1)
+      function(word_index * WORD_BITS + static_cast<usize>(std::countr_zero(word)));
+  }
+
+  enum class Operation {
+    And,
+    Or,
+    Xor,
+    AndNot
+  };
+
+  template <Operation TOperation>
+  static constexpr word_type apply_word(word_type a, word_type b) noexcept {
+    if constexpr (TOperation == Operation::And)
+      return a & b;
+    else if constexpr (TOperation == Operation::Or)
+      return a | b;
+    else if constexpr (TOperation == Operation::Xor)
+      return a ^ b;
+    else
+      return a & ~b;
+  }
+
+  // Whether a <operation> b has a bit set, stops at the first non-zero word
+  template <Operation TOperation>
+  static bool any_word(const word_type* a, const word_type* b, usize word_count) noexcept {
+    usize i = 0;
+
+#ifdef __AVX2__
+    for (; i + 4 <= word_count; i += 4) {
+      const __m256i block_a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+      const __m256i block_b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+      bool zero;
+      if constexpr (TOperation == Operation::And)
+        zero = _mm256_testz_si256(block_a, block_b); // (a & b) == 0
+      else if constexpr (TOperation == Operation::AndNot)
+        zero = _mm256_testc_si256(block_b, block_a); // (~b & a) == 0
+      else
+        zero = _mm256_testz_si256(block_a, block_a) && _mm256_testz_si256(block_b, block_b);
+      if (!zero)
+        return true;
+    }
+#endif
+
+    for (; i < word_count; i++)
+      if (apply_word<TOperation>(a[i], b[i]) != 0)
+        return true;
+    return false;
+  }
+
+  // Word-wise this = this <operation> other, other's missing words being 0
+  template <Operation TOperation>
+  dynamic_bitset& apply(const dynamic_bitset& other) noexcept {
+    const usize word_count = std::min(_words.size(), other._words.size());
+    word_type* words = _words.data();
+    const word_type* other_words = other._words.data();
+    usize i = 0;
+
+#ifdef __AVX2__
+    for (; i + 4 <= word_count; i += 4) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+      const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(other_words + i));
+      __m256i result;
+      if constexpr (TOperation == Operation::And)
+        result = _mm256_and_si256(a, b);
+      else if constexpr (TOperation == Operation::Or)
+        result = _mm256_or_si256(a, b);
+      else if constexpr (TOperation == Operation::Xor)
+        result = _mm256_xor_si256(a, b);
+      else
+        result = _mm256_andnot_si256(b, a); // ~b & a
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(words + i), result);
+    }
+#endif
+
+    for (; i < word_count; i++)
+      words[i] = apply_word<TOperation>(words[i], other_words[i]);
+
+    // x & 0 == 0, the other operations keep the words past other's; a larger other may set bits past size()
+    if constexpr (TOperation == Operation::And)
+      std::fill(_words.begin() + static_cast<std::ptrdiff_t>(word_count), _words.end(), word_type{0});
+    else if constexpr (TOperation == Operation::Or || TOperation == Operation::Xor)
+      clear_unused_bits();
+    return *this;
+  }
+};
+} // namespace uh
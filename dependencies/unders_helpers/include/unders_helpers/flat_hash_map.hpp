@@ -0,0 +1,477 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unders_helpers/types.hpp>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace uh {
+namespace detail {
+// Control byte of a slot: full slots store the low 7 bits of their hash (H2), the others have the high bit set
+enum class Control : i8 {
+  Empty = -128,
+  Deleted = -2,
+  Sentinel = -1 // Ends iteration, right after the last slot
+};
+
+constexpr usize GROUP_WIDTH = 16;
+
+// GROUP_WIDTH control bytes probed at once, each match is a bit (bit i: control byte i)
+struct Group {
+#ifdef __SSE2__
+  __m128i control;
+
+  explicit Group(const i8* position) noexcept : control(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position))) {}
+
+  [[nodiscard]] u32 match(i8 h2) const noexcept {
+    return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), control)));
+  }
+  [[nodiscard]] u32 match_empty() const noexcept { return match(static_cast<i8>(Control::Empty)); }
+  // Empty and deleted are the only values below the sentinel
+  [[nodiscard]] u32 match_empty_or_deleted() const noexcept {
+    return static_cast<u32>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(static_cast<i8>(Control::Sentinel)), control)));
+  }
+#else
+  i8 control[GROUP_WIDTH];
+
+  explicit Group(const i8* position) noexcept { std::memcpy(control, position, GROUP_WIDTH); }
+
+  [[nodiscard]] u32 match(i8 h2) const noexcept {
+    u32 mask = 0;
+    for (usize i = 0; i < GROUP_WIDTH; i++)
+      mask |= static_cast<u32>(control[i] == h2) << i;
+    return mask;
+  }
+  [[nodiscard]] u32 match_empty() const noexcept { return match(static_cast<i8>(Control::Empty)); }
+  [[nodiscard]] u32 match_empty_or_deleted() const noexcept {
+    u32 mask = 0;
+    for (usize i = 0; i < GROUP_WIDTH; i++)
+      mask |= static_cast<u32>(control[i] < static_cast<i8>(Control::Sentinel)) << i;
+    return mask;
+  }
+#endif
+};
+
+// Spreads the bits of weak hashes (e.g. std::hash<integer> is the identity) over the whole word
+[[nodiscard]] constexpr u64 mix_hash(u64 hash) noexcept {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+} // namespace detail
+
+// Open addressing hash map (Swiss table layout)
+// Slots live in one flat array next to an array of control bytes, lookups probe GROUP_WIDTH control bytes at once with
+// SIMD and only compare keys whose 7 bit hash fragment matches. Erased slots become tombstones, reclaimed on rehash
+// Same interface as std::unordered_map for the common operations but, like every flat map, inserting may move elements
+// and invalidate references/iterators, and erase(iterator) returns nothing
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>, typename TEqual = std::equal_to<TKey>>
+class flat_hash_map {
+ public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using value_type = std::pair<const TKey, TValue>;
+  using size_type = usize;
+  using hasher = THash;
+  using key_equal = TEqual;
+
+ private:
+  using Control = detail::Control;
+  using Group = detail::Group;
+  static constexpr usize GROUP_WIDTH = detail::GROUP_WIDTH;
+  static constexpr usize CLONED_BYTES = GROUP_WIDTH - 1;
+
+  /* Iterators */
+  template <bool Const>
+  class basic_iterator {
+    friend class flat_hash_map;
+
+    using element = std::pair<const TKey, TValue>;
+    using slot_pointer = std::conditional_t<Const, const element*, element*>;
+
+    const i8* _control = nullptr;
+    slot_pointer _slot = nullptr;
+
+    basic_iterator(const i8* control, slot_pointer slot) noexcept : _control(control), _slot(slot) { skip_empty(); }
+
+    void skip_empty() noexcept {
+      while (*_control < static_cast<i8>(Control::Sentinel)) {
+        _control++;
+        _slot++;
+      }
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = element;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const element&, element&>;
+    using pointer = slot_pointer;
+
+    basic_iterator() noexcept = default;
+    // iterator -> const_iterator
+    template <bool OtherConst>
+      requires(Const && !OtherConst)
+    basic_iterator(const basic_iterator<OtherConst>& other) noexcept : _control(other._control), _slot(other._slot) {}
+
+    reference operator*() const noexcept { return *_slot; }
+    pointer operator->() const noexcept { return _slot; }
+
+    basic_iterator& operator++() noexcept {
+      _control++;
+      _slot++;
+      skip_empty();
+      return *this;
+    }
+    basic_iterator operator++(int) noexcept {
+      basic_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) noexcept { return lhs._slot == rhs._slot; }
+  };
+
+ public:
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+ private:
+  /* Members */
+  i8* _control = empty_control(); // capacity + 1 (sentinel) + CLONED_BYTES (copy of the first bytes, groups never wrap)
+  value_type* _slots = nullptr;
+  usize _capacity = 0; // 0 or 2^n - 1, also the probing mask
+  usize _size = 0;
+  usize _growth_left = 0; // Empty slots that can be used before a rehash (keeps the load factor under 7/8)
+  [[no_unique_address]] THash _hash;
+  [[no_unique_address]] TEqual _equal;
+
+ public:
+  /* Constructors */
+  flat_hash_map() noexcept(std::is_nothrow_default_constructible_v<THash> && std::is_nothrow_default_constructible_v<TEqual>) = default;
+  explicit flat_hash_map(usize capacity, const THash& hash = THash(), const TEqual& equal = TEqual()) : _hash(hash), _equal(equal) { reserve(capacity); }
+
+  template <std::input_iterator TIterator>
+  flat_hash_map(TIterator first, TIterator last) { insert(first, last); }
+
+  flat_hash_map(std::initializer_list<value_type> values) { insert(values.begin(), values.end()); }
+
+  /* Special constructors */
+  flat_hash_map(const flat_hash_map& other) : _hash(other._hash), _equal(other._equal) {
+    reserve(other._size);
+    insert(other.begin(), other.end());
+  }
+  flat_hash_map& operator=(const flat_hash_map& other) {
+    if (this != &other) {
+      flat_hash_map copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  flat_hash_map(flat_hash_map&& other) noexcept
+      : _control(std::exchange(other._control, empty_control())),
+        _slots(std::exchange(other._slots, nullptr)),
+        _capacity(std::exchange(other._capacity, 0)),
+        _size(std::exchange(other._size, 0)),
+        _growth_left(std::exchange(other._growth_left, 0)),
+        _hash(std::move(other._hash)),
+        _equal(std::move(other._equal)) {}
+  flat_hash_map& operator=(flat_hash_map&& other) noexcept {
+    if (this != &other) {
+      flat_hash_map moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  ~flat_hash_map() { release(); }
+
+  /* Iterators */
+  [[nodiscard]] iterator begin() noexcept { return iterator(_control, _slots); }
+  [[nodiscard]] const_iterator begin() const noexcept { return const_iterator(_control, _slots); }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+  [[nodiscard]] iterator end() noexcept { return iterator(_control + _capacity, _slots + _capacity); }
+  [[nodiscard]] const_iterator end() const noexcept { return const_iterator(_control + _capacity, _slots + _capacity); }
+  [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+  /* Capacity */
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] usize size() const noexcept { return _size; }
+  [[nodiscard]] usize capacity() const noexcept { return _capacity; }
+  [[nodiscard]] f32 load_factor() const noexcept { return _capacity == 0 ? 0.0f : static_cast<f32>(_size) / static_cast<f32>(_capacity); }
+
+  // Makes room for count elements without rehashing
+  void reserve(usize count) {
+    if (count > _size + _growth_left)
+      resize(capacity_for(count));
+  }
+
+  // Rebuilds the table (dropping tombstones), with room for at least count elements
+  void rehash(usize count) { resize(capacity_for(std::max(count, _size))); }
+
+  /* Lookup */
+  [[nodiscard]] iterator find(const TKey& key) noexcept {
+    const usize index = find_index(key, hash_of(key));
+    return index == NOT_FOUND ? end() : iterator_at(index);
+  }
+  [[nodiscard]] const_iterator find(const TKey& key) const noexcept {
+    const usize index = find_index(key, hash_of(key));
+    return index == NOT_FOUND ? end() : const_iterator_at(index);
+  }
+  [[nodiscard]] bool contains(const TKey& key) const noexcept { return find_index(key, hash_of(key)) != NOT_FOUND; }
+  [[nodiscard]] usize count(const TKey& key) const noexcept { return contains(key) ? 1 : 0; }
+
+  [[nodiscard]] TValue& at(const TKey& key) {
+    const usize index = find_index(key, hash_of(key));
+    if (index == NOT_FOUND) [[unlikely]]
+      throw std::out_of_range("uh::flat_hash_map::at");
+    return _slots[index].second;
+  }
+  [[nodiscard]] const TValue& at(const TKey& key) const {
+    const usize index = find_index(key, hash_of(key));
+    if (index == NOT_FOUND) [[unlikely]]
+      throw std::out_of_range("uh::flat_hash_map::at");
+    return _slots[index].second;
+  }
+
+  TValue& operator[](const TKey& key) { return try_emplace(key).first->second; }
+  TValue& operator[](TKey&& key) { return try_emplace(std::move(key)).first->second; }
+
+  /* Modifiers */
+  // Constructs the value only if the key isn't there yet
+  template <typename TKeyArgument, typename... Args>
+  std::pair<iterator, bool> try_emplace(TKeyArgument&& key, Args&&... args) {
+    const u64 hash = hash_of(key);
+    if (const usize index = find_index(key, hash); index != NOT_FOUND)
+      return {iterator_at(index), false};
+
+    const usize index = prepare_insert(hash);
+    ::new (static_cast<void*>(_slots + index))
+        value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<TKeyArgument>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    return {iterator_at(index), true};
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+  std::pair<iterator, bool> insert(value_type&& value) { return try_emplace(value.first, std::move(value.second)); }
+
+  template <std::input_iterator TIterator>
+  void insert(TIterator first, TIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  template <typename TMapped>
+  std::pair<iterator, bool> insert_or_assign(const TKey& key, TMapped&& value) {
+    auto [position, inserted] = try_emplace(key, std::forward<TMapped>(value));
+    if (!inserted)
+      position->second = std::forward<TMapped>(value);
+    return {position, inserted};
+  }
+
+  usize erase(const TKey& key) {
+    const usize index = find_index(key, hash_of(key));
+    if (index == NOT_FOUND)
+      return 0;
+
+    erase_at(index);
+    return 1;
+  }
+  void erase(const_iterator position) { erase_at(static_cast<usize>(position._slot - _slots)); }
+
+  // Keeps the allocation
+  void clear() noexcept {
+    if (_capacity == 0)
+      return;
+
+    destroy_elements();
+    std::memset(_control, static_cast<i8>(Control::Empty), _capacity + 1 + CLONED_BYTES);
+    _control[_capacity] = static_cast<i8>(Control::Sentinel);
+    _size = 0;
+    _growth_left = max_size_for(_capacity);
+  }
+
+  void swap(flat_hash_map& other) noexcept {
+    std::swap(_control, other._control);
+    std::swap(_slots, other._slots);
+    std::swap(_capacity, other._capacity);
+    std::swap(_size, other._size);
+    std::swap(_growth_left, other._growth_left);
+    std::swap(_hash, other._hash);
+    std::swap(_equal, other._equal);
+  }
+
+ private:
+  static constexpr usize NOT_FOUND = ~usize{0};
+
+  // Shared by every empty map: a sentinel ends iteration right away and find() never probes (capacity 0)
+  [[nodiscard]] static i8* empty_control() noexcept {
+    alignas(GROUP_WIDTH) static i8 control[GROUP_WIDTH] = {
+        static_cast<i8>(Control::Sentinel), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty),
+        static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty),
+        static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty),
+        static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty), static_cast<i8>(Control::Empty)};
+    return control;
+  }
+
+  // Max load factor 7/8, there is always an empty slot to end probe sequences
+  [[nodiscard]] static constexpr usize max_size_for(usize capacity) noexcept { return capacity - capacity / 8; }
+  [[nodiscard]] static constexpr usize capacity_for(usize count) noexcept {
+    usize capacity = GROUP_WIDTH - 1;
+    while (max_size_for(capacity) < count)
+      capacity = capacity * 2 + 1;
+    return capacity;
+  }
+
+  [[nodiscard]] u64 hash_of(const TKey& key) const noexcept(noexcept(_hash(key))) { return detail::mix_hash(static_cast<u64>(_hash(key))); }
+  [[nodiscard]] static constexpr usize h1(u64 hash) noexcept { return static_cast<usize>(hash >> 7); }
+  [[nodiscard]] static constexpr i8 h2(u64 hash) noexcept { return static_cast<i8>(hash & 0x7F); }
+
+  [[nodiscard]] iterator iterator_at(usize index) noexcept { return iterator(_control + index, _slots + index); }
+  [[nodiscard]] const_iterator const_iterator_at(usize index) const noexcept { return const_iterator(_control + index, _slots + index); }
+
+  // Sets a control byte and its clone
+  void set_control(usize index, i8 value) noexcept {
+    _control[index] = value;
+    _control[((index - CLONED_BYTES) & _capacity) + (CLONED_BYTES & _capacity)] = value;
+  }
+
+  // Probes group by group with a triangular sequence, visiting every group once
+  [[nodiscard]] usize find_index(const TKey& key, u64 hash) const noexcept {
+    if (_capacity == 0)
+      return NOT_FOUND;
+
+    usize offset = h1(hash) & _capacity;
+    for (usize step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+      const Group group(_control + offset);
+      for (u32 matches = group.match(h2(hash)); matches != 0; matches &= matches - 1) {
+        const usize index = (offset + static_cast<usize>(std::countr_zero(matches))) & _capacity;
+        if (_equal(_slots[index].first, key)) [[likely]]
+          return index;
+      }
+
+      // An empty slot ends the probe sequence, the key would have been put there
+      if (group.match_empty() != 0) [[likely]]
+        return NOT_FOUND;
+      offset = (offset + step) & _capacity;
+    }
+  }
+
+  [[nodiscard]] usize find_first_non_full(u64 hash) const noexcept {
+    usize offset = h1(hash) & _capacity;
+    for (usize step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+      if (const u32 free = Group(_control + offset).match_empty_or_deleted(); free != 0)
+        return (offset + static_cast<usize>(std::countr_zero(free))) & _capacity;
+      offset = (offset + step) & _capacity;
+    }
+  }
+
+  // Reserves the slot of a new element (not constructed yet), rehashing if needed
+  usize prepare_insert(u64 hash) {
+    usize index = find_first_non_full(hash);
+    if (_growth_left == 0 && _control[index] != static_cast<i8>(Control::Deleted)) [[unlikely]] {
+      // Many tombstones: rebuild at the same size, otherwise grow
+      if (_capacity > GROUP_WIDTH && _size * 32 <= _capacity * 25)
+        resize(_capacity);
+      else
+        resize(_capacity == 0 ? capacity_for(1) : _capacity * 2 + 1);
+      index = find_first_non_full(hash);
+    }
+
+    if (_control[index] == static_cast<i8>(Control::Empty))
+      _growth_left--;
+    _size++;
+    set_control(index, h2(hash));
+    return index;
+  }
+
+  void erase_at(usize index) noexcept {
+    std::destroy_at(_slots + index);
+    _size--;
+
+    // If no group containing this slot was ever full, no probe went past it: it can be empty again instead of a tombstone
+    const u32 empty_after = Group(_control + index).match_empty();
+    const u32 empty_before = Group(_control + ((index - GROUP_WIDTH) & _capacity)).match_empty();
+    const bool was_never_full = empty_before != 0 && empty_after != 0 &&
+                                static_cast<usize>(std::countr_zero(empty_after)) + static_cast<usize>(std::countl_zero(static_cast<u16>(empty_before))) < GROUP_WIDTH;
+
+    set_control(index, static_cast<i8>(was_never_full ? Control::Empty : Control::Deleted));
+    if (was_never_full)
+      _growth_left++;
+  }
+
+  void resize(usize capacity) {
+    i8* old_control = _control;
+    value_type* old_slots = _slots;
+    const usize old_capacity = _capacity;
+
+    // Control bytes then slots, in one allocation
+    const usize control_size = (capacity + 1 + CLONED_BYTES + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+    std::byte* memory = static_cast<std::byte*>(::operator new(control_size + capacity * sizeof(value_type), std::align_val_t{allocation_alignment()}));
+    _control = reinterpret_cast<i8*>(memory);
+    _slots = reinterpret_cast<value_type*>(memory + control_size);
+    _capacity = capacity;
+    std::memset(_control, static_cast<i8>(Control::Empty), capacity + 1 + CLONED_BYTES);
+    _control[capacity] = static_cast<i8>(Control::Sentinel);
+    _growth_left = max_size_for(capacity) - _size;
+
+    // Keys are copied (they are const in the slots), values moved
+    for (usize i = 0; i < old_capacity; i++) {
+      if (old_control[i] < 0)
+        continue;
+
+      value_type& element = old_slots[i];
+      const u64 hash = hash_of(element.first);
+      const usize index = find_first_non_full(hash);
+      set_control(index, h2(hash));
+      ::new (static_cast<void*>(_slots + index)) value_type(std::move(element));
+      std::destroy_at(&element);
+    }
+
+    if (old_capacity != 0)
+      ::operator delete(old_control, std::align_val_t{allocation_alignment()});
+  }
+
+  void destroy_elements() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (usize i = 0; i < _capacity; i++)
+        if (_control[i] >= 0)
+          std::destroy_at(_slots + i);
+    }
+  }
+
+  void release() noexcept {
+    if (_capacity == 0)
+      return;
+
+    destroy_elements();
+    ::operator delete(_control, std::align_val_t{allocation_alignment()});
+    _control = empty_control();
+    _slots = nullptr;
+    _capacity = _size = _growth_left = 0;
+  }
+
+  [[nodiscard]] static constexpr usize allocation_alignment() noexcept { return std::max(alignof(value_type), GROUP_WIDTH); }
+};
+} // namespace uh
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <unders_helpers/cache_line.hpp>
+#include <unders_helpers/types.hpp>
+#include <utility>
+
+namespace uh {
+// Bounded multi producer, multi consumer lock-free queue (Dmitry Vyukov's)
+// Each cell carries a sequence number telling whose turn it is:
+// - sequence == position:     free, the producer claiming position may write it
+// - sequence == position + 1: full, the consumer claiming position may read it
+// Producers (consumers) claim positions with a CAS on the enqueue (dequeue) counter, then publish the cell by advancing
+// its sequence, so a slow thread only delays its own cell. Batches claim a run of ready cells with a single CAS
+// Never allocates: elements live inside the queue, which is neither copyable nor moveable
+template <typename T, usize Capacity>
+  requires(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0 && std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>)
+class mpmc_queue {
+ public:
+  using value_type = T;
+
+ private:
+  static constexpr usize MASK = Capacity - 1;
+
+  struct Cell {
+    std::atomic<usize> sequence;
+    alignas(T) std::byte bytes[sizeof(T)];
+
+    [[nodiscard]] T* element() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+  };
+
+  /* Members */
+  alignas(CACHE_LINE_SIZE) std::atomic<usize> _enqueue_position{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<usize> _dequeue_position{0};
+  alignas(CACHE_LINE_SIZE) Cell _cells[Capacity];
+
+ public:
+  /* Constructors */
+  mpmc_queue() noexcept {
+    for (usize i = 0; i < Capacity; i++)
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Shared between threads, must not move
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  /* Destructor */
+  ~mpmc_queue() {
+    const usize end = _enqueue_position.load(std::memory_order_relaxed);
+    for (usize position = _dequeue_position.load(std::memory_order_relaxed); position != end; position++)
+      _cells[position & MASK].element()->~T();
+  }
+
+  /* Producers */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+    usize count = 1;
+    const usize position = claim<0>(count);
+    if (position == NONE)
+      return false;
+
+    Cell& cell = _cells[position & MASK];
+    ::new (static_cast<void*>(cell.bytes)) T(std::forward<Args>(args)...);
+    cell.sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return try_emplace(value); }
+  bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+  // Claims up to values.size() consecutive free cells at once, returns how many were pushed
+  usize try_push_n(std::span<const T> values) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+    usize count = values.size();
+    const usize position = claim<0>(count);
+    if (position == NONE)
+      return 0;
+
+    for (usize i = 0; i < count; i++) {
+      Cell& cell = _cells[(position + i) & MASK];
+      ::new (static_cast<void*>(cell.bytes)) T(values[i]);
+      cell.sequence.store(position + i + 1, std::memory_order_release);
+    }
+    return count;
+  }
+
+  /* Consumers */
+  bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    usize count = 1;
+    const usize position = claim<1>(count);
+    if (position == NONE)
+      return false;
+
+    read(position, value);
+    return true;
+  }
+
+  // Claims up to values.size() consecutive full cells at once, returns how many were popped
+  usize try_pop_n(std::span<T> values) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    usize count = values.size();
+    const usize position = claim<1>(count);
+    if (position == NONE)
+      return 0;
+
+    for (usize i = 0; i < count; i++)
+      read(position + i, values[i]);
+    return count;
+  }
+
+  /* Observers */
+  // A snapshot, may be stale as soon as it returns
+  [[nodiscard]] usize size_approx() const noexcept {
+    const usize dequeue = _dequeue_position.load(std::memory_order_acquire);
+    const usize enqueue = _enqueue_position.load(std::memory_order_acquire);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+  [[nodiscard]] bool empty_approx() const noexcept { return size_approx() == 0; }
+  [[nodiscard]] static constexpr usize capacity() noexcept { return Capacity; }
+
+ private:
+  static constexpr usize NONE = ~usize{0};
+
+  void read(usize position, T& value) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    Cell& cell = _cells[position & MASK];
+    T* source = cell.element();
+    value = std::move(*source);
+    source->~T();
+    // Free for the producer one lap later
+    cell.sequence.store(position + Capacity, std::memory_order_release);
+  }
+
+  // Claims up to count consecutive positions whose cells are ready (Offset 0: free for producers, 1: full for
+  // consumers), count is updated with the number claimed. Returns the first position, NONE if nothing is ready
+  template <usize Offset>
+  usize claim(usize& count) noexcept {
+    std::atomic<usize>& counter = Offset == 0 ? _enqueue_position : _dequeue_position;
+    usize position = counter.load(std::memory_order_relaxed);
+    while (true) {
+      // Ready cells can't become unready until claimed, so the run found here stays valid if the CAS succeeds
+      usize ready = 0;
+      for (; ready < count && ready < Capacity; ready++) {
+        const usize sequence = _cells[(position + ready) & MASK].sequence.load(std::memory_order_acquire);
+        if (sequence != position + ready + Offset)
+          break;
+      }
+
+      if (ready == 0) {
+        const usize sequence = _cells[position & MASK].sequence.load(std::memory_order_acquire);
+        // Behind: full (producers) or empty (consumers)
+        if (static_cast<std::make_signed_t<usize>>(sequence - (position + Offset)) < 0)
+          return NONE;
+
+        // Another thread claimed this position already
+        position = counter.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (counter.compare_exchange_weak(position, position + ready, std::memory_order_relaxed)) {
+        count = ready;
+        return position;
+      }
+    }
+  }
+};
+} // namespace uh
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <unders_helpers/types.hpp>
+#include <utility>
+#include <vector>
+
+namespace uh {
+// Generational handle to an element of an object_pool<T>
+// The low bits hold the slot index, the high bits the generation the slot had when the element was created:
+// - u32: 20 bit index (1M slots), 12 bit generation
+// - u64: 32 bit index, 32 bit generation
+// Generations of live elements are odd, so the all-zero handle is never valid (null)
+template <typename T, typename TStorage = u32>
+  requires(std::same_as<TStorage, u32> || std::same_as<TStorage, u64>)
+class handle {
+ public:
+  using storage_type = TStorage;
+
+  static constexpr u32 INDEX_BITS = sizeof(TStorage) == 4 ? 20 : 32;
+  static constexpr u32 GENERATION_BITS = sizeof(TStorage) * 8 - INDEX_BITS;
+  static constexpr TStorage MAX_INDEX = (TStorage{1} << INDEX_BITS) - 1;
+  static constexpr TStorage MAX_GENERATION = (TStorage{1} << GENERATION_BITS) - 1;
+
+ private:
+  TStorage _value = 0;
+
+ public:
+  /* Constructors */
+  constexpr handle() noexcept = default;
+  constexpr handle(TStorage index, TStorage generation) noexcept : _value(index | (generation << INDEX_BITS)) {}
+
+  // For storage (e.g. snapshots), no validation
+  [[nodiscard]] static constexpr handle from_raw(TStorage value) noexcept {
+    handle result;
+    result._value = value;
+    return result;
+  }
+
+  /* Getters */
+  [[nodiscard]] constexpr TStorage raw() const noexcept { return _value; }
+  [[nodiscard]] constexpr TStorage index() const noexcept { return _value & MAX_INDEX; }
+  [[nodiscard]] constexpr TStorage generation() const noexcept { return _value >> INDEX_BITS; }
+  [[nodiscard]] constexpr explicit operator bool() const noexcept { return _value != 0; }
+
+  /* Comparison */
+  [[nodiscard]] friend constexpr bool operator==(handle, handle) noexcept = default;
+  [[nodiscard]] friend constexpr auto operator<=>(handle, handle) noexcept = default;
+};
+
+// Pool of T in fixed size blocks, referred to by generational handles instead of pointers
+// - Blocks are never moved nor freed before the pool, so elements keep their address and stay close in memory
+// - Free slots form an intrusive LIFO list threaded through their storage, the last freed slot is reused first (warm)
+// - Every slot keeps a generation bumped on creation and destruction, a stale handle is a generation mismatch (O(1))
+// - A slot whose generation can't grow anymore is retired instead of being reused, stale handles never come back to life
+// Retiring trades memory for safety: with u32 handles a slot lasts 2048 reuses and the hot slots at the head of the free
+// list are reused the most, so a pool creating and erasing elements all the time keeps retiring slots and growing (a new
+// block every BlockSize retirements). Use u64 handles for such pools, a slot then lasts 2^31 reuses
+template <typename T, typename TStorage = u32, usize BlockSize = 256>
+  requires(BlockSize > 0 && std::is_nothrow_destructible_v<T>)
+class object_pool {
+ public:
+  using value_type = T;
+  using handle_type = handle<T, TStorage>;
+
+  static constexpr usize block_size = BlockSize;
+
+ private:
+  static constexpr TStorage NONE = ~TStorage{0};
+
+  struct Slot {
+    // T while alive, the index of the next free slot otherwise
+    alignas(T) alignas(TStorage) std::byte bytes[sizeof(T) > sizeof(TStorage) ? sizeof(T) : sizeof(TStorage)];
+    TStorage generation; // Odd while alive
+
+    [[nodiscard]] T* element() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+    [[nodiscard]] const T* element() const noexcept { return std::launder(reinterpret_cast<const T*>(bytes)); }
+    [[nodiscard]] TStorage& next_free() noexcept { return *std::launder(reinterpret_cast<TStorage*>(bytes)); }
+  };
+
+  struct Block {
+    Slot slots[BlockSize];
+  };
+
+  /* Members */
+  std::vector<std::unique_ptr<Block>> _blocks;
+  TStorage _free = NONE; // Head of the free list
+  usize _used = 0;       // Slots handed out at least once (the rest of the last block was never touched)
+  usize _size = 0;
+
+ public:
+  /* Constructors */
+  object_pool() noexcept = default;
+
+  // Handles are only meaningful for the pool that made them
+  object_pool(const object_pool&) = delete;
+  object_pool& operator=(const object_pool&) = delete;
+
+  object_pool(object_pool&& other) noexcept
+      : _blocks(std::move(other._blocks)), _free(std::exchange(other._free, NONE)), _used(std::exchange(other._used, 0)), _size(std::exchange(other._size, 0)) {}
+  object_pool& operator=(object_pool&& other) noexcept {
+    if (this != &other) {
+      destroy_all();
+      _blocks = std::move(other._blocks);
+      _free = std::exchange(other._free, NONE);
+      _used = std::exchange(other._used, 0);
+      _size = std::exchange(other._size, 0);
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  ~object_pool() { destroy_all(); }
+
+  /* Capacity */
+  [[nodiscard]] usize size() const noexcept { return _size; }
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] usize capacity() const noexcept { return _blocks.size() * BlockSize; }
+
+  // Allocates the blocks for capacity slots up front
+  void reserve(usize capacity) {
+    while (this->capacity() < capacity)
+      _blocks.push_back(std::make_unique<Block>());
+  }
+
+  /* Modifiers */
+  template <typename... Args>
+  handle_type emplace(Args&&... args) {
+    const TStorage index = acquire();
+    Slot& slot = slot_at(index);
+
+    try {
+      ::new (static_cast<void*>(slot.bytes)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      release(index, slot);
+      throw;
+    }
+
+    slot.generation++;
+    _size++;
+    return handle_type(index, slot.generation);
+  }
+
+  // Returns false if the handle was already stale
+  bool erase(handle_type handle) noexcept {
+    if (!contains(handle))
+      return false;
+
+    Slot& slot = slot_at(handle.index());
+    slot.element()->~T();
+    slot.generation++;
+    _size--;
+    release(handle.index(), slot);
+    return true;
+  }
+
+  void clear() noexcept {
+    for_each([this](handle_type handle, T&) { erase(handle); });
+  }
+
+  /* Access */
+  [[nodiscard]] bool contains(handle_type handle) const noexcept {
+    const TStorage generation = handle.generation();
+    return (generation & 1) != 0 && handle.index() < _used && slot_at(handle.index()).generation == generation;
+  }
+
+  // nullptr if the handle is stale
+  [[nodiscard]] T* get(handle_type handle) noexcept { return contains(handle) ? slot_at(handle.index()).element() : nullptr; }
+  [[nodiscard]] const T* get(handle_type handle) const noexcept { return contains(handle) ? slot_at(handle.index()).element() : nullptr; }
+
+  /* Iteration */
+  // Calls function(handle, element) for every live element, in slot order. Erasing the current element is allowed
+  template <typename TFunction>
+  void for_each(TFunction&& function) {
+    for (usize index = 0; index < _used; index++) {
+      Slot& slot = slot_at(static_cast<TStorage>(index));
+      if (slot.generation & 1)
+        function(handle_type(static_cast<TStorage>(index), slot.generation), *slot.element());
+    }
+  }
+
+  template <typename TFunction>
+  void for_each(TFunction&& function) const {
+    for (usize index = 0; index < _used; index++) {
+      const Slot& slot = slot_at(static_cast<TStorage>(index));
+      if (slot.generation & 1)
+        function(handle_type(static_cast<TStorage>(index), slot.generation), *slot.element());
+    }
+  }
+
+ private:
+  [[nodiscard]] Slot& slot_at(TStorage index) noexcept { return _blocks[index / BlockSize]->slots[index % BlockSize]; }
+  [[nodiscard]] const Slot& slot_at(TStorage index) const noexcept { return _blocks[index / BlockSize]->slots[index % BlockSize]; }
+
+  // A free slot index, from the free list or past the last used slot
+  [[nodiscard]] TStorage acquire() {
+    if (_free != NONE) {
+      const TStorage index = _free;
+      _free = slot_at(index).next_free();
+      return index;
+    }
+
+    if (_used > handle_type::MAX_INDEX) [[unlikely]]
+      throw std::length_error("uh::object_pool: handle index space exhausted");
+    if (_used == capacity())
+      _blocks.push_back(std::make_unique<Block>());
+
+    const TStorage index = static_cast<TStorage>(_used++);
+    slot_at(index).generation = 0;
+    return index;
+  }
+
+  // Slot is free (even generation), back into the free list unless its generation is exhausted
+  void release(TStorage index, Slot& slot) noexcept {
+    if (slot.generation + 1 > handle_type::MAX_GENERATION) [[unlikely]]
+      return;
+
+    ::new (static_cast<void*>(slot.bytes)) TStorage(_free);
+    _free = index;
+  }
+
+  void destroy_all() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (usize index = 0; index < _used; index++) {
+        Slot& slot = slot_at(static_cast<TStorage>(index));
+        if (slot.generation & 1)
+          slot.element()->~T();
+      }
+    }
+    _blocks.clear();
+    _free = NONE;
+    _used = 0;
+    _size = 0;
+  }
+};
+} // namespace uh
+
+template <typename T, typename TStorage>
+struct std::hash<uh::handle<T, TStorage>> {
+  [[nodiscard]] usize operator()(uh::handle<T, TStorage> handle) const noexcept { return std::hash<TStorage>{}(handle.raw()); }
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <unders_helpers/types.hpp>
+#include <utility>
+
+namespace uh {
+// std::vector with room for N elements inside the object, only going to the heap past that
+// For small, short-lived containers (split results, cause chains, per-cell id lists, ...)
+// Same interface as std::vector for the common operations, iterators are pointers
+// Unlike std::vector, moving a small_vector stored inline moves the elements one by one (and invalidates iterators)
+template <typename T, usize N>
+  requires(N > 0)
+class small_vector {
+ public:
+  using value_type = T;
+  using size_type = usize;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr usize inline_capacity = N;
+
+ private:
+  /* Members */
+  T* _data;
+  usize _size = 0;
+  usize _capacity = N;
+  alignas(T) std::byte _inline[N * sizeof(T)];
+
+ public:
+  /* Constructors */
+  small_vector() noexcept : _data(inline_data()) {}
+
+  explicit small_vector(usize count) : small_vector() { resize(count); }
+  small_vector(usize count, const T& value) : small_vector() { resize(count, value); }
+
+  template <std::input_iterator TIterator>
+  small_vector(TIterator first, TIterator last) : small_vector() { assign(first, last); }
+
+  small_vector(std::initializer_list<T> values) : small_vector() { assign(values.begin(), values.end()); }
+
+  /* Special constructors */
+  small_vector(const small_vector& other) : small_vector() { assign(other.begin(), other.end()); }
+  small_vector& operator=(const small_vector& other) {
+    if (this != &other)
+      assign(other.begin(), other.end());
+    return *this;
+  }
+
+  small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : small_vector() { steal(std::move(other)); }
+  small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      release();
+      steal(std::move(other));
+    }
+    return *this;
+  }
+
+  small_vector& operator=(std::initializer_list<T> values) {
+    assign(values.begin(), values.end());
+    return *this;
+  }
+
+  /* Destructor */
+  ~small_vector() {
+    clear();
+    release();
+  }
+
+  /* Element access */
+  [[nodiscard]] T& operator[](usize index) noexcept { return _data[index]; }
+  [[nodiscard]] const T& operator[](usize index) const noexcept { return _data[index]; }
+  [[nodiscard]] T& at(usize index) {
+    if (index >= _size) [[unlikely]]
+      throw std::out_of_range("uh::small_vector::at");
+    return _data[index];
+  }
+  [[nodiscard]] const T& at(usize index) const {
+    if (index >= _size) [[unlikely]]
+      throw std::out_of_range("uh::small_vector::at");
+    return _data[index];
+  }
+  [[nodiscard]] T& front() noexcept { return _data[0]; }
+  [[nodiscard]] const T& front() const noexcept { return _data[0]; }
+  [[nodiscard]] T& back() noexcept { return _data[_size - 1]; }
+  [[nodiscard]] const T& back() const noexcept { return _data[_size - 1]; }
+  [[nodiscard]] T* data() noexcept { return _data; }
+  [[nodiscard]] const T* data() const noexcept { return _data; }
+
+  /* Iterators */
+  [[nodiscard]] iterator begin() noexcept { return _data; }
+  [[nodiscard]] const_iterator begin() const noexcept { return _data; }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return _data; }
+  [[nodiscard]] iterator end() noexcept { return _data + _size; }
+  [[nodiscard]] const_iterator end() const noexcept { return _data + _size; }
+  [[nodiscard]] const_iterator cend() const noexcept { return _data + _size; }
+  [[nodiscard]] reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  [[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  [[nodiscard]] const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  /* Capacity */
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] usize size() const noexcept { return _size; }
+  [[nodiscard]] usize capacity() const noexcept { return _capacity; }
+  // Whether the elements are stored inside the object
+  [[nodiscard]] bool is_inline() const noexcept { return _data == inline_data(); }
+
+  void reserve(usize capacity) {
+    if (capacity > _capacity)
+      reallocate(capacity);
+  }
+
+  // Moves the elements back inline when they fit
+  void shrink_to_fit() {
+    if (!is_inline() && _size < _capacity)
+      reallocate(_size);
+  }
+
+  /* Modifiers */
+  void clear() noexcept {
+    std::destroy_n(_data, _size);
+    _size = 0;
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (_size == _capacity) [[unlikely]]
+      return grow_emplace_back(std::forward<Args>(args)...);
+
+    T* element = ::new (static_cast<void*>(_data + _size)) T(std::forward<Args>(args)...);
+    _size++;
+    return *element;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  void pop_back() noexcept {
+    _size--;
+    std::destroy_at(_data + _size);
+  }
+
+  template <typename... Args>
+  iterator emplace(const_iterator position, Args&&... args) {
+    const usize index = static_cast<usize>(position - _data);
+    if (index == _size) {
+      emplace_back(std::forward<Args>(args)...);
+      return _data + index;
+    }
+
+    // Built first, args may refer to an element of this vector
+    T value(std::forward<Args>(args)...);
+    emplace_back(std::move(back()));
+    std::move_backward(_data + index, _data + _size - 2, _data + _size - 1);
+    _data[index] = std::move(value);
+    return _data + index;
+  }
+
+  iterator insert(const_iterator position, const T& value) { return emplace(position, value); }
+  iterator insert(const_iterator position, T&& value) { return emplace(position, std::move(value)); }
+
+  iterator erase(const_iterator position) { return erase(position, position + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    T* begin = _data + (first - _data);
+    const usize count = static_cast<usize>(last - first);
+    if (count == 0)
+      return begin;
+
+    std::move(begin + count, _data + _size, begin);
+    std::destroy_n(_data + _size - count, count);
+    _size -= count;
+    return begin;
+  }
+
+  void resize(usize size) { resize_with(size, [](T* element) { ::new (static_cast<void*>(element)) T(); }); }
+  void resize(usize size, const T& value) { resize_with(size, [&value](T* element) { ::new (static_cast<void*>(element)) T(value); }); }
+
+  template <std::input_iterator TIterator>
+  void assign(TIterator first, TIterator last) {
+    clear();
+    if constexpr (std::forward_iterator<TIterator>)
+      reserve(static_cast<usize>(std::distance(first, last)));
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    small_vector temporary(std::move(other));
+    other = std::move(*this);
+    *this = std::move(temporary);
+  }
+
+  /* Comparison */
+  [[nodiscard]] friend bool operator==(const small_vector& lhs, const small_vector& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  [[nodiscard]] friend auto operator<=>(const small_vector& lhs, const small_vector& rhs) {
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+
+ private:
+  [[nodiscard]] T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(_inline)); }
+  [[nodiscard]] const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(_inline)); }
+
+  // Elements are already destroyed
+  void release() noexcept {
+    if (!is_inline())
+      ::operator delete(_data, _capacity * sizeof(T), std::align_val_t{alignof(T)});
+    _data = inline_data();
+    _capacity = N;
+  }
+
+  // Takes the heap buffer of other, or moves its inline elements. this is empty and inline
+  void steal(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (other.is_inline()) {
+      std::uninitialized_move_n(other._data, other._size, _data);
+      _size = other._size;
+      other.clear();
+      return;
+    }
+
+    _data = std::exchange(other._data, other.inline_data());
+    _size = std::exchange(other._size, 0);
+    _capacity = std::exchange(other._capacity, N);
+  }
+
+  // Capacity can't go below N nor below the size
+  void reallocate(usize capacity) {
+    capacity = std::max(capacity, _size);
+    T* data = capacity <= N ? inline_data()
+                            : static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t{alignof(T)}));
+    if (data == _data)
+      return;
+
+    std::uninitialized_move_n(_data, _size, data);
+    std::destroy_n(_data, _size);
+    if (!is_inline())
+      ::operator delete(_data, _capacity * sizeof(T), std::align_val_t{alignof(T)});
+
+    _data = data;
+    _capacity = std::max(capacity, N);
+  }
+
+  template <typename... Args>
+  T& grow_emplace_back(Args&&... args) {
+    // Built in the new buffer before moving, args may refer to an element of this vector
+    const usize capacity = _capacity * 2;
+    T* data = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t{alignof(T)}));
+    T* element = ::new (static_cast<void*>(data + _size)) T(std::forward<Args>(args)...);
+
+    std::uninitialized_move_n(_data, _size, data);
+    std::destroy_n(_data, _size);
+    if (!is_inline())
+      ::operator delete(_data, _capacity * sizeof(T), std::align_val_t{alignof(T)});
+
+    _data = data;
+    _capacity = capacity;
+    _size++;
+    return *element;
+  }
+
+  template <typename TConstruct>
+  void resize_with(usize size, TConstruct&& construct) {
+    if (size <= _size) {
+      std::destroy_n(_data + size, _size - size);
+      _size = size;
+      return;
+    }
+
+    if (size > _capacity)
+      reserve(std::max(size, _capacity * 2));
+    for (; _size < size; _size++)
+      construct(_data + _size);
+  }
+};
+} // namespace uh
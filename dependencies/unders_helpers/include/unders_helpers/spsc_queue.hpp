@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <unders_helpers/cache_line.hpp>
+#include <unders_helpers/types.hpp>
+#include <utility>
+
+namespace uh {
+// Bounded single producer, single consumer lock-free ring (Lamport)
+// Head and tail are free-running counters (masked on access) each on its own cache line, next to a cached copy of the
+// other side's counter so the producer/consumer only touch the shared line when the ring looks full/empty
+// Never allocates: elements live inside the queue, which is neither copyable nor moveable
+template <typename T, usize Capacity>
+  requires(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0 && std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>)
+class spsc_queue {
+ public:
+  using value_type = T;
+
+ private:
+  static constexpr usize MASK = Capacity - 1;
+
+  struct alignas(T) Slot {
+    std::byte bytes[sizeof(T)];
+  };
+
+  /* Members */
+  // Producer
+  alignas(CACHE_LINE_SIZE) std::atomic<usize> _tail{0};
+  usize _cached_head = 0;
+  // Consumer
+  alignas(CACHE_LINE_SIZE) std::atomic<usize> _head{0};
+  usize _cached_tail = 0;
+  // Storage
+  alignas(CACHE_LINE_SIZE) Slot _slots[Capacity];
+
+ public:
+  /* Constructors */
+  spsc_queue() noexcept = default;
+
+  // Shared between threads, must not move
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  /* Destructor */
+  ~spsc_queue() {
+    const usize tail = _tail.load(std::memory_order_relaxed);
+    for (usize head = _head.load(std::memory_order_relaxed); head != tail; head++)
+      element(head)->~T();
+  }
+
+  /* Producer */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+    const usize tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cached_head == Capacity) {
+      _cached_head = _head.load(std::memory_order_acquire);
+      if (tail - _cached_head == Capacity)
+        return false;
+    }
+
+    ::new (static_cast<void*>(_slots[tail & MASK].bytes)) T(std::forward<Args>(args)...);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return try_emplace(value); }
+  bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+  // Copies as many values as fit, published at once, returns how many were pushed
+  usize try_push_n(std::span<const T> values) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+    const usize tail = _tail.load(std::memory_order_relaxed);
+    if (Capacity - (tail - _cached_head) < values.size())
+      _cached_head = _head.load(std::memory_order_acquire);
+
+    const usize count = std::min(values.size(), Capacity - (tail - _cached_head));
+    for (usize i = 0; i < count; i++)
+      ::new (static_cast<void*>(_slots[(tail + i) & MASK].bytes)) T(values[i]);
+
+    if (count > 0)
+      _tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  /* Consumer */
+  bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    const usize head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      if (head == _cached_tail)
+        return false;
+    }
+
+    T* source = element(head);
+    value = std::move(*source);
+    source->~T();
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves as many values as available into values, released at once, returns how many were popped
+  usize try_pop_n(std::span<T> values) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    const usize head = _head.load(std::memory_order_relaxed);
+    if (_cached_tail - head < values.size())
+      _cached_tail = _tail.load(std::memory_order_acquire);
+
+    const usize count = std::min(values.size(), _cached_tail - head);
+    for (usize i = 0; i < count; i++) {
+      T* source = element(head + i);
+      values[i] = std::move(*source);
+      source->~T();
+    }
+
+    if (count > 0)
+      _head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer side only, nullptr if empty
+  [[nodiscard]] T* front() noexcept {
+    const usize head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      if (head == _cached_tail)
+        return nullptr;
+    }
+    return element(head);
+  }
+
+  // Consumer side only, after a successful front()
+  void pop() noexcept {
+    const usize head = _head.load(std::memory_order_relaxed);
+    element(head)->~T();
+    _head.store(head + 1, std::memory_order_release);
+  }
+
+  /* Observers */
+  // Exact from a quiescent queue, a snapshot otherwise
+  [[nodiscard]] usize size_approx() const noexcept {
+    const usize head = _head.load(std::memory_order_acquire);
+    return _tail.load(std::memory_order_acquire) - head;
+  }
+  [[nodiscard]] bool empty_approx() const noexcept { return size_approx() == 0; }
+  [[nodiscard]] static constexpr usize capacity() noexcept { return Capacity; }
+
+ private:
+  [[nodiscard]] T* element(usize index) noexcept { return std::launder(reinterpret_cast<T*>(_slots[index & MASK].bytes)); }
+};
+} // namespace uh
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <unders_helpers/types.hpp>
+
+// Counts heap allocations per frame phase by hooking the global operator new/delete
+// Only active when built with the SDL_TEST_ALLOCATION_TRACKING cmake option, otherwise every call is an empty inline
+class AllocationTracker {
+ public:
+  /* Settings (set from cmake) */
+#ifdef SDL_TEST_ALLOCATION_TRACKING
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+#ifdef SDL_TEST_ALLOCATION_STRICT
+  static constexpr bool strict = enabled;
+#else
+  static constexpr bool strict = false;
+#endif
+
+#ifdef SDL_TEST_ALLOCATION_WARMUP_FRAMES
+  static constexpr u64 warmup_frames = SDL_TEST_ALLOCATION_WARMUP_FRAMES;
+#else
+  static constexpr u64 warmup_frames = 120;
+#endif
+
+  /* Types */
+  enum class Phase : u8 {
+    Setup,
+    Input,
+    Update,
+    Draw,
+    Present,
+    Count
+  };
+  static constexpr usize phase_count = static_cast<usize>(Phase::Count);
+
+  struct Counters {
+    u64 allocations = 0;
+    u64 bytes = 0;
+  };
+
+  struct FrameReport {
+    u64 frame = 0;
+    std::array<Counters, phase_count> phases{};
+
+    [[nodiscard]]
+    constexpr u64 allocations() const noexcept {
+      u64 total = 0;
+      for (const Counters& counters : phases)
+        total += counters.allocations;
+      return total;
+    }
+
+    [[nodiscard]]
+    constexpr bool is_steady_state() const noexcept { return frame > warmup_frames; }
+  };
+
+  struct Summary {
+    u64 frames = 0;
+    Counters total{};
+    Counters steady_state{};
+    u64 peak_frame_allocations = 0;
+  };
+
+  /* Static functions */
+#ifdef SDL_TEST_ALLOCATION_TRACKING
+  // Phase of the calling thread's allocations, threads that never set one aren't counted
+  static void set_phase(Phase phase) noexcept;
+  // Closes the current frame, resets the per-phase counters and returns what was counted
+  static FrameReport end_frame() noexcept;
+  [[nodiscard]] static const FrameReport& last_frame() noexcept;
+  [[nodiscard]] static Summary summary() noexcept;
+#else
+  static void set_phase(Phase) noexcept {}
+  static FrameReport end_frame() noexcept { return FrameReport{}; }
+  [[nodiscard]] static const FrameReport& last_frame() noexcept {
+    static constexpr FrameReport empty{};
+    return empty;
+  }
+  [[nodiscard]] static Summary summary() noexcept { return Summary{}; }
+#endif
+};
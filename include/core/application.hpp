@@ -4,11 +4,24 @@
 #include <SDL3/SDL_events.h>
 #include <SDL3/SDL_init.h>
 
+#include <chrono>
 #include <expected>
+#include <format>
+#include <memory>
+#include <optional>
+#include <print>
+#include <ratio>
 #include <rerror/error.hpp>
+#include <span>
 #include <unders_helpers/unused.hpp>
 
+#include "core/allocation_tracker.hpp"
+#include "core/audio.hpp"
+#include "core/event_pump.hpp"
+#include "core/performance_overlay.hpp"
 #include "core/renderer.hpp"
+#include "core/scheduler.hpp"
+#include "core/startup_profile.hpp"
 #include "core/window.hpp"
 
 class Application {
@@ -19,12 +32,23 @@ class Application {
   /* Members */
   Renderer _renderer; // /!\ Must be decalared before _window because of destruction order (see: https://wiki.libsdl.org/SDL3/SDL_DestroyRenderer)
   Window _window;
+  std::optional<Audio> _audio; // Opened on first use, see audio()
+  std::unique_ptr<EventPump> _events; // Behind a pointer, InputState snapshots may be read by other threads
+  Scheduler _scheduler; // Game coroutines, resumed after update() every frame
+  std::unique_ptr<PerformanceOverlay> _overlay; // Behind a pointer, its history and scratch geometry are ~120 KB
+  std::shared_ptr<StartupProfile> _startup; // Shared with background startup work
 
   bool _shouldContinue = true;
 
   /* Constructor */
-  Application(Window&& window, Renderer&& renderer)
-      : _renderer(std::move(renderer)), _window(std::move(window)) {};
+  Application(Window&& window, Renderer&& renderer, std::shared_ptr<StartupProfile>&& startup)
+      : _renderer(std::move(renderer)), _window(std::move(window)), _events(std::make_unique<EventPump>()), _overlay(std::make_unique<PerformanceOverlay>()), _startup(std::move(startup)) {};
+
+  /* Frame loop */
+  // Shared by run() and StaticApplication<TDerived>::run()
+  // Callbacks are called on TSelf, when TSelf is a final class they are devirtualized and can be inlined
+  template <typename TSelf>
+  re::expected<re::AnyError> run_loop(TSelf& self);
 
  public:
   enum class Error {
@@ -33,6 +57,11 @@ class Application {
     SdlInitialization,
     WindowCreation,
     RendererCreation,
+    AudioCreation,
+    CaptureStart,
+    DynamicResolution,
+    SoftwareRasterizer,
+    SteadyStateAllocation,
   };
 
   /* Special constructors */
@@ -42,12 +71,17 @@ class Application {
 
   // Moveable
   Application(Application&& other) noexcept
-      : _renderer(std::move(other._renderer)), _window(std::move(other._window)) {
+      : _renderer(std::move(other._renderer)), _window(std::move(other._window)), _audio(std::move(other._audio)), _events(std::move(other._events)), _scheduler(std::move(other._scheduler)), _overlay(std::move(other._overlay)), _startup(std::move(other._startup)) {
     other._owned = false;
   }
   Application& operator=(Application&& other) noexcept {
     _renderer = std::move(other._renderer);
     _window = std::move(other._window);
+    _audio = std::move(other._audio);
+    _events = std::move(other._events);
+    _scheduler = std::move(other._scheduler);
+    _overlay = std::move(other._overlay);
+    _startup = std::move(other._startup);
 
     other._owned = false;
     return *this;
@@ -60,31 +94,169 @@ class Application {
   }
 
   /* Functional constructors */
+  // Only video is initialized here, other SDL subsystems are initialized by their first user (e.g. audio())
+  // Pass the startup profile when work was started before (or next to) create() so it shows in the same timeline
   [[nodiscard]]
-  static std::expected<Application, re::Error<Error>> create(std::string title, u32 width, u32 height, Window::Flags flags = Window::Flags::None) {
+  static std::expected<Application, re::Error<Error>> create(std::string title, u32 width, u32 height, Window::Flags flags = Window::Flags::None, Renderer::Driver driver = Renderer::Driver::Default,
+                                                             std::shared_ptr<StartupProfile> startup = std::make_shared<StartupProfile>()) {
     // Initialize SDL
-    if (!SDL_Init(SDL_INIT_VIDEO)) [[unlikely]]
-      return std::unexpected(re::error(Error::SdlInitialization, std::string(SDL_GetError())));
+    {
+      const auto stage = startup->scope("sdl video");
+      if (!SDL_Init(SDL_INIT_VIDEO)) [[unlikely]]
+        return std::unexpected(re::error(Error::SdlInitialization, std::string(SDL_GetError())));
+    }
 
     // Window
+    std::optional<StartupProfile::Scope> stage(std::in_place, *startup, "window", false);
     std::expected<Window, re::Error<Window::Error>> window = Window::create(title, width, height, flags);
     if (!window) [[unlikely]]
       return std::unexpected(re::error(Error::WindowCreation, "Failed to create window", std::move(window.error())));
 
     // Renderer
-    std::expected<Renderer, re::Error<Renderer::Error>> renderer = Renderer::create(*window);
+    stage.emplace(*startup, "renderer", false);
+    std::expected<Renderer, re::Error<Renderer::Error>> renderer = Renderer::create(*window, driver);
     if (!renderer) [[unlikely]]
       return std::unexpected(re::error(Error::RendererCreation, "Failed to create Renderer", std::move(renderer.error())));
 
-    return Application(std::move(*window), std::move(*renderer));
+    // Something on screen right away, the first real frame only comes after setup()
+    stage.emplace(*startup, "blank frame", false);
+    renderer->clear(0, 0, 0);
+    SDL_RenderPresent(renderer->get_raw());
+
+    stage.emplace(*startup, "render options", false);
+
+    // Frame capture (requested through the environment)
+    if (std::optional<FrameCapture::Settings> capture_settings = FrameCapture::settings_from_environment()) {
+      if (auto capture = renderer->start_capture(std::move(*capture_settings)); !capture) [[unlikely]]
+        return std::unexpected(re::error(Error::CaptureStart, "Failed to start frame capture", std::move(capture.error())));
+    }
+
+    // Dynamic resolution (requested through the environment)
+    if (std::optional<ResolutionController::Settings> resolution_settings = ResolutionController::settings_from_environment()) {
+      if (auto resolution = renderer->enable_dynamic_resolution(*resolution_settings); !resolution) [[unlikely]]
+        return std::unexpected(re::error(Error::DynamicResolution, "Failed to enable dynamic resolution", std::move(resolution.error())));
+    }
+
+    // Software rasterizer (requested through the environment), replaces dynamic resolution
+    if (std::optional<SoftwareRasterizer::Settings> software_settings = SoftwareRasterizer::settings_from_environment()) {
+      if (auto software = renderer->enable_software_rasterizer(*software_settings); !software) [[unlikely]]
+        return std::unexpected(re::error(Error::SoftwareRasterizer, "Failed to enable the software rasterizer", std::move(software.error())));
+    }
+
+    stage.reset();
+    return Application(std::move(*window), std::move(*renderer), std::move(startup));
   }
 
   /* Member functions */
   re::expected<re::AnyError> run();
 
+  // Opens the audio device on the first call (a few ms to tens of ms, kept off the startup path)
+  [[nodiscard]] std::expected<Audio*, re::Error<Error>> audio();
+  [[nodiscard]] const StartupProfile& startup_profile() const noexcept { return *_startup; }
+
+  // Input of the current frame, read-only, valid on the main thread until the next frame
+  [[nodiscard]] const InputState& input_state() const noexcept { return _events->state(); }
+  // Input of the current frame for worker threads, unchanged for as long as the snapshot is kept (even past frames)
+  [[nodiscard]] EventPump::Snapshot input_snapshot() const noexcept { return _events->snapshot(); }
+
   /* Virtual functions */
   virtual re::expected<re::AnyError> setup() noexcept { return std::unexpected(re::anyError(Error::NotImplemented, "The setup() function was not implemented")); }
   virtual re::expected<re::AnyError> input(const SDL_Event& UNUSED(event)) noexcept { return std::unexpected(re::anyError(Error::NotImplemented, "The input() function was not implemented")); }
   virtual re::expected<re::AnyError> update(double UNUSED(delta_time)) noexcept { return std::unexpected(re::anyError(Error::NotImplemented, "The update() function was not implemented")); }
   virtual re::expected<re::AnyError> draw() const noexcept { return std::unexpected(re::anyError(Error::NotImplemented, "The draw() function was not implemented")); }
 };
+
+template <typename TSelf>
+re::expected<re::AnyError> Application::run_loop(TSelf& self) {
+  using Phase = AllocationTracker::Phase;
+  using Clock = std::chrono::high_resolution_clock;
+  const auto milliseconds = [](Clock::time_point from, Clock::time_point to) { return std::chrono::duration<f32, std::milli>(to - from).count(); };
+
+  AllocationTracker::set_phase(Phase::Setup);
+  {
+    const auto stage = _startup->scope("setup");
+    if (auto setup_result = self.setup(); !setup_result) [[unlikely]]
+      return setup_result;
+  }
+
+  bool first_frame = true;
+  const StartupProfile::Clock::time_point loop_start = StartupProfile::Clock::now();
+  auto start_time = std::chrono::high_resolution_clock().now();
+
+  while (_shouldContinue) {
+    /* Compute delta_time */
+    auto end_time = std::chrono::high_resolution_clock().now();
+    auto delta_time = std::chrono::duration<double, std::milli>(end_time - start_time).count(); // In ms
+    start_time = std::chrono::high_resolution_clock().now();
+
+    PerformanceOverlay::FrameStats stats{};
+    const auto input_start = Clock::now();
+
+    /* Input handling */
+    AllocationTracker::set_phase(Phase::Input);
+    const std::span<const SDL_Event> events = _events->pump();
+    stats.events = static_cast<u32>(_events->received());
+    for (const SDL_Event& event : events) {
+      if (event.type == SDL_EVENT_QUIT) [[unlikely]]
+        _shouldContinue = false;
+      if (event.type == SDL_EVENT_KEY_DOWN && event.key.scancode == PerformanceOverlay::TOGGLE_KEY && !event.key.repeat)
+        _overlay->toggle();
+
+      if (auto input_result = self.input(event); !input_result) [[unlikely]]
+        return input_result;
+    }
+
+    /* Update state */
+    const auto update_start = Clock::now();
+    AllocationTracker::set_phase(Phase::Update);
+    if (auto update_result = self.update(delta_time); !update_result) [[unlikely]]
+      return update_result;
+
+    /* Tasks (within the scheduler's frame budget) */
+    _scheduler.run(delta_time);
+
+    /* Draw current state */
+    const auto draw_start = Clock::now();
+    AllocationTracker::set_phase(Phase::Draw);
+    _renderer.begin_frame();
+    if (auto draw_result = self.draw(); !draw_result) [[unlikely]]
+      return draw_result;
+
+    /* Present (the overlay is drawn on top of everything first, and counted here) */
+    const auto draw_end = Clock::now();
+    const auto present_start = draw_end;
+    AllocationTracker::set_phase(Phase::Present);
+    if (_overlay->visible()) {
+      _renderer.resolve();
+      _overlay->draw(_renderer.get_raw());
+    }
+    _renderer.present();
+    const auto present_end = Clock::now();
+
+    if (first_frame) [[unlikely]] {
+      first_frame = false;
+      _startup->record("first frame", loop_start, StartupProfile::Clock::now());
+      _startup->first_frame();
+      if (StartupProfile::report_requested())
+        std::println("{}", _startup->report());
+    }
+
+    /* Frame statistics */
+    stats.frame_time = milliseconds(input_start, present_end);
+    stats.phases[static_cast<usize>(Phase::Input)] = milliseconds(input_start, update_start);
+    stats.phases[static_cast<usize>(Phase::Update)] = milliseconds(update_start, draw_start);
+    stats.phases[static_cast<usize>(Phase::Draw)] = milliseconds(draw_start, draw_end);
+    stats.phases[static_cast<usize>(Phase::Present)] = milliseconds(present_start, present_end);
+
+    /* Allocation checks (instrumented builds only) */
+    if constexpr (AllocationTracker::enabled) {
+      const AllocationTracker::FrameReport report = AllocationTracker::end_frame();
+      stats.allocations = report.allocations();
+      if (AllocationTracker::strict && report.is_steady_state() && report.allocations() > 0) [[unlikely]]
+        return std::unexpected(re::anyError(Error::SteadyStateAllocation, std::format("Frame {} allocated {} time(s) after warmup (input: {}, update: {}, draw: {}, present: {})", report.frame, report.allocations(), report.phases[static_cast<usize>(Phase::Input)].allocations, report.phases[static_cast<usize>(Phase::Update)].allocations, report.phases[static_cast<usize>(Phase::Draw)].allocations, report.phases[static_cast<usize>(Phase::Present)].allocations)));
+    }
+    _overlay->record(stats);
+  }
+
+  return re::expected<re::AnyError>();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <SDL3/SDL_audio.h>
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_hints.h>
+#include <SDL3/SDL_init.h>
+
+#include <expected>
+#include <memory>
+#include <rerror/error.hpp>
+#include <string>
+#include <unders_helpers/types.hpp>
+#include <unders_helpers/unused.hpp>
+#include <vector>
+
+#include "core/audio_mixer.hpp"
+
+// Audio output built on an SDL audio stream whose callback pulls from an AudioMixer
+// Headless runs can use SDL's dummy or disk driver (SDL_AUDIO_DRIVER=dummy or SDL_AUDIO_DRIVER=disk)
+class Audio {
+ public:
+  /* Settings */
+  static constexpr u32 SAMPLE_RATE = 48000;
+  static constexpr u32 CHANNELS = 2;
+  static constexpr u32 DEFAULT_BUFFER_FRAMES = 256;
+
+  /* Types */
+  using SoundId = u32;
+  using VoiceId = AudioMixer::VoiceId;
+
+  enum class Error {
+    SubsystemInitialization,
+    DeviceOpening,
+    DeviceResume,
+    SoundLoading,
+    SoundConversion,
+    UnknownSound,
+    CommandQueueFull
+  };
+
+  struct PlayParameters {
+    f32 gain = 1.0f;
+    f32 pan = 0.0f;   // -1 (left) to 1 (right)
+    f32 pitch = 1.0f; // Playback speed
+    bool loop = false;
+  };
+
+ protected:
+  // Mono samples, never modified nor freed while the audio device is open
+  struct Sound {
+    std::vector<f32> samples;
+    u32 sample_rate;
+  };
+
+  /* Members */
+  SDL_AudioStream* _stream = nullptr;
+  std::unique_ptr<AudioMixer> _mixer; // Heap allocated, the audio callback keeps a pointer to it
+  std::vector<std::unique_ptr<Sound>> _sounds;
+  VoiceId _next_voice = 1;
+
+  /* Constructor (Protected, use functional constructors instead) */
+  Audio(SDL_AudioStream* stream, std::unique_ptr<AudioMixer>&& mixer)
+      : _stream(stream), _mixer(std::move(mixer)) {}
+
+ public:
+  /* Special constructors */
+  // No copy
+  Audio(const Audio&) = delete;
+  Audio& operator=(const Audio&) = delete;
+
+  // Moveable
+  Audio(Audio&& other) noexcept
+      : _stream(other._stream), _mixer(std::move(other._mixer)), _sounds(std::move(other._sounds)), _next_voice(other._next_voice) {
+    other._stream = nullptr;
+  }
+  Audio& operator=(Audio&& other) noexcept {
+    _stream = other._stream;
+    _mixer = std::move(other._mixer);
+    _sounds = std::move(other._sounds);
+    _next_voice = other._next_voice;
+
+    other._stream = nullptr;
+    return *this;
+  }
+
+  /* Destructor */
+  ~Audio() {
+    if (_stream == nullptr)
+      return;
+
+    // SDL_Quit() may already have closed the device (see Application's destructor)
+    if (SDL_WasInit(SDL_INIT_AUDIO)) {
+      SDL_DestroyAudioStream(_stream);
+      SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+  }
+
+  /* Functional constructors */
+  // buffer_frames is a hint for the device buffer size, smaller means lower latency
+  [[nodiscard]]
+  static std::expected<Audio, re::Error<Error>> create(u32 buffer_frames = DEFAULT_BUFFER_FRAMES) {
+    const std::string buffer_frames_hint = std::to_string(buffer_frames);
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, buffer_frames_hint.c_str());
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) [[unlikely]]
+      return std::unexpected(re::error(Error::SubsystemInitialization, std::string(SDL_GetError())));
+
+    // The device may ask for more than its buffer size, the callback mixes in chunks of max_frames
+    auto mixer = std::make_unique<AudioMixer>(SAMPLE_RATE, buffer_frames * 4);
+
+    const SDL_AudioSpec spec{SDL_AUDIO_F32, CHANNELS, SAMPLE_RATE};
+    SDL_AudioStream* stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, &Audio::callback, mixer.get());
+    if (stream == nullptr) [[unlikely]] {
+      SDL_QuitSubSystem(SDL_INIT_AUDIO);
+      return std::unexpected(re::error(Error::DeviceOpening, std::string(SDL_GetError())));
+    }
+
+    // Devices are opened paused
+    Audio audio{stream, std::move(mixer)};
+    if (!SDL_ResumeAudioStreamDevice(stream)) [[unlikely]]
+      return std::unexpected(re::error(Error::DeviceResume, std::string(SDL_GetError())));
+
+    return audio;
+  }
+
+  /* Member functions */
+  // Sounds are converted to mono f32 and kept until the Audio is destroyed
+  [[nodiscard]] std::expected<SoundId, re::Error<Error>> load_wav(const std::string& path);
+  [[nodiscard]] std::expected<SoundId, re::Error<Error>> add_sound(std::vector<f32>&& samples, u32 sample_rate);
+
+  // Never blocks, commands are picked up by the next audio callback
+  [[nodiscard]] std::expected<VoiceId, re::Error<Error>> play(SoundId sound) noexcept;
+  [[nodiscard]] std::expected<VoiceId, re::Error<Error>> play(SoundId sound, const PlayParameters& parameters) noexcept;
+  re::expected<re::Error<Error>> stop(VoiceId voice) noexcept;
+  re::expected<re::Error<Error>> set_gain(VoiceId voice, f32 gain, f32 pan = 0.0f) noexcept;
+  re::expected<re::Error<Error>> stop_all() noexcept;
+
+  [[nodiscard]] const AudioMixer& mixer() const noexcept { return *_mixer; }
+
+ private:
+  static void callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount);
+  re::expected<re::Error<Error>> push(const AudioMixer::Command& command) noexcept;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <unders_helpers/spsc_queue.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// Real-time sample mixer fed by the game thread through a lock-free command queue
+// mix() is called from the audio callback: it never locks nor allocates
+// Output is interleaved stereo f32, voices are mono sounds resampled (linear) and panned
+class AudioMixer {
+ public:
+  /* Settings */
+  static constexpr usize MAX_VOICES = 256;
+  static constexpr usize COMMAND_CAPACITY = 1024; // Power of two
+  static constexpr usize COMMAND_BATCH = 64;       // Commands popped at once by mix()
+
+  /* Types */
+  using VoiceId = u32;
+
+  struct Command {
+    enum class Type : u8 {
+      Play,
+      Stop,
+      SetGain,
+      StopAll
+    };
+
+    Type type = Type::Stop;
+    bool loop = false;
+    VoiceId voice = 0;
+    const f32* samples = nullptr; // Mono, must outlive the voice
+    u32 length = 0;               // In samples
+    f32 step = 1.0f;              // Source samples per output frame (rate ratio * pitch)
+    f32 gain_left = 0.0f;
+    f32 gain_right = 0.0f;
+  };
+
+ private:
+  struct Voice {
+    VoiceId id = 0;
+    const f32* samples = nullptr;
+    u32 length = 0;
+    f64 position = 0.0;
+    f32 step = 1.0f;
+    f32 gain_left = 0.0f;
+    f32 gain_right = 0.0f;
+    bool loop = false;
+    bool active = false;
+  };
+
+  /* Members */
+  u32 _sample_rate;
+  usize _max_frames;
+  uh::spsc_queue<Command, COMMAND_CAPACITY> _commands; // Game thread -> audio callback
+  std::array<Voice, MAX_VOICES> _voices{};
+  std::vector<f32> _resampled; // Mono scratch buffer (max_frames)
+  std::vector<f32> _output;    // Interleaved stereo (max_frames * 2)
+  std::atomic<u32> _active_voices{0};
+  std::atomic<u64> _dropped_voices{0};
+
+ public:
+  /* Constructor */
+  // max_frames is the largest chunk mix() produces at once, buffers are allocated here and never again
+  AudioMixer(u32 sample_rate, usize max_frames)
+      : _sample_rate(sample_rate), _max_frames(max_frames), _resampled(max_frames), _output(max_frames * 2) {}
+
+  // Shared with the audio thread through a pointer, must not move
+  AudioMixer(const AudioMixer&) = delete;
+  AudioMixer& operator=(const AudioMixer&) = delete;
+
+  /* Game thread */
+  // Returns false if the queue is full
+  [[nodiscard]] bool push(const Command& command) noexcept { return _commands.try_push(command); }
+  [[nodiscard]] u32 sample_rate() const noexcept { return _sample_rate; }
+  [[nodiscard]] usize max_frames() const noexcept { return _max_frames; }
+  [[nodiscard]] u32 active_voices() const noexcept { return _active_voices.load(std::memory_order_relaxed); }
+  // Play commands ignored because every voice was busy
+  [[nodiscard]] u64 dropped_voices() const noexcept { return _dropped_voices.load(std::memory_order_relaxed); }
+
+  /* Audio thread */
+  // Applies pending commands then mixes frames (<= max_frames), the result stays valid until the next call
+  const f32* mix(usize frames) noexcept;
+
+ private:
+  void apply(const Command& command) noexcept;
+  // Fills _resampled with the next frames of a voice, returns false once the voice ended
+  bool resample(Voice& voice, usize frames) noexcept;
+  void accumulate(const Voice& voice, usize frames) noexcept;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// 2D collision broad-phase (sort and sweep on the x axis)
+// Bodies are identified by a dense id in [0, size()) and their AABB is updated every tick with set_bounds()
+// The x order is kept between ticks, bodies moving a little leave it nearly sorted so the insertion sort stays close to O(n)
+// Only the first update after resize() (new ids appended unsorted, or a whole new set of bounds) pays a full sort
+// The sweep tests several candidates at once over SoA bounds arrays (AVX/SSE2 when available)
+class BroadPhase {
+ public:
+  /* Types */
+  using Id = u32;
+
+  struct Pair {
+    Id a;
+    Id b;
+  };
+
+ private:
+  /* Members */
+  // Bounds indexed by id
+  std::vector<f32> _min_x, _max_x, _min_y, _max_y;
+
+  // Ids sorted by min_x
+  std::vector<Id> _order;
+  // Set by resize(), the previous order tells nothing about the new bounds
+  bool _full_sort = true;
+  // Bounds copied in sort order so the sweep reads contiguous memory
+  std::vector<f32> _sorted_min_x, _sorted_max_x, _sorted_min_y, _sorted_max_y;
+
+  // Candidate pairs of the last update, reused between ticks
+  std::vector<Pair> _pairs;
+
+ public:
+  /* Member functions */
+  // Sets the number of bodies, new bodies have empty bounds at the origin until set
+  void resize(usize count);
+  [[nodiscard]] usize size() const noexcept { return _min_x.size(); }
+
+  void set_bounds(Id id, glm::vec2 min, glm::vec2 max) noexcept {
+    _min_x[id] = min.x;
+    _max_x[id] = max.x;
+    _min_y[id] = min.y;
+    _max_y[id] = max.y;
+  }
+
+  // Sorts, sweeps and returns every pair of overlapping AABB (each pair once, in no particular order)
+  // The returned buffer is overwritten by the next update
+  const std::vector<Pair>& update();
+
+  [[nodiscard]] const std::vector<Pair>& pairs() const noexcept { return _pairs; }
+
+ private:
+  void sort();
+  void sweep();
+};
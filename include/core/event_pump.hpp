@@ -0,0 +1,129 @@
+#pragma once
+
+#include <SDL3/SDL_events.h>
+#include <SDL3/SDL_scancode.h>
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <span>
+#include <unders_helpers/types.hpp>
+#include <utility>
+#include <vector>
+
+// Input of one frame, built by EventPump::pump() then never modified
+// Safe to read from any thread without locking while it is pinned by an EventPump::Snapshot
+struct InputState {
+  u64 frame = 0;
+
+  /* Keyboard (by scancode) */
+  std::bitset<SDL_SCANCODE_COUNT> held;
+  std::bitset<SDL_SCANCODE_COUNT> pressed;  // Went down this frame (repeats excluded)
+  std::bitset<SDL_SCANCODE_COUNT> released; // Went up this frame
+
+  /* Mouse */
+  f32 mouse_x = 0.0f, mouse_y = 0.0f;             // Last position, in window coordinates
+  f32 mouse_delta_x = 0.0f, mouse_delta_y = 0.0f; // Sum of the motions of the frame
+  f32 wheel_x = 0.0f, wheel_y = 0.0f;             // Sum of the scrolls of the frame
+  u32 mouse_buttons = 0;                          // Bit (button - 1) is set while held
+
+  [[nodiscard]] bool is_held(SDL_Scancode scancode) const noexcept { return held.test(scancode); }
+  [[nodiscard]] bool was_pressed(SDL_Scancode scancode) const noexcept { return pressed.test(scancode); }
+  [[nodiscard]] bool was_released(SDL_Scancode scancode) const noexcept { return released.test(scancode); }
+  [[nodiscard]] bool is_mouse_held(u8 button) const noexcept { return (mouse_buttons >> (button - 1)) & 1; }
+};
+
+// Drains the SDL event queue in batches (SDL_PeepEvents) into a buffer allocated once
+// Consecutive motion events of the same source are merged (last position, summed deltas): high rate mice and touch
+// screens send hundreds per frame, callbacks receive at most one per run of motion
+// Each pump also builds the frame's InputState in a slot of its own. Other threads read it through a Snapshot, which
+// pins the slot: pump() never rewrites a pinned slot and takes another one, so a worker may keep a state across any
+// number of pumps. Only when every slot is pinned does the pump allocate a new one
+class EventPump {
+ public:
+  /* Settings */
+  static constexpr usize CAPACITY = 1024; // Events kept per frame after merging, the rest waits for the next frame
+  static constexpr usize BATCH = 128;     // Events drained per SDL_PeepEvents call
+  static constexpr usize STATE_SLOTS = 4; // Allocated up front: the published state and 3 pinned by workers
+
+ private:
+  /* Types */
+  struct Slot {
+    InputState state;
+    mutable std::atomic<u32> readers = 0; // Live snapshots
+  };
+
+ public:
+  // Shared ownership of a published InputState, read-only and unchanged for as long as the snapshot lives
+  class Snapshot {
+   private:
+    const Slot* _slot = nullptr;
+
+   public:
+    /* Constructors */
+    Snapshot() = default;
+    explicit Snapshot(const Slot* slot) noexcept : _slot(slot) {}
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    Snapshot(Snapshot&& other) noexcept : _slot(std::exchange(other._slot, nullptr)) {}
+    Snapshot& operator=(Snapshot&& other) noexcept {
+      if (this != &other) {
+        release();
+        _slot = std::exchange(other._slot, nullptr);
+      }
+      return *this;
+    }
+    ~Snapshot() { release(); }
+
+    /* Getters */
+    [[nodiscard]] const InputState& operator*() const noexcept { return _slot->state; }
+    [[nodiscard]] const InputState* operator->() const noexcept { return &_slot->state; }
+    [[nodiscard]] explicit operator bool() const noexcept { return _slot != nullptr; }
+
+   private:
+    // Reads of the state happen before the pump rewrites the slot
+    void release() noexcept {
+      if (_slot != nullptr)
+        _slot->readers.fetch_sub(1, std::memory_order_release);
+      _slot = nullptr;
+    }
+  };
+
+ private:
+  /* Members */
+  std::vector<SDL_Event> _events;           // CAPACITY, allocated once
+  std::vector<std::unique_ptr<Slot>> _slots; // STATE_SLOTS, only grows when every slot is pinned
+  std::atomic<Slot*> _current;
+  usize _count = 0;
+  usize _received = 0; // Before merging
+  u64 _frame = 0;
+
+ public:
+  /* Constructor */
+  EventPump();
+
+  // Other threads hold pointers to the slots, must not move (Application keeps it behind a pointer)
+  EventPump(const EventPump&) = delete;
+  EventPump& operator=(const EventPump&) = delete;
+
+  /* Member functions */
+  // Drains pending events, returns them merged and in order, valid until the next pump()
+  std::span<const SDL_Event> pump() noexcept;
+  // State published by the last pump(), pinned until the snapshot is destroyed. Callable from any thread
+  [[nodiscard]] Snapshot snapshot() const noexcept;
+
+  /* Getters */
+  // State published by the last pump(), for the thread calling pump() only: valid until the next pump()
+  [[nodiscard]] const InputState& state() const noexcept { return _current.load(std::memory_order_relaxed)->state; }
+  // Events drained by the last pump(), before and after merging
+  [[nodiscard]] usize received() const noexcept { return _received; }
+  [[nodiscard]] usize delivered() const noexcept { return _count; }
+  // Slots allocated so far, STATE_SLOTS unless workers kept more snapshots alive at once
+  [[nodiscard]] usize slots() const noexcept { return _slots.size(); }
+
+ private:
+  // Merges event into the previous one when both are motions of the same source
+  [[nodiscard]] static bool merge(SDL_Event& previous, const SDL_Event& event) noexcept;
+  static void apply(InputState& state, const SDL_Event& event) noexcept;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <glm/vec2.hpp>
+#include <memory>
+#include <span>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+#include "core/navigation_grid.hpp"
+
+// Paths from every cell of a NavigationGrid to one target cell, shared by any number of agents
+// - Integration field: cost of the cheapest path to the target (8 neighbors, diagonals cost 7/5 of a straight step and
+//   can't cut wall corners), computed with a label-correcting wavefront over the grid tiles. Tiles are solved in parallel
+//   (a local Dijkstra seeded from their borders), a tile whose border improved wakes its neighbors up until nothing changes
+// - Flow field: for each cell, the direction of its cheapest neighbor
+// When a few costs change, update() only resets the cells whose path went through a more expensive cell and re-runs the
+// wavefront from the tiles around the changes
+// The wavefront and update() buffers are kept with the field: once built, compute(), update() and retarget() (on a grid of
+// the same size) don't allocate
+class FlowField {
+ public:
+  /* Settings */
+  static constexpr u32 UNREACHABLE = ~u32{0};
+  static constexpr u32 STRAIGHT_WEIGHT = 5;
+  static constexpr u32 DIAGONAL_WEIGHT = 7;
+  static constexpr usize MAX_WORKERS = 8; // Threads shared by every field (the caller included), started with the first one
+
+  // Directions 0 to 7 go clockwise from +x (y down), then:
+  static constexpr u8 DIRECTION_TARGET = 8;
+  static constexpr u8 DIRECTION_NONE = 9; // Walls and unreachable cells
+
+  struct Step {
+    i32 dx;
+    i32 dy;
+    u32 weight;
+  };
+  static constexpr std::array<Step, 8> STEPS{{
+      {1, 0, STRAIGHT_WEIGHT},
+      {1, 1, DIAGONAL_WEIGHT},
+      {0, 1, STRAIGHT_WEIGHT},
+      {-1, 1, DIAGONAL_WEIGHT},
+      {-1, 0, STRAIGHT_WEIGHT},
+      {-1, -1, DIAGONAL_WEIGHT},
+      {0, -1, STRAIGHT_WEIGHT},
+      {1, -1, DIAGONAL_WEIGHT},
+  }};
+
+ private:
+  struct Scratch;
+
+  /* Members */
+  u32 _target;
+  std::unique_ptr<std::atomic<u32>[]> _integration; // Written by the wavefront workers
+  std::vector<u8> _directions;
+  std::unique_ptr<Scratch> _scratch;
+
+ public:
+  /* Constructors */
+  // Field without a target (every cell unreachable), to be given one with retarget()
+  explicit FlowField(const NavigationGrid& grid);
+  // Computes the field right away
+  FlowField(const NavigationGrid& grid, u32 target);
+
+  /* Special constructors */
+  // No copy, no move (handed out by address, see FlowFieldCache)
+  FlowField(const FlowField&) = delete;
+  FlowField& operator=(const FlowField&) = delete;
+
+  /* Destructor */
+  ~FlowField();
+
+  /* Member functions */
+  // Points the field at another target and recomputes it, reusing its buffers
+  void retarget(const NavigationGrid& grid, u32 target);
+  // Recomputes the whole field
+  void compute(const NavigationGrid& grid);
+  // Brings the field up to date with the costs changed since it was computed (grid.changes())
+  void update(const NavigationGrid& grid, std::span<const NavigationGrid::Change> changes);
+
+  /* Getters */
+  [[nodiscard]] u32 target() const noexcept { return _target; }
+  [[nodiscard]] u32 integration(u32 cell) const noexcept { return _integration[cell].load(std::memory_order_relaxed); }
+  [[nodiscard]] bool is_reachable(u32 cell) const noexcept { return integration(cell) != UNREACHABLE; }
+  [[nodiscard]] u8 direction_index(u32 cell) const noexcept { return _directions[cell]; }
+
+  // Unit direction to follow from cell, zero on the target and where there is no path
+  [[nodiscard]] glm::vec2 direction(u32 cell) const noexcept;
+  // Same from a world position, zero outside the grid
+  [[nodiscard]] glm::vec2 direction_at(const NavigationGrid& grid, glm::vec2 position) const noexcept {
+    const u32 cell = grid.cell_at(position);
+    return cell != NavigationGrid::NONE ? direction(cell) : glm::vec2(0.0f);
+  }
+
+ private:
+  // Runs the wavefront from the tiles listed in _scratch until no tile changes, then recomputes the directions of every
+  // solved tile and of its neighbors
+  void propagate(const NavigationGrid& grid);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unders_helpers/types.hpp>
+
+#include "core/flow_field.hpp"
+#include "core/navigation_grid.hpp"
+
+// Flow fields of one NavigationGrid by target cell, every agent heading to the same cell shares one field
+// Up to MAX_FIELDS are kept, the least recently used one is retargeted to make room
+// After reserve() (or once MAX_FIELDS fields were built) new targets reuse the fields' buffers and never allocate
+class FlowFieldCache {
+ public:
+  /* Settings */
+  static constexpr usize MAX_FIELDS = 8;
+
+ private:
+  struct Entry {
+    std::unique_ptr<FlowField> field; // Stable address, handed out to callers. Kept when the entry is unused
+    u64 last_use = 0;
+    bool used = false;
+  };
+
+  /* Members */
+  std::array<Entry, MAX_FIELDS> _entries; // Few enough for a linear search
+  u64 _uses = 0;
+
+ public:
+  /* Member functions */
+  // Builds the MAX_FIELDS fields up front, so the first requests of new targets don't allocate either
+  void reserve(const NavigationGrid& grid);
+  // Field towards target, computed on the first request. Stays valid until evicted or the cache is cleared
+  [[nodiscard]] const FlowField& get(const NavigationGrid& grid, u32 target);
+  // Applies the grid changes to every cached field, then clears them from the grid. Call once per frame
+  void update(NavigationGrid& grid);
+  // Forgets every target, the fields are kept for reuse
+  void clear() noexcept;
+
+  /* Getters */
+  [[nodiscard]] usize size() const noexcept;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+
+#include <array>
+#include <atomic>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <rerror/error.hpp>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// Asynchronous frame capture
+// The render thread reads frames back into a ring of preallocated RGBA buffers, a background thread encodes and writes them
+// When every buffer is still waiting to be written the frame is dropped, the render thread never waits on the writer
+class FrameCapture {
+ public:
+  /* Types */
+  enum class Error {
+    DirectoryCreation,
+    ThreadCreation
+  };
+
+  enum class Format {
+    Raw, // One .rgba file per frame
+    Png, // One .png file per frame (uncompressed deflate, encoding stays cheap)
+    Y4m  // A single YUV 4:4:4 stream per resolution
+  };
+
+  struct Settings {
+    Format format = Format::Png;
+    std::string directory = "capture/"; // With a trailing separator
+    u32 width = 0;                      // Expected frame size, used to preallocate buffers
+    u32 height = 0;
+    u32 frame_rate = 60; // Y4M header only
+  };
+
+  static constexpr usize RING_SIZE = 4;
+
+ private:
+  enum class SlotState : u8 {
+    Free,  // Owned by the render thread
+    Ready, // Owned by the writer thread
+  };
+
+  struct Slot {
+    std::vector<u8> pixels; // RGBA32
+    u32 width = 0;
+    u32 height = 0;
+    u64 frame = 0;
+    std::atomic<SlotState> state{SlotState::Free};
+  };
+
+  /* Members */
+  Settings _settings;
+  std::array<Slot, RING_SIZE> _slots;
+  usize _write_index = 0; // Render thread
+  u64 _frame = 0;         // Render thread
+  std::counting_semaphore<RING_SIZE + 1> _ready_slots{0}; // One release per ready slot, plus one to stop the writer
+  std::atomic<u64> _written_frames{0};
+  std::atomic<u64> _dropped_frames{0};
+  std::atomic<u64> _failed_frames{0};
+  std::thread _writer;
+
+  /* Constructor (Private, use functional constructors instead) */
+  explicit FrameCapture(Settings&& settings);
+
+ public:
+  /* Special constructors */
+  // Shared with the writer thread, neither copyable nor moveable
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  /* Destructor */
+  // Writes the frames already captured then stops the writer
+  ~FrameCapture();
+
+  /* Functional constructors */
+  [[nodiscard]]
+  static std::expected<std::unique_ptr<FrameCapture>, re::Error<Error>> create(Settings settings);
+
+  // Reads SDL_TEST_CAPTURE (raw, png or y4m) and SDL_TEST_CAPTURE_DIR, nothing when capture isn't requested
+  [[nodiscard]]
+  static std::optional<Settings> settings_from_environment();
+
+  /* Member functions */
+  // Render thread, before presenting: reads the current render target back
+  void capture(SDL_Renderer* renderer) noexcept;
+
+  [[nodiscard]] u64 written_frames() const noexcept { return _written_frames.load(std::memory_order_relaxed); }
+  [[nodiscard]] u64 dropped_frames() const noexcept { return _dropped_frames.load(std::memory_order_relaxed); }
+  [[nodiscard]] u64 failed_frames() const noexcept { return _failed_frames.load(std::memory_order_relaxed); }
+
+ private:
+  void write_loop();
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <expected>
+#include <glm/vec2.hpp>
+#include <rerror/error.hpp>
+#include <span>
+#include <unders_helpers/dynamic_bitset.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// Grid flow fields are computed on (see FlowField), each cell has a cost to enter it: 1 is the cheapest, WALL can't be entered
+// Cost changes are recorded so cached fields can be updated around them instead of recomputed (see FlowFieldCache)
+// The grid is split in TILE_SIZE square tiles, the unit of work of the parallel wavefront
+class NavigationGrid {
+ public:
+  /* Settings */
+  static constexpr u8 WALL = 255;
+  static constexpr u32 TILE_SIZE = 16;    // In cells
+  static constexpr u32 MAX_TILES = 4096; // Up to 1024x1024 cells
+  static constexpr u32 NONE = ~u32{0};
+
+  /* Types */
+  enum class Error {
+    InvalidSize,
+    TooLarge
+  };
+
+  struct Change {
+    u32 cell;
+    u8 old_cost; // Cost before the first change since the last clear_changes()
+  };
+
+ private:
+  /* Members */
+  u32 _width;
+  u32 _height;
+  f32 _cell_size; // In world units
+  std::vector<u8> _costs;
+  std::vector<Change> _changes;
+  uh::dynamic_bitset _changed; // Cells in _changes
+
+  /* Constructor */
+  NavigationGrid(u32 width, u32 height, f32 cell_size, u8 cost)
+      : _width(width), _height(height), _cell_size(cell_size), _costs(width * height, cost), _changed(width * height) {
+    _changes.reserve(width * height); // Each cell is listed once, so recording changes never allocates
+  }
+
+ public:
+  /* Functional constructor */
+  [[nodiscard]] static std::expected<NavigationGrid, re::Error<Error>> create(u32 width, u32 height, f32 cell_size, u8 cost = 1);
+
+  /* Getters */
+  [[nodiscard]] u32 width() const noexcept { return _width; }
+  [[nodiscard]] u32 height() const noexcept { return _height; }
+  [[nodiscard]] u32 cell_count() const noexcept { return _width * _height; }
+  [[nodiscard]] f32 cell_size() const noexcept { return _cell_size; }
+  [[nodiscard]] u32 tiles_x() const noexcept { return (_width + TILE_SIZE - 1) / TILE_SIZE; }
+  [[nodiscard]] u32 tiles_y() const noexcept { return (_height + TILE_SIZE - 1) / TILE_SIZE; }
+  [[nodiscard]] u32 tile_count() const noexcept { return tiles_x() * tiles_y(); }
+
+  [[nodiscard]] u32 cell(u32 x, u32 y) const noexcept { return y * _width + x; }
+  [[nodiscard]] u32 tile_of(u32 cell) const noexcept { return (cell / _width / TILE_SIZE) * tiles_x() + (cell % _width) / TILE_SIZE; }
+  // NONE outside the grid
+  [[nodiscard]] u32 cell_at(glm::vec2 position) const noexcept {
+    if (position.x < 0.0f || position.y < 0.0f)
+      return NONE;
+    const u32 x = static_cast<u32>(position.x / _cell_size), y = static_cast<u32>(position.y / _cell_size);
+    return x < _width && y < _height ? cell(x, y) : NONE;
+  }
+  [[nodiscard]] glm::vec2 cell_center(u32 cell) const noexcept {
+    return {(static_cast<f32>(cell % _width) + 0.5f) * _cell_size, (static_cast<f32>(cell / _width) + 0.5f) * _cell_size};
+  }
+
+  [[nodiscard]] u8 cost(u32 cell) const noexcept { return _costs[cell]; }
+  [[nodiscard]] bool is_walkable(u32 cell) const noexcept { return _costs[cell] != WALL; }
+  [[nodiscard]] std::span<const u8> costs() const noexcept { return _costs; }
+
+  /* Setters */
+  void set_cost(u32 cell, u8 cost);
+  // Clipped to the grid
+  void fill_rect(u32 x, u32 y, u32 width, u32 height, u8 cost);
+
+  /* Changes */
+  [[nodiscard]] std::span<const Change> changes() const noexcept { return _changes; }
+  void clear_changes() noexcept {
+    for (const Change& change : _changes)
+      _changed.reset(change.cell);
+    _changes.clear();
+  }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_scancode.h>
+
+#include <array>
+#include <unders_helpers/types.hpp>
+
+#include "core/allocation_tracker.hpp"
+
+// On-screen frame statistics, toggled with TOGGLE_KEY
+// Shows a rolling graph of the last HISTORY frames (phases stacked, frame time on top) and the numbers of the last one
+// Drawn straight to the window after the game (above any dynamic resolution upscale) with one SDL_RenderGeometry call for
+// the bars, one SDL_RenderLines call for the frame time and SDL_RenderDebugText for the numbers, never allocates
+class PerformanceOverlay {
+ public:
+  using Phase = AllocationTracker::Phase;
+
+  /* Settings */
+  static constexpr SDL_Scancode TOGGLE_KEY = SDL_SCANCODE_F3;
+  static constexpr usize HISTORY = 200;
+  static constexpr f32 GRAPH_RANGE = 1000.0f / 30.0f; // In ms, top of the graph
+  static constexpr f32 BAR_WIDTH = 2.0f;
+  static constexpr f32 GRAPH_WIDTH = HISTORY * BAR_WIDTH;
+  static constexpr f32 GRAPH_HEIGHT = 80.0f;
+  static constexpr f32 MARGIN = 8.0f;
+  static constexpr f32 LINE_HEIGHT = 12.0f; // Debug text characters are 8x8
+  static constexpr usize TEXT_LINES = 3;
+  static constexpr f32 COST_BUDGET = 0.1f; // In ms, the overlay's own cost is shown in red above it
+
+  /* Types */
+  struct FrameStats {
+    f32 frame_time = 0.0f;                                    // In ms, whole frame
+    std::array<f32, AllocationTracker::phase_count> phases{}; // In ms, Setup is unused
+    u32 events = 0;
+    u64 allocations = 0; // Only counted when AllocationTracker is enabled
+  };
+
+ private:
+  static constexpr usize BAR_PHASES = 4; // Input, Update, Draw, Present
+
+  /* Members */
+  bool _visible = false;
+  std::array<FrameStats, HISTORY> _history{};
+  usize _next = 0;  // Ring index of the next frame
+  usize _count = 0; // Recorded frames, up to HISTORY
+  f32 _cost = 0.0f; // In ms, last draw() of the overlay itself, up to SDL having executed its commands (see draw())
+
+  // Scratch geometry, rebuilt each draw()
+  std::array<SDL_Vertex, HISTORY * BAR_PHASES * 4> _vertices{};
+  std::array<int, HISTORY * BAR_PHASES * 6> _indices{};
+  std::array<SDL_FPoint, HISTORY> _line{};
+
+ public:
+  /* Member functions */
+  void toggle() noexcept { _visible = !_visible; }
+  [[nodiscard]] bool visible() const noexcept { return _visible; }
+
+  // Called once per frame, visible or not, so the graph is already filled when toggled on
+  void record(const FrameStats& stats) noexcept;
+
+  void draw(SDL_Renderer* renderer) noexcept;
+
+ private:
+  [[nodiscard]] const FrameStats& frame(usize age) const noexcept { return _history[(_next + HISTORY - 1 - age) % HISTORY]; }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <expected>
+#include <optional>
+#include <rerror/error.hpp>
+#include <string>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+#include "core/software_rasterizer.hpp"
+
+// Picks the fastest render driver of the machine
+// Every available driver draws the same offscreen scene (batched rects and blended sprites), the one with the lowest
+// frame time wins. The choice is cached in the preference directory so only the first launch pays for the probe,
+// the cache is keyed by the SDL version, video driver and render driver list so it is redone when any of them changes
+class RenderDriverBenchmark {
+ public:
+  /* Settings */
+  static constexpr u32 TARGET_SIZE = 512;
+  static constexpr u32 RECT_COUNT = 4096;
+  static constexpr u32 SPRITE_COUNT = 1024;
+  static constexpr u32 SPRITE_SIZE = 32;
+  static constexpr u32 WARMUP_FRAMES = 4;
+  static constexpr u32 MEASURED_FRAMES = 24;
+  static constexpr const char* CACHE_FILE = "render_driver.cache";
+
+  /* Types */
+  enum class Error {
+    NoDriver
+  };
+
+  struct Result {
+    std::string driver;
+    f64 frame_time; // In seconds, averaged over MEASURED_FRAMES
+  };
+
+  /* Functions */
+  // Cached driver name, or the fastest driver (then cached)
+  [[nodiscard]] static std::expected<std::string, re::Error<Error>> select();
+
+  // Runs the benchmark on every available driver, drivers failing to initialize are skipped
+  [[nodiscard]] static std::vector<Result> run();
+  // Runs the benchmark on one driver, nothing if it can't be used
+  [[nodiscard]] static std::optional<f64> measure(const char* driver);
+  // Same scene drawn by a SoftwareRasterizer then copied to the target of the SDL software renderer
+  [[nodiscard]] static std::optional<f64> measure_rasterizer(SoftwareRasterizer::Settings settings);
+
+  // Forgets the cached choice (e.g. when the cached driver stopped working)
+  static void invalidate();
+
+ private:
+  [[nodiscard]] static std::string cache_path();
+  [[nodiscard]] static std::string cache_key();
+};
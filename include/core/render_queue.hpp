@@ -0,0 +1,117 @@
+#pragma once
+
+#include <SDL3/SDL_blendmode.h>
+#include <SDL3/SDL_pixels.h>
+#include <SDL3/SDL_rect.h>
+#include <SDL3/SDL_render.h>
+
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+class SoftwareRasterizer;
+
+// Deferred draw commands, sorted by a 64-bit key before being sent to SDL
+// Sorting groups commands sharing the same state so blend mode, draw color and texture changes are only made when needed
+// Commands with equal keys keep their submission order
+class RenderQueue {
+ public:
+  /* Types */
+  enum class BlendMode : u8 {
+    None,
+    Blend,
+    Add,
+    Mod,
+    Mul
+  };
+
+  enum class Type : u8 {
+    FillRect,
+    Rect,
+    Line,
+    Texture
+  };
+
+  // Sort key layout (most significant first):
+  // | layer (8) | blend mode (3) | texture (21) | depth (32) |
+  // Layers are drawn in increasing order, depth only orders commands sharing the same state inside a layer
+  struct SortKey {
+    static constexpr u32 LAYER_SHIFT = 56;
+    static constexpr u32 BLEND_SHIFT = 53;
+    static constexpr u32 TEXTURE_SHIFT = 32;
+    static constexpr u64 TEXTURE_MASK = (u64{1} << 21) - 1;
+
+    [[nodiscard]]
+    static constexpr u64 make(u8 layer, BlendMode blend, u32 texture, u32 depth) noexcept {
+      return (u64{layer} << LAYER_SHIFT) |
+             (u64{static_cast<u8>(blend)} << BLEND_SHIFT) |
+             ((u64{texture} & TEXTURE_MASK) << TEXTURE_SHIFT) |
+             u64{depth};
+    }
+  };
+
+  struct Command {
+    Type type;
+    BlendMode blend;
+    SDL_Color color;              // Draw color, or color/alpha modulation for textures
+    SDL_Texture* texture;         // Texture only
+    SDL_FRect source;             // Texture only, empty means the whole texture
+    SDL_FRect destination;        // Line: {x1, y1, x2, y2}
+    f32 angle = 0.0f;             // Texture only, in degrees clockwise around the destination center
+  };
+
+  // Counters of the last flush
+  struct Stats {
+    usize commands = 0;
+    usize draw_calls = 0;
+    usize state_changes = 0;
+  };
+
+ private:
+  struct Entry {
+    u64 key;
+    u32 index;
+  };
+
+  /* Members */
+  std::vector<Command> _commands;
+  std::vector<Entry> _entries;
+  std::vector<Entry> _scratch;          // Radix sort ping-pong buffer
+  std::vector<SDL_Texture*> _textures;  // Texture ids of the current frame
+  std::vector<SDL_FRect> _rect_batch;   // Merged (Fill)Rect commands
+  Stats _stats{};
+
+ public:
+  /* Member functions */
+  void submit(u64 key, const Command& command);
+
+  // Helpers building the sort key and command
+  void fill_rect(const SDL_FRect& rect, SDL_Color color, u8 layer = 0, u32 depth = 0, BlendMode blend = BlendMode::None);
+  void rect(const SDL_FRect& rect, SDL_Color color, u8 layer = 0, u32 depth = 0, BlendMode blend = BlendMode::None);
+  void line(f32 x1, f32 y1, f32 x2, f32 y2, SDL_Color color, u8 layer = 0, u32 depth = 0, BlendMode blend = BlendMode::None);
+  void texture(SDL_Texture* texture, const SDL_FRect* source, const SDL_FRect& destination, u8 layer = 0, u32 depth = 0,
+               BlendMode blend = BlendMode::Blend, SDL_Color modulation = {255, 255, 255, 255});
+  void texture_rotated(SDL_Texture* texture, const SDL_FRect* source, const SDL_FRect& destination, f32 angle, u8 layer = 0, u32 depth = 0,
+                       BlendMode blend = BlendMode::Blend, SDL_Color modulation = {255, 255, 255, 255});
+
+  // Returns the id of a texture for this frame (used in sort keys)
+  [[nodiscard]] u32 texture_id(SDL_Texture* texture);
+
+  // Sorts and sends all commands to the renderer, then empties the queue (keeping its memory)
+  void flush(SDL_Renderer* renderer);
+  // Same, drawn by the CPU
+  void flush(SoftwareRasterizer& rasterizer);
+  void clear() noexcept;
+  // Sorts the commands into drawing order without flushing them, then calls visit(key, command) on each
+  template <typename TVisitor>
+  void visit_sorted(TVisitor&& visit) {
+    sort();
+    for (const Entry& entry : _entries)
+      visit(entry.key, _commands[entry.index]);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return _commands.empty(); }
+  [[nodiscard]] const Stats& stats() const noexcept { return _stats; }
+
+ private:
+  void sort();
+};
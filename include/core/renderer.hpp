@@ -3,28 +3,74 @@
 #include <SDL3/SDL_error.h>
 #include <SDL3/SDL_render.h>
 
+#include <chrono>
 #include <expected>
+#include <memory>
+#include <optional>
 #include <rerror/error.hpp>
 #include <string>
+#include <unders_helpers/object_pool.hpp>
 
+#include "core/frame_capture.hpp"
+#include "core/render_driver_benchmark.hpp"
+#include "core/render_queue.hpp"
+#include "core/resolution_controller.hpp"
+#include "core/software_rasterizer.hpp"
 #include "core/window.hpp"
 
 class Renderer {
+ public:
+  using TextureHandle = uh::handle<SDL_Texture*>;
+
  protected:
   SDL_Renderer* _renderer;
+  mutable RenderQueue _queue; // Filled during draw(), flushed on present()
+  std::unique_ptr<FrameCapture> _capture; // Optional, reads frames back before presenting
+
+  // Dynamic resolution (optional), frames are drawn at scale into the top-left of an output sized target then upscaled
+  // The target only changes with the output size, changing the scale doesn't reallocate anything
+  // The guard textures carry the last drawn column and row into the texel past them (see resolve())
+  std::optional<ResolutionController> _resolution;
+  SDL_Texture* _target = nullptr;
+  SDL_Texture* _guard_column = nullptr; // 1 x output height
+  SDL_Texture* _guard_row = nullptr;    // Output width x 1
+  std::chrono::steady_clock::time_point _frame_start;
+
+  // Software rasterizer (optional), the queue is drawn by the CPU then copied to the window in one texture
+  std::unique_ptr<SoftwareRasterizer> _software;
+  bool _software_resolved = false;
+
+  // Textures owned by the renderer, handed out as handles so a destroyed texture can't be drawn by mistake
+  uh::object_pool<SDL_Texture*, u32, 64> _textures;
 
   /* Constructor (Protected, use functional constructors instead) */
   Renderer(SDL_Renderer* renderer) : _renderer(renderer) {};
 
+  // Destroys every SDL resource owned (textures before the renderer they belong to), used by the destructor and move assignment
+  void destroy() noexcept {
+    _software.reset(); // Its streaming texture belongs to _renderer
+    _textures.for_each([](TextureHandle, SDL_Texture* texture) { SDL_DestroyTexture(texture); });
+    _textures.clear();
+    destroy_target();
+    if (_renderer != nullptr)
+      SDL_DestroyRenderer(_renderer);
+    _renderer = nullptr;
+  }
+
  public:
   /* Errors */
   enum class Error {
     Creation,
-    UnknownDriver
+    UnknownDriver,
+    CaptureStart,
+    TargetCreation,
+    TextureCreation,
+    SoftwareRasterizer
   };
 
   enum class Driver {
-    Default,
+    Default, // Whatever SDL picks
+    Auto,    // Fastest driver of the machine, benchmarked at first launch then cached (see RenderDriverBenchmark)
     Direct3d,
     Direct3d11,
     Direct3d12,
@@ -44,24 +90,42 @@ class Renderer {
 
   // Moveable
   Renderer(Renderer&& other) noexcept
-      : _renderer(other._renderer) {
+      : _renderer(other._renderer), _queue(std::move(other._queue)), _capture(std::move(other._capture)),
+        _resolution(std::move(other._resolution)), _target(other._target), _guard_column(other._guard_column), _guard_row(other._guard_row), _frame_start(other._frame_start),
+        _software(std::move(other._software)), _software_resolved(other._software_resolved), _textures(std::move(other._textures)) {
     other._renderer = nullptr;
+    other._target = other._guard_column = other._guard_row = nullptr;
   }
   Renderer& operator=(Renderer&& other) noexcept {
+    if (this == &other)
+      return *this;
+
+    destroy(); // Owned textures and renderer first, they would leak otherwise
     _renderer = other._renderer;
+    _queue = std::move(other._queue);
+    _capture = std::move(other._capture);
+    _resolution = std::move(other._resolution);
+    _target = other._target;
+    _guard_column = other._guard_column;
+    _guard_row = other._guard_row;
+    _frame_start = other._frame_start;
+    _software = std::move(other._software);
+    _software_resolved = other._software_resolved;
+    _textures = std::move(other._textures);
     other._renderer = nullptr;
+    other._target = other._guard_column = other._guard_row = nullptr;
     return *this;
   }
 
   /* Destructor */
-  ~Renderer() {
-    if (_renderer != nullptr)
-      SDL_DestroyRenderer(_renderer);
-  }
+  ~Renderer() { destroy(); }
 
   /* Functional Contructor */
   [[nodiscard]]
   static std::expected<Renderer, re::Error<Renderer::Error>> create(Window& window, Driver driver = Driver::Default) {
+    if (driver == Driver::Auto)
+      return create_auto(window);
+
     // Map driver to name
     std::expected<const char*, re::Error<Error>> driver_name_result;
     if (driver_name_result = get_driver_name(driver); !driver_name_result)
@@ -80,15 +144,56 @@ class Renderer {
   /* Member functions */
   [[nodiscard]]
   SDL_Renderer* get_raw() const;
+  // Sorted command queue, flushed before presenting (drawn on top of anything rendered directly)
+  [[nodiscard]]
+  RenderQueue& queue() const;
   void clear(u8 r, u8 g, u8 b, u8 a = 255) const;
-  void present() const;
+  // Before drawing a frame, binds the offscreen target when dynamic resolution is on (or resizes the software framebuffer)
+  void begin_frame();
+  // Flushes the queue and upscales the frame to the window (dynamic resolution), anything drawn directly afterwards
+  // lands on the window at full resolution (overlays). Called by present() when needed
+  void resolve();
+  void present();
+
+  // Frame capture, a zero width/height in settings means the current output size
+  re::expected<re::Error<Error>> start_capture(FrameCapture::Settings settings);
+  void stop_capture();
+  [[nodiscard]] const FrameCapture* capture() const noexcept;
+
+  // Dynamic resolution, the scale follows the render time (begin_frame() to the end of the upscale) against the budget
+  // Drawing code is unaffected: coordinates and the output size stay those of the window
+  re::expected<re::Error<Error>> enable_dynamic_resolution(ResolutionController::Settings settings);
+  void disable_dynamic_resolution();
+  [[nodiscard]] const ResolutionController* resolution() const noexcept;
+
+  // Software rasterizer, the queue and clear() are drawn on the CPU instead of by the SDL renderer
+  // Turns dynamic resolution off. Textures drawn through the queue must be filled with update_texture()
+  re::expected<re::Error<Error>> enable_software_rasterizer(SoftwareRasterizer::Settings settings);
+  void disable_software_rasterizer();
+  [[nodiscard]] const SoftwareRasterizer* software_rasterizer() const noexcept;
+
+  // Owned textures, destroyed with the renderer at the latest
+  [[nodiscard]] std::expected<TextureHandle, re::Error<Error>> create_texture(SDL_PixelFormat format, SDL_TextureAccess access, u32 width, u32 height);
+  // Whole texture, also updates the copy of the software rasterizer
+  bool update_texture(TextureHandle handle, const void* pixels, int pitch);
+  void destroy_texture(TextureHandle handle);
+  // nullptr if the texture was destroyed
+  [[nodiscard]] SDL_Texture* texture(TextureHandle handle) const noexcept;
 
  private:
+  [[nodiscard]]
+  static std::expected<Renderer, re::Error<Renderer::Error>> create_auto(Window& window);
+
+  // (Re)creates _target and its guard textures at the output size when it doesn't match, must be called without a target bound
+  [[nodiscard]] bool update_target();
+  void destroy_target() noexcept;
+
   constexpr static std::expected<const char*, re::Error<Error>> get_driver_name(Driver driver) {
     using driver_type = std::underlying_type_t<Driver>;
 
     switch (driver) {
       case Driver::Default: return (const char*)NULL;
+      case Driver::Auto: return (const char*)NULL; // Resolved by create_auto()
       case Driver::Direct3d: return "direct3d";
       case Driver::Direct3d11: return "direct3d11";
       case Driver::Direct3d12: return "direct3d12";
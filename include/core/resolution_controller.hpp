@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <unders_helpers/types.hpp>
+
+// Picks the render scale from measured frame times (dynamic resolution)
+// Frame times are averaged over a window of WINDOW_SIZE frames, after each window:
+// - over budget: the scale drops in proportion (render cost follows the pixel count, so the square root of the ratio)
+// - under budget by a margin: the scale climbs back a step at a time
+// Scales are multiples of STEP so small frame time jitter doesn't change the resolution every window
+class ResolutionController {
+ public:
+  /* Settings */
+  static constexpr usize WINDOW_SIZE = 16;
+  static constexpr f64 STEP = 1.0 / 32.0;
+  static constexpr f64 RAISE_THRESHOLD = 0.75; // Average below budget * threshold raises the scale
+  static constexpr f64 MAX_DROP = 0.25;        // Largest scale drop in one window
+
+  struct Settings {
+    f64 budget = 1000.0 / 60.0; // In ms, render time per frame
+    f64 min_scale = 0.5;
+    f64 max_scale = 1.0;
+  };
+
+ private:
+  /* Members */
+  Settings _settings;
+  f64 _scale;
+  std::array<f64, WINDOW_SIZE> _samples{};
+  usize _sample_count = 0;
+  f64 _last_average = 0.0;
+
+ public:
+  /* Constructor */
+  explicit ResolutionController(Settings settings) : _settings(settings), _scale(settings.max_scale) {}
+
+  // SDL_TEST_DYNAMIC_RESOLUTION=<budget in ms>, nothing if unset
+  [[nodiscard]] static std::optional<Settings> settings_from_environment();
+
+  /* Member functions */
+  // Records the render time of a frame (in ms), returns whether the scale changed
+  bool update(f64 frame_time) noexcept;
+
+  /* Getters */
+  [[nodiscard]] f64 scale() const noexcept { return _scale; }
+  [[nodiscard]] const Settings& settings() const noexcept { return _settings; }
+  // Average render time of the last full window, in ms
+  [[nodiscard]] f64 average_frame_time() const noexcept { return _last_average; }
+};
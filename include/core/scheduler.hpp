@@ -0,0 +1,247 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <unders_helpers/types.hpp>
+#include <utility>
+#include <vector>
+
+// Anything a task can co_await until it is ready (asset handles, jobs, ...)
+template <typename T>
+concept ReadyPollable = requires(const T& value) {
+  { value.is_ready() } -> std::convertible_to<bool>;
+};
+
+// Coroutine run by a Scheduler, e.g.
+//   Task wander(Enemy& enemy) {
+//     while (enemy.alive) {
+//       enemy.pick_target();
+//       co_await Scheduler::seconds(2.0);
+//     }
+//   }
+//   _scheduler.spawn(wander(enemy));
+// A task starts suspended and only runs once spawned (or co_awaited by another task, which then resumes when it ends)
+// Frames come from a pool recycling blocks per size class, so spawning many short tasks doesn't hit the heap
+class Task {
+ public:
+  struct promise_type {
+    std::coroutine_handle<> continuation; // Task awaiting this one, none for spawned tasks
+    usize root_index = 0;                 // Index in Scheduler::_tasks, spawned tasks only
+
+    /* Frame allocation (pooled) */
+    [[nodiscard]] static void* operator new(usize size);
+    static void operator delete(void* pointer, usize size) noexcept;
+
+    /* Coroutine interface */
+    Task get_return_object() noexcept { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept { return FinalAwaiter{}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    // co_await on a ReadyPollable suspends until is_ready(), anything else is awaited as is
+    template <typename T>
+    decltype(auto) await_transform(T&& value) noexcept {
+      if constexpr (ReadyPollable<std::remove_cvref_t<T>>)
+        return ReadyAwaiter<std::remove_cvref_t<T>>{value};
+      else
+        return std::forward<T>(value);
+    }
+  };
+
+ private:
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    // Awaited tasks hand over to their parent, spawned ones are destroyed by their scheduler
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+    void await_resume() noexcept {}
+  };
+
+  template <typename T>
+  struct ReadyAwaiter;
+
+  /* Members */
+  std::coroutine_handle<promise_type> _handle;
+
+  /* Constructor */
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept : _handle(handle) {}
+
+  friend class Scheduler;
+
+ public:
+  /* Special constructors */
+  // No copy
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  // Moveable
+  Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (_handle)
+        _handle.destroy();
+      _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  ~Task() {
+    if (_handle)
+      _handle.destroy();
+  }
+
+  /* Awaiting */
+  // Runs the task inside the awaiting one (no frame of delay), resumes the awaiting task when it ends
+  bool await_ready() const noexcept { return !_handle || _handle.done(); }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    _handle.promise().continuation = awaiting;
+    return _handle;
+  }
+  void await_resume() const noexcept {}
+};
+
+// Resumes tasks from the main thread, once per frame (Application::run() calls run())
+// Tasks resume in order until the frame budget is used up, the remaining ones carry over to the next frame ahead of
+// newly ready tasks, so expensive scripted work (AI, loading steps, ...) is spread over frames instead of spiking one
+// At least one task resumes per frame so a small budget slows tasks down but never starves them
+class Scheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /* Settings */
+  static constexpr f64 DEFAULT_BUDGET = 2.0; // In ms
+
+ private:
+  using Handle = std::coroutine_handle<>;
+
+  struct Timer {
+    f64 wake_time; // In s, scheduler time
+    u64 order;     // Same wake time resumes in co_await order
+    Handle handle;
+
+    [[nodiscard]] bool operator>(const Timer& other) const noexcept {
+      return wake_time != other.wake_time ? wake_time > other.wake_time : order > other.order;
+    }
+  };
+
+  struct Waiting {
+    Handle handle;
+    const void* value;
+    bool (*is_ready)(const void*);
+  };
+
+  /* Members */
+  f64 _budget = DEFAULT_BUDGET;
+  f64 _time = 0.0; // In s, sum of the delta times given to run()
+  u64 _frame = 0;
+  u64 _timer_order = 0;
+
+  std::vector<std::coroutine_handle<Task::promise_type>> _tasks; // Spawned and not finished
+  std::vector<Handle> _ready;                                    // Resumed this frame, in order
+  std::vector<Handle> _next_frame;                               // Ready from the next frame on
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<>> _timers;
+  std::vector<Waiting> _waiting; // Polled once per frame
+
+  // Scheduler running tasks on this thread, awaiters reach it through here
+  static thread_local Scheduler* _current;
+
+  friend class Task;
+
+ public:
+  /* Constructor */
+  Scheduler() = default;
+
+  /* Special constructors */
+  // No copy
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  // Moveable (tasks only refer to their scheduler while it runs them)
+  Scheduler(Scheduler&& other) noexcept = default;
+  Scheduler& operator=(Scheduler&& other) noexcept {
+    if (this != &other) {
+      destroy_tasks();
+      _budget = other._budget;
+      _time = other._time;
+      _frame = other._frame;
+      _timer_order = other._timer_order;
+      _tasks = std::move(other._tasks);
+      _ready = std::move(other._ready);
+      _next_frame = std::move(other._next_frame);
+      _timers = std::move(other._timers);
+      _waiting = std::move(other._waiting);
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  // Unfinished tasks are destroyed, along with the tasks they await
+  ~Scheduler() { destroy_tasks(); }
+
+  /* Member functions */
+  // Takes ownership of the task, which first resumes on the next run()
+  void spawn(Task&& task);
+
+  // Wakes the timers and pollables that are due then resumes ready tasks until the budget is used up
+  // delta_time is in ms, like Application::update()
+  void run(f64 delta_time);
+
+  /* Getters & Setters */
+  // Time spent resuming tasks per frame, in ms
+  [[nodiscard]] f64 budget() const noexcept { return _budget; }
+  void set_budget(f64 budget) noexcept { _budget = budget; }
+
+  [[nodiscard]] f64 time() const noexcept { return _time; }
+  [[nodiscard]] u64 frame() const noexcept { return _frame; }
+  [[nodiscard]] usize task_count() const noexcept { return _tasks.size(); }
+  // Tasks that were ready but didn't fit in the last frame's budget
+  [[nodiscard]] usize carried_over() const noexcept { return _ready.size(); }
+
+  /* Awaitables */
+  // Resumes on the next frame
+  struct NextFrame {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const { _current->_next_frame.push_back(handle); }
+    void await_resume() const noexcept {}
+  };
+  [[nodiscard]] static NextFrame next_frame() noexcept { return {}; }
+
+  // Resumes once delta times given to run() add up to duration (in s), no sooner than the next frame
+  struct Seconds {
+    f64 duration;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+      _current->_timers.push(Timer{_current->_time + duration, _current->_timer_order++, handle});
+    }
+    void await_resume() const noexcept {}
+  };
+  [[nodiscard]] static Seconds seconds(f64 duration) noexcept { return {duration}; }
+
+ private:
+  void wait_until_ready(Handle handle, const void* value, bool (*is_ready)(const void*)) {
+    _waiting.push_back(Waiting{handle, value, is_ready});
+  }
+
+  void retire(std::coroutine_handle<Task::promise_type> handle) noexcept;
+  void destroy_tasks() noexcept;
+};
+
+/* Template implementations */
+template <typename T>
+struct Task::ReadyAwaiter {
+  const T& value;
+
+  bool await_ready() const noexcept { return static_cast<bool>(value.is_ready()); }
+  void await_suspend(std::coroutine_handle<> handle) const {
+    Scheduler::_current->wait_until_ready(handle, &value, [](const void* pointer) {
+      return static_cast<bool>(static_cast<const T*>(pointer)->is_ready());
+    });
+  }
+  void await_resume() const noexcept {}
+};
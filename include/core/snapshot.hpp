@@ -0,0 +1,289 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <rerror/error.hpp>
+#include <semaphore>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unders_helpers/dynamic_bitset.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// Flat binary snapshots of trivially copyable state, readable in place (e.g. from a memory mapped file)
+//
+// Layout (host endianness, every offset is relative to the start of the snapshot):
+// | SnapshotHeader | SnapshotSection[section_count] | payloads (64 bytes aligned) |
+//
+// Full snapshots store each section as is, so a section is a std::span over the mapped bytes
+// Diff snapshots only store the pages (PAGE_SIZE bytes) that changed since the previous snapshot:
+// | u32 page indices[page_count] | padding | page data[page_count] |
+// Restoring is loading the full snapshot then applying every diff in sequence order
+// Sections are hashed and compared byte for byte, their types must not have implicit padding (its bytes are unspecified)
+
+/* Format */
+struct SnapshotHeader {
+  static constexpr u32 MAGIC = 0x534C4453; // "SDLS"
+  static constexpr u16 VERSION = 1;
+
+  enum class Kind : u16 {
+    Full,
+    Diff
+  };
+
+  u32 magic;
+  u16 version;
+  Kind kind;
+  u32 section_count;
+  u32 sequence; // 0 for full snapshots, n for the n-th diff following it
+  u64 size;     // Of the whole snapshot in bytes
+};
+
+struct SnapshotSection {
+  u32 id;
+  u32 element_size;
+  u64 offset;
+  u64 size;       // Size of the section's data (for diffs, of the data the pages apply to)
+  u32 page_count; // Diff only
+  u32 reserved;
+};
+
+/* Writer */
+class SnapshotWriter {
+ public:
+  static constexpr usize PAGE_SIZE = 4096;
+  static constexpr usize ALIGNMENT = 64;
+
+  enum class Error {
+    NoBaseSnapshot,
+    FileWriting
+  };
+
+ private:
+  struct PendingSection {
+    u32 id;
+    u32 element_size;
+    std::span<const std::byte> bytes;
+  };
+
+  // Page hashes of the last written snapshot, used to find dirty pages
+  struct PageHashes {
+    u32 id;
+    u64 size;
+    std::vector<u64> hashes;
+  };
+
+  /* Members */
+  std::vector<PendingSection> _sections;
+  std::vector<PageHashes> _page_hashes;
+  uh::dynamic_bitset _dirty_pages; // Scratch, one bit per page of the current section
+  std::vector<std::byte> _buffer; // Reused between snapshots
+  u32 _sequence = 0;
+  bool _has_base = false;
+
+ public:
+  /* Member functions */
+  // The data is only read by the next write_full()/write_diff() and must stay alive until then
+  // T must not have implicit padding, use explicit zeroed members instead
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  void add_section(u32 id, std::span<const T> data) {
+    _sections.push_back(PendingSection{id, static_cast<u32>(sizeof(T)), std::as_bytes(data)});
+  }
+
+  // Builds a snapshot out of the added sections, the result stays valid until the next write
+  std::span<const std::byte> write_full();
+  [[nodiscard]] std::expected<std::span<const std::byte>, re::Error<Error>> write_diff();
+
+  [[nodiscard]] bool has_base() const noexcept { return _has_base; }
+  [[nodiscard]] u32 sequence() const noexcept { return _sequence; }
+  // Largest snapshot built without allocating, after a write_full() room is made for a diff of every page
+  [[nodiscard]] usize capacity() const noexcept { return _buffer.capacity(); }
+
+  // Forgets the base snapshot, the next one must be full. Buffers and page hashes are kept
+  void reset() noexcept {
+    _sections.clear();
+    _sequence = 0;
+    _has_base = false;
+  }
+
+  // Writes the last built snapshot to a file
+  re::expected<re::Error<Error>> save(const std::string& path) const;
+
+ private:
+  PageHashes& page_hashes(u32 id);
+  usize reserve(usize size, usize alignment);
+  void write_header(SnapshotHeader::Kind kind, u32 section_count);
+};
+
+/* Background saving */
+// Writes built snapshots of a chain (a full snapshot, sequence 0, then diffs) to files on a background thread, in
+// submission order, so saving never waits on the disk
+// The paths are given once, and starting a new chain removes the diffs of the previous one on the writer thread
+// The bytes are copied on submission into buffers kept between saves, the SnapshotWriter can build the next snapshot right
+// away. Once the buffers have the size of a full snapshot (see create()), saving doesn't allocate
+class SnapshotSaver {
+ public:
+  static constexpr usize QUEUE_SIZE = 4; // Saves waiting to be written, a fifth one waits for the oldest
+
+  enum class Error {
+    ThreadCreation
+  };
+
+ private:
+  struct Job {
+    u32 sequence = 0;
+    std::vector<std::byte> bytes; // Reused, only grows
+  };
+
+  /* Members */
+  std::vector<std::string> _paths;                        // By sequence
+  std::array<Job, QUEUE_SIZE> _jobs;                      // Ring, the job of save n is _jobs[n % QUEUE_SIZE]
+  u64 _submitted = 0;                                     // Main thread only
+  u64 _written = 0;                                       // Writer only
+  std::counting_semaphore<QUEUE_SIZE + 1> _ready_jobs{0}; // One release per job, plus one to stop the writer
+  std::atomic<u32> _pending{0};                           // Submitted, not written yet
+  std::atomic<u64> _failed_saves{0};
+  std::thread _writer;
+
+  /* Constructor (Private, use functional constructors instead) */
+  explicit SnapshotSaver(std::vector<std::string>&& paths) : _paths(std::move(paths)) {}
+
+ public:
+  /* Special constructors */
+  // Shared with the writer thread, neither copyable nor moveable
+  SnapshotSaver(const SnapshotSaver&) = delete;
+  SnapshotSaver& operator=(const SnapshotSaver&) = delete;
+
+  /* Destructor */
+  // Writes the pending saves then stops the writer
+  ~SnapshotSaver();
+
+  /* Functional constructors */
+  // paths[sequence] is the file of each snapshot of a chain, reserved_bytes the expected size of the largest one
+  [[nodiscard]]
+  static std::expected<std::unique_ptr<SnapshotSaver>, re::Error<Error>> create(std::vector<std::string> paths, usize reserved_bytes = 0);
+
+  /* Member functions */
+  // Queues a copy of bytes to be written to the file of sequence, after removing the previous diffs for a full snapshot
+  void save(u32 sequence, std::span<const std::byte> bytes);
+  // Returns once every queued save is written (before reading the files back)
+  void wait() noexcept;
+
+  [[nodiscard]] const std::string& path(u32 sequence) const noexcept { return _paths[sequence]; }
+  // Failures are printed by the writer thread
+  [[nodiscard]] u64 failed_saves() const noexcept { return _failed_saves.load(std::memory_order_relaxed); }
+
+ private:
+  void write_loop();
+};
+
+/* Reader */
+// Non owning view over snapshot bytes, validated once on creation
+class SnapshotView {
+ public:
+  enum class Error {
+    TooSmall,
+    BadMagic,
+    UnsupportedVersion,
+    OutOfBounds,
+    MissingSection,
+    WrongKind,
+    ElementSizeMismatch,
+    Misaligned,
+    SizeMismatch
+  };
+
+ private:
+  std::span<const std::byte> _data;
+
+  SnapshotView(std::span<const std::byte> data) : _data(data) {}
+
+ public:
+  /* Functional constructors */
+  [[nodiscard]]
+  static std::expected<SnapshotView, re::Error<Error>> create(std::span<const std::byte> data);
+
+  /* Member functions */
+  [[nodiscard]] const SnapshotHeader& header() const noexcept { return *reinterpret_cast<const SnapshotHeader*>(_data.data()); }
+
+  // Full snapshots only, no copy
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  [[nodiscard]] std::expected<std::span<const T>, re::Error<Error>> section(u32 id) const {
+    std::expected<const SnapshotSection*, re::Error<Error>> entry = find_section(id, SnapshotHeader::Kind::Full);
+    if (!entry) [[unlikely]]
+      return std::unexpected(std::move(entry.error()));
+
+    if ((*entry)->element_size != sizeof(T)) [[unlikely]]
+      return std::unexpected(re::error(Error::ElementSizeMismatch, "Section element size doesn't match the requested type"));
+
+    const std::byte* bytes = _data.data() + (*entry)->offset;
+    if (reinterpret_cast<uintptr_t>(bytes) % alignof(T) != 0) [[unlikely]]
+      return std::unexpected(re::error(Error::Misaligned, "Section data isn't aligned for the requested type"));
+
+    return std::span<const T>(reinterpret_cast<const T*>(bytes), (*entry)->size / sizeof(T));
+  }
+
+  // Diff snapshots only, patches the changed pages of a section into destination
+  re::expected<re::Error<Error>> apply(u32 id, std::span<std::byte> destination) const;
+
+ private:
+  [[nodiscard]] std::expected<const SnapshotSection*, re::Error<Error>> find_section(u32 id, SnapshotHeader::Kind kind) const;
+};
+
+/* File mapping */
+// Read-only file contents, memory mapped when the platform allows it
+class MappedFile {
+ public:
+  enum class Error {
+    Opening,
+    Mapping
+  };
+
+ private:
+  const std::byte* _data = nullptr;
+  usize _size = 0;
+  bool _mapped = false; // Otherwise loaded with SDL_LoadFile
+
+  MappedFile(const std::byte* data, usize size, bool mapped) : _data(data), _size(size), _mapped(mapped) {}
+
+ public:
+  /* Special constructors */
+  // No copy
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Moveable
+  MappedFile(MappedFile&& other) noexcept
+      : _data(other._data), _size(other._size), _mapped(other._mapped) {
+    other._data = nullptr;
+  }
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    release();
+    _data = other._data;
+    _size = other._size;
+    _mapped = other._mapped;
+
+    other._data = nullptr;
+    return *this;
+  }
+
+  /* Destructor */
+  ~MappedFile() { release(); }
+
+  /* Functional constructors */
+  [[nodiscard]]
+  static std::expected<MappedFile, re::Error<Error>> open(const std::string& path);
+
+  /* Member functions */
+  [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {_data, _size}; }
+
+ private:
+  void release() noexcept;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <SDL3/SDL_pixels.h>
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_surface.h>
+
+#include <atomic>
+#include <barrier>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <rerror/error.hpp>
+#include <thread>
+#include <unders_helpers/flat_hash_map.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+#include "core/render_queue.hpp"
+
+// CPU renderer for machines without a GPU, draws RenderQueue commands into an ARGB8888 SDL_Surface
+// - Commands are binned into TILE_SIZE square tiles, worker threads take tiles from a shared counter and draw every
+//   command touching them in submission order, so no two threads ever write the same pixel
+// - Spans are filled and blended 8 pixels at a time with AVX2, 4 with SSE2 (picked at compile time), textures are
+//   sampled (nearest, scaled and rotated) into a row then blended like a span
+// - The frame reaches the window through a streaming texture, the SDL renderer only copies it
+// Textured commands need a CPU copy of their texture (see add_image()), commands with unknown textures are skipped
+class SoftwareRasterizer {
+ public:
+  /* Settings */
+  static constexpr u32 TILE_SIZE = 64; // In pixels, 16 KiB of framebuffer per tile
+  static constexpr usize MAX_THREADS = 8;
+
+  /* Types */
+  enum class Error {
+    SurfaceCreation,
+    ThreadCreation
+  };
+
+  struct Settings {
+    u32 threads = 0; // Drawing threads (the caller included), 0 picks one per core up to MAX_THREADS
+  };
+
+  using Command = RenderQueue::Command;
+  using BlendMode = RenderQueue::BlendMode;
+
+ private:
+  struct Image {
+    SDL_PixelFormat format = SDL_PIXELFORMAT_ARGB8888; // Of the texture, pixels are converted on update
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<u32> pixels; // ARGB8888
+  };
+
+  struct Bounds {
+    i32 x0, y0, x1, y1; // In pixels, end excluded, clipped to the framebuffer
+  };
+
+  struct DrawCommand {
+    Command command;
+    const Image* image; // Texture only
+    Bounds bounds;
+  };
+
+  /* Members */
+  SDL_Surface* _framebuffer = nullptr;
+  SDL_Texture* _texture = nullptr; // Streaming, created by present()
+  SDL_Renderer* _texture_renderer = nullptr;
+  std::optional<u32> _clear_color; // Applied by every tile before its commands
+
+  uh::flat_hash_map<const SDL_Texture*, Image> _images;
+  const SDL_Texture* _last_texture = nullptr; // Commands are sorted by texture, skips most lookups
+  const Image* _last_image = nullptr;
+
+  // Frame, reused from one frame to the next
+  std::vector<DrawCommand> _commands;
+  std::vector<u32> _bin_offsets; // Per tile, into _bin_commands (tile_count + 1)
+  std::vector<u32> _bin_commands;
+  u32 _tiles_x = 0;
+  u32 _tiles_y = 0;
+  std::atomic<u32> _next_tile{0};
+
+  // Workers wait on _start, draw tiles, then meet the caller on _end
+  std::barrier<> _start;
+  std::barrier<> _end;
+  std::atomic<bool> _stopping{false};
+  std::vector<std::jthread> _workers;
+
+  /* Constructor (Private, use functional constructors instead) */
+  explicit SoftwareRasterizer(usize threads) : _start(static_cast<std::ptrdiff_t>(threads)), _end(static_cast<std::ptrdiff_t>(threads)) {}
+
+ public:
+  /* Special constructors */
+  // Shared with the workers, neither copyable nor moveable
+  SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+  SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+  /* Destructor */
+  ~SoftwareRasterizer();
+
+  /* Functional constructors */
+  [[nodiscard]]
+  static std::expected<std::unique_ptr<SoftwareRasterizer>, re::Error<Error>> create(u32 width, u32 height, Settings settings);
+
+  // SDL_TEST_SOFTWARE_RASTERIZER=<threads> (0 for one per core), nothing if unset
+  [[nodiscard]]
+  static std::optional<Settings> settings_from_environment();
+
+  /* Framebuffer */
+  // Recreates the framebuffer when the size changes, its content is lost
+  [[nodiscard]] bool resize(u32 width, u32 height);
+  [[nodiscard]] const SDL_Surface* framebuffer() const noexcept { return _framebuffer; }
+  [[nodiscard]] u32 width() const noexcept { return static_cast<u32>(_framebuffer->w); }
+  [[nodiscard]] u32 height() const noexcept { return static_cast<u32>(_framebuffer->h); }
+
+  /* Images */
+  // CPU copy of a texture (transparent until updated), adding an image again replaces it
+  void add_image(const SDL_Texture* texture, SDL_PixelFormat format, u32 width, u32 height);
+  // Whole image, in the format of the texture (converted to ARGB8888)
+  void update_image(const SDL_Texture* texture, const void* pixels, int pitch);
+  void remove_image(const SDL_Texture* texture);
+
+  /* Frame */
+  // Fills the whole framebuffer before the commands of the frame
+  void clear(u8 r, u8 g, u8 b, u8 a = 255) noexcept;
+  // In drawing order (RenderQueue::flush() submits sorted commands)
+  void submit(const Command& command);
+  // Draws the submitted commands on every thread, then forgets them
+  void render();
+  // Uploads the framebuffer to the streaming texture and draws it over the current render target
+  bool present(SDL_Renderer* renderer);
+
+  [[nodiscard]] usize thread_count() const noexcept { return _workers.size() + 1; }
+
+  /* Pixels */
+  // ARGB8888 blending of the tiles: one pixel with the scalar formula, then rows taking the vector paths where there
+  // are some (the result is the same, tests compare both). Modulation multiplies the source channels, white leaves it
+  [[nodiscard]] static u32 blend_pixel(u32 destination, u32 source, BlendMode blend, u32 modulation = 0xFFFFFFFFu) noexcept;
+  static void blend_row(u32* destination, const u32* source, usize count, u32 modulation, BlendMode blend) noexcept;
+  static void fill_row(u32* destination, usize count, u32 color, BlendMode blend) noexcept;
+
+ private:
+  void work();
+  void draw_tiles() noexcept;
+  void draw_tile(u32 tile) noexcept;
+};
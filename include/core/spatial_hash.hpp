@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <unders_helpers/flat_hash_map.hpp>
+#include <unders_helpers/small_vector.hpp>
+#include <unders_helpers/types.hpp>
+#include <vector>
+
+// Uniform grid hash for broad spatial queries (view culling, neighbors)
+// Objects are identified by a caller provided dense id (e.g. an index in an array) and stored in every cell their bounds overlap
+// Cells are never freed once created so objects moving around reuse the same memory, reserve() creates those of the
+// world up front. Heap storage of a cell that empties goes to the next cell spilling past INLINE_CELL_IDS
+class SpatialHash {
+ public:
+  /* Settings */
+  static constexpr usize INLINE_CELL_IDS = 8; // Ids stored in the cell itself before going to the heap
+
+  /* Types */
+  using Id = u32;
+
+  struct Bounds {
+    glm::vec2 min;
+    glm::vec2 max;
+  };
+
+ private:
+  struct CellRange {
+    glm::ivec2 min;
+    glm::ivec2 max;
+
+    constexpr bool operator==(const CellRange&) const = default;
+  };
+
+  using CellIds = uh::small_vector<Id, INLINE_CELL_IDS>;
+
+  struct Object {
+    Bounds bounds;
+    CellRange cells;
+    bool alive = false;
+  };
+
+  /* Members */
+  f32 _cell_size;
+  f32 _inverse_cell_size;
+  std::vector<Object> _objects; // Indexed by id
+  uh::flat_hash_map<u64, CellIds> _cells; // Mixes the identity std::hash<u64> itself
+  std::vector<CellIds> _spare_ids; // Empty, on the heap, taken back by cells spilling
+
+  // Objects spanning several cells are reported once per query using a stamp
+  mutable std::vector<u32> _query_stamps;
+  mutable u32 _query_stamp = 0;
+
+ public:
+  /* Constructor */
+  explicit SpatialHash(f32 cell_size = 64.0f)
+      : _cell_size(cell_size), _inverse_cell_size(1.0f / cell_size) {}
+
+  /* Member functions */
+  // Creates every cell overlapping world, objects staying inside it then never add cells
+  void reserve(const Bounds& world);
+  void insert(Id id, const Bounds& bounds);
+  // Only touches the cells when the object crosses a cell boundary
+  void move(Id id, const Bounds& bounds);
+  void remove(Id id);
+  void clear();
+
+  [[nodiscard]] bool contains(Id id) const noexcept { return id < _objects.size() && _objects[id].alive; }
+  [[nodiscard]] f32 cell_size() const noexcept { return _cell_size; }
+
+  // Appends the ids of objects whose bounds overlap the rectangle/circle
+  void query_rect(const Bounds& rect, std::vector<Id>& out) const;
+  void query_radius(glm::vec2 center, f32 radius, std::vector<Id>& out) const;
+
+  // Calls function(id) for every object overlapping the rectangle, without output buffer
+  // Queries can't be nested (function must not query the same SpatialHash)
+  template <typename TFunction>
+  void for_each_in_rect(const Bounds& rect, TFunction&& function) const;
+
+ private:
+  [[nodiscard]]
+  static constexpr u64 cell_key(i32 x, i32 y) noexcept { return (u64{static_cast<u32>(x)} << 32) | u64{static_cast<u32>(y)}; }
+  [[nodiscard]]
+  static constexpr bool overlaps(const Bounds& a, const Bounds& b) noexcept {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+  }
+
+  [[nodiscard]] CellRange cell_range(const Bounds& bounds) const noexcept;
+  void add_to_cells(Id id, const CellRange& cells);
+  void remove_from_cells(Id id, const CellRange& cells);
+  void push_id(CellIds& ids, Id id);
+  void release_if_empty(CellIds& ids);
+  u32 next_query_stamp() const;
+};
+
+template <typename TFunction>
+void SpatialHash::for_each_in_rect(const Bounds& rect, TFunction&& function) const {
+  const u32 stamp = next_query_stamp();
+  const CellRange cells = cell_range(rect);
+
+  for (i32 y = cells.min.y; y <= cells.max.y; y++) {
+    for (i32 x = cells.min.x; x <= cells.max.x; x++) {
+      auto cell = _cells.find(cell_key(x, y));
+      if (cell == _cells.end())
+        continue;
+
+      for (const Id id : cell->second) {
+        if (_query_stamps[id] == stamp || !overlaps(_objects[id].bounds, rect))
+          continue;
+        _query_stamps[id] = stamp;
+        function(id);
+      }
+    }
+  }
+}
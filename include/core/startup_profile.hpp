@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <span>
+#include <string>
+#include <unders_helpers/types.hpp>
+
+// Timeline of the startup, from Application::create() to the first presented frame
+// Stages can be recorded from any thread (background work runs next to window and renderer creation), they are read
+// once every background stage has been joined
+class StartupProfile {
+ public:
+  /* Settings */
+  static constexpr usize MAX_STAGES = 32; // Later stages are dropped
+
+  /* Types */
+  using Clock = std::chrono::steady_clock;
+
+  struct Stage {
+    const char* name; // Static string
+    f64 start;        // In ms since the profile started
+    f64 end;
+    bool background;
+  };
+
+  // Records a stage from its construction to its destruction
+  class Scope {
+    StartupProfile& _profile;
+    const char* _name;
+    Clock::time_point _start;
+    bool _background;
+
+   public:
+    Scope(StartupProfile& profile, const char* name, bool background) : _profile(profile), _name(name), _start(Clock::now()), _background(background) {}
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() { _profile.record(_name, _start, Clock::now(), _background); }
+  };
+
+ private:
+  /* Members */
+  Clock::time_point _start;
+  std::array<Stage, MAX_STAGES> _stages{};
+  std::atomic<usize> _count{0}; // Slots are claimed before being written
+  std::optional<f64> _first_frame;
+
+ public:
+  /* Constructor */
+  StartupProfile() : _start(Clock::now()) {}
+
+  // SDL_TEST_STARTUP_PROFILE set: the frame loop prints the report after the first frame
+  [[nodiscard]] static bool report_requested();
+
+  /* Member functions */
+  [[nodiscard]] Scope scope(const char* name, bool background = false) { return Scope(*this, name, background); }
+  void record(const char* name, Clock::time_point start, Clock::time_point end, bool background = false) noexcept;
+  // Called after the first frame is presented, only the first call counts
+  void first_frame() noexcept;
+
+  /* Getters */
+  [[nodiscard]] std::span<const Stage> stages() const noexcept;
+  [[nodiscard]] std::optional<f64> time_to_first_frame() const noexcept { return _first_frame; }
+  // One line per stage in start order, background stages marked
+  [[nodiscard]] std::string report() const;
+};
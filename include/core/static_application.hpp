@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL3/SDL_events.h>
+
+#include <concepts>
+#include <rerror/error.hpp>
+#include <type_traits>
+#include <utility>
+
+#include "core/application.hpp"
+
+// Callbacks the frame loop calls on a game
+template <typename T>
+concept ApplicationCallbacks = requires(T& app, const T& const_app, const SDL_Event& event, double delta_time) {
+  { app.setup() } -> std::same_as<re::expected<re::AnyError>>;
+  { app.input(event) } -> std::same_as<re::expected<re::AnyError>>;
+  { app.update(delta_time) } -> std::same_as<re::expected<re::AnyError>>;
+  { const_app.draw() } -> std::same_as<re::expected<re::AnyError>>;
+};
+
+// Static dispatch variant of Application (CRTP)
+// The frame loop calls TDerived's callbacks directly instead of going through the vtable,
+// TDerived must be final so the compiler can devirtualize (and inline) them
+// Usage: class Game final : public StaticApplication<Game> { ... };
+template <typename TDerived>
+class StaticApplication : public Application {
+ protected:
+  /* Constructor */
+  StaticApplication(Application&& app) : Application(std::move(app)) {};
+
+ public:
+  /* Member functions */
+  // Hides Application::run()
+  re::expected<re::AnyError> run() {
+    static_assert(ApplicationCallbacks<TDerived>, "TDerived must implement setup(), input(), update() and draw()");
+    static_assert(std::is_final_v<TDerived>, "TDerived must be final for its callbacks to be statically dispatched");
+
+    return run_loop(static_cast<TDerived&>(*this));
+  }
+};
@@ -1,33 +1,189 @@
 #pragma once
 
+#include <SDL3/SDL_pixels.h>
 #include <SDL3/SDL_render.h>
+#include <SDL3/SDL_scancode.h>
 
+#include <array>
 #include <expected>
+#include <future>
+#include <glm/vec2.hpp>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "core/application.hpp"
+#include "core/broad_phase.hpp"
+#include "core/flow_field_cache.hpp"
+#include "core/navigation_grid.hpp"
+#include "core/snapshot.hpp"
+#include "core/spatial_hash.hpp"
+#include "core/startup_profile.hpp"
+#include "core/static_application.hpp"
 #include "core/window.hpp"
 #include "rerror/error.hpp"
+#include "unders_helpers/object_pool.hpp"
 #include "unders_helpers/types.hpp"
 
-class Game : public Application {
+// Final so StaticApplication can dispatch the callbacks below without virtual calls
+class Game final : public StaticApplication<Game> {
+ public:
+  /* World settings */
+  static constexpr glm::vec2 WORLD_SIZE{8192.0f, 8192.0f};
+  static constexpr usize BODY_COUNT = 20'000;
+  static constexpr f32 MAX_HALF_SIZE = 8.0f;     // In pixels
+  static constexpr f32 CAMERA_SPEED = 600.0f;    // In pixels/s
+  static constexpr f32 NEIGHBOR_RADIUS = 24.0f;  // In pixels
+  static constexpr u32 CROWDED_NEIGHBORS = 3;
+
+  static constexpr std::array<SDL_Color, 4> PALETTE{{
+      {70, 130, 180, 255},
+      {95, 158, 160, 255},
+      {154, 205, 50, 255},
+      {218, 165, 32, 255},
+  }};
+  static constexpr SDL_Color CROWDED_COLOR{220, 60, 60, 255};
+
+  /* Impact settings */
+  static constexpr usize MAX_IMPACTS = 2048;
+  static constexpr f32 IMPACT_DURATION = 0.4f; // In s
+  static constexpr f32 IMPACT_SIZE = 24.0f;    // In pixels, at the end of the animation
+  static constexpr u32 IMPACT_TEXTURE_SIZE = 32;
+
+  /* Navigation settings */
+  static constexpr f32 NAVIGATION_CELL_SIZE = 32.0f; // In pixels, 256x256 cells over the world
+  static constexpr u32 WALL_COUNT = 600;
+  static constexpr f32 AGENT_SPEED = 140.0f; // In pixels/s
+  static constexpr f32 STEERING = 4.0f;      // Fraction of the velocity error corrected per s
+  static constexpr SDL_Color WALL_COLOR{90, 90, 100, 255};
+  static constexpr SDL_Color GOAL_COLOR{240, 240, 240, 255};
+
+  /* Snapshot settings */
+  static constexpr u32 SNAPSHOT_CHAIN_LENGTH = 32; // A full snapshot followed by up to 31 diffs
+  static constexpr SDL_Scancode SAVE_KEY = SDL_SCANCODE_F5;
+  static constexpr SDL_Scancode LOAD_KEY = SDL_SCANCODE_F9;
+
+  // Saved byte for byte in snapshots, the padding is explicit so its bytes are always 0
+  struct Body {
+    glm::vec2 position;
+    glm::vec2 velocity; // In pixels/s
+    glm::vec2 half_size;
+    u8 palette_index;
+    std::array<u8, 3> padding{};
+    u32 neighbors;
+  };
+  static_assert(sizeof(Body) == 6 * sizeof(f32) + 4 + sizeof(u32), "Body must not have implicit padding");
+
+  // Short-lived ring drawn where two bodies bounce, spawned and despawned constantly
+  struct Impact {
+    glm::vec2 position;
+    f32 age; // In s
+    u8 palette_index;
+  };
+
+  // Snapshot sections
+  enum class SnapshotSectionId : u32 {
+    State,
+    Bodies,
+    Navigation // Cell costs, flow fields are recomputed on load
+  };
+
+  struct SavedState {
+    glm::vec2 camera;
+    u32 goal;
+  };
+
+  // Generated without SDL, next to the window and renderer creation
+  struct World {
+    NavigationGrid navigation;
+    std::vector<Body> bodies;
+  };
+
  protected:
-  Game(Application&& app) : Application(std::move(app)) {};
+  /* Members */
+  std::vector<Body> _bodies;
+  SpatialHash _spatial_hash{64.0f};
+  BroadPhase _broad_phase;
+  glm::vec2 _camera{0.0f, 0.0f}; // Top left corner of the view in world coordinates
+  std::vector<SpatialHash::Id> _neighbors; // Reused neighbor query buffer
+
+  // Left click sets the goal every body walks to, right click toggles a wall
+  std::optional<NavigationGrid> _navigation; // Generated with the walls by create() (see generate_world())
+  FlowFieldCache _flow_fields;
+  u32 _goal = NavigationGrid::NONE;
+  std::mt19937 _random_engine{7}; // Respawns
+
+  uh::object_pool<Impact, u64> _impacts; // Not saved in snapshots. Created and erased all the time, u64 handles keep slots from retiring
+  Renderer::TextureHandle _impact_texture;
+
+  SnapshotWriter _snapshot_writer;
+  std::unique_ptr<SnapshotSaver> _snapshot_saver; // Null when no thread could be started, saves are then synchronous
+  std::vector<std::string> _snapshot_paths;       // By sequence, built once in setup()
+
+  /* Constructor */
+  Game(Application&& app, World&& world) : StaticApplication(std::move(app)), _bodies(std::move(world.bodies)), _navigation(std::move(world.navigation)) {};
+
+  [[nodiscard]]
+  static constexpr SpatialHash::Bounds bounds_of(const Body& body) noexcept { return {body.position - body.half_size, body.position + body.half_size}; }
+  // Not in a wall, the world border counts as open
+  [[nodiscard]] static bool is_open(const NavigationGrid& navigation, glm::vec2 position) noexcept {
+    const u32 cell = navigation.cell_at(position);
+    return cell == NavigationGrid::NONE || navigation.is_walkable(cell);
+  }
+  [[nodiscard]] bool is_open(glm::vec2 position) const noexcept { return is_open(*_navigation, position); }
 
  public:
   enum class Error {
-    Application
+    Application,
+    Snapshot,
+    Resources,
+    Navigation
   };
 
-  static std::expected<Game, re::AnyError> create(std::string title, u32 width, u32 height, Window::Flags flags = Window::Flags::None) {
-    auto app = Application::create(title, width, height, flags);
+  static std::expected<Game, re::AnyError> create(std::string title, u32 width, u32 height, Window::Flags flags = Window::Flags::None, Renderer::Driver driver = Renderer::Driver::Default) {
+    auto startup = std::make_shared<StartupProfile>();
+
+    // Generated on another thread while SDL opens the window and renderer
+    // (deferred to get() when no thread can be started)
+    std::future<std::expected<World, re::AnyError>> world = std::async(std::launch::async | std::launch::deferred, [startup] {
+      const auto stage = startup->scope("world generation", true);
+      return generate_world();
+    });
+
+    auto app = Application::create(title, width, height, flags, driver, startup);
     if (!app) [[unlikely]]
       return std::unexpected(re::anyError(Error::Application, "Failed to create game's base application", std::move(app.error())));
 
-    return Game(std::move(*app));
+    std::expected<World, re::AnyError> generated = [&] {
+      const auto stage = startup->scope("world wait");
+      return world.get();
+    }();
+    if (!generated) [[unlikely]]
+      return std::unexpected(std::move(generated.error()));
+
+    return Game(std::move(*app), std::move(*generated));
   }
 
   re::expected<re::AnyError> setup() noexcept override;
   re::expected<re::AnyError> input(const SDL_Event& event) noexcept override;
   re::expected<re::AnyError> update(double delta_time) noexcept override;
   re::expected<re::AnyError> draw() const noexcept override;
+
+  // Writes a full snapshot, or a diff of the pages changed since the previous one
+  re::expected<re::AnyError> save_snapshot();
+  // Restores the last full snapshot then every diff following it
+  re::expected<re::AnyError> load_snapshot();
+
+ private:
+  // Navigation grid with random walls and bodies on open cells, touches no SDL state (runs off the main thread)
+  [[nodiscard]] static std::expected<World, re::AnyError> generate_world();
+  [[nodiscard]] const std::string& snapshot_path(u32 sequence) const noexcept { return _snapshot_paths[sequence]; }
+  // state must stay alive until the next snapshot is built
+  void add_snapshot_sections(const SavedState& state);
+  void rebuild_indices();
 };
+
+// Instantiated in game.cpp, next to the callbacks, so the frame loop can inline them
+extern template class StaticApplication<Game>;
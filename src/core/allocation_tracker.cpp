@@ -0,0 +1,128 @@
+#include "core/allocation_tracker.hpp"
+
+#ifdef SDL_TEST_ALLOCATION_TRACKING
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+using Phase = AllocationTracker::Phase;
+
+// Plain atomics only, anything touching the heap in here would recurse into operator new
+// The phase is per thread and only the frame loop's thread sets one: allocations of other threads (capture writer,
+// flow field and rasterizer workers, world generation) don't belong to a phase of the frame and aren't counted
+constexpr Phase untracked = Phase::Count;
+constinit thread_local Phase current_phase = untracked;
+std::array<std::atomic<u64>, AllocationTracker::phase_count> allocation_counts{};
+std::array<std::atomic<u64>, AllocationTracker::phase_count> byte_counts{};
+
+AllocationTracker::FrameReport last_report{};
+AllocationTracker::Summary running_summary{};
+
+void record(std::size_t size) noexcept {
+  if (current_phase == untracked)
+    return;
+
+  const usize phase = static_cast<usize>(current_phase);
+  allocation_counts[phase].fetch_add(1, std::memory_order_relaxed);
+  byte_counts[phase].fetch_add(size, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) noexcept {
+  record(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment) noexcept {
+  record(size);
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  // aligned_alloc requires the size to be a multiple of the alignment
+  const std::size_t rounded_size = (size + align - 1) / align * align;
+  return std::aligned_alloc(align, rounded_size == 0 ? align : rounded_size);
+}
+
+} // namespace
+
+/* AllocationTracker */
+void AllocationTracker::set_phase(Phase phase) noexcept {
+  current_phase = phase;
+}
+
+AllocationTracker::FrameReport AllocationTracker::end_frame() noexcept {
+  FrameReport report{.frame = running_summary.frames + 1};
+  for (usize i = 0; i < phase_count; i++) {
+    report.phases[i].allocations = allocation_counts[i].exchange(0, std::memory_order_relaxed);
+    report.phases[i].bytes = byte_counts[i].exchange(0, std::memory_order_relaxed);
+  }
+
+  // Update running summary
+  running_summary.frames = report.frame;
+  for (const Counters& counters : report.phases) {
+    running_summary.total.allocations += counters.allocations;
+    running_summary.total.bytes += counters.bytes;
+    if (report.is_steady_state()) {
+      running_summary.steady_state.allocations += counters.allocations;
+      running_summary.steady_state.bytes += counters.bytes;
+    }
+  }
+  if (report.allocations() > running_summary.peak_frame_allocations)
+    running_summary.peak_frame_allocations = report.allocations();
+
+  last_report = report;
+  return report;
+}
+
+const AllocationTracker::FrameReport& AllocationTracker::last_frame() noexcept {
+  return last_report;
+}
+
+AllocationTracker::Summary AllocationTracker::summary() noexcept {
+  return running_summary;
+}
+
+/* Global operator new/delete replacements */
+void* operator new(std::size_t size) {
+  if (void* ptr = allocate(size)) [[likely]]
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  if (void* ptr = allocate(size)) [[likely]]
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (void* ptr = allocate_aligned(size, alignment)) [[likely]]
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  if (void* ptr = allocate_aligned(size, alignment)) [[likely]]
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate_aligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate_aligned(size, alignment); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+#endif
@@ -0,0 +1,103 @@
+#include "core/audio.hpp"
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+/* Sounds */
+std::expected<Audio::SoundId, re::Error<Audio::Error>> Audio::load_wav(const std::string& path) {
+  SDL_AudioSpec source_spec;
+  u8* source_data = nullptr;
+  u32 source_length = 0;
+  if (!SDL_LoadWAV(path.c_str(), &source_spec, &source_data, &source_length)) [[unlikely]]
+    return std::unexpected(re::error(Error::SoundLoading, std::string(SDL_GetError())));
+
+  // Mono f32, the sample rate is kept and resampled by the mixer
+  const SDL_AudioSpec destination_spec{SDL_AUDIO_F32, 1, source_spec.freq};
+  u8* destination_data = nullptr;
+  int destination_length = 0;
+  const bool converted = SDL_ConvertAudioSamples(&source_spec, source_data, static_cast<int>(source_length), &destination_spec, &destination_data, &destination_length);
+  SDL_free(source_data);
+  if (!converted) [[unlikely]]
+    return std::unexpected(re::error(Error::SoundConversion, std::string(SDL_GetError())));
+
+  const f32* samples = reinterpret_cast<const f32*>(destination_data);
+  std::vector<f32> sound_samples(samples, samples + destination_length / sizeof(f32));
+  SDL_free(destination_data);
+
+  return add_sound(std::move(sound_samples), static_cast<u32>(source_spec.freq));
+}
+
+std::expected<Audio::SoundId, re::Error<Audio::Error>> Audio::add_sound(std::vector<f32>&& samples, u32 sample_rate) {
+  _sounds.push_back(std::make_unique<Sound>(std::move(samples), sample_rate));
+  return static_cast<SoundId>(_sounds.size() - 1);
+}
+
+/* Voices */
+std::expected<Audio::VoiceId, re::Error<Audio::Error>> Audio::play(SoundId sound_id) noexcept {
+  return play(sound_id, PlayParameters{});
+}
+
+std::expected<Audio::VoiceId, re::Error<Audio::Error>> Audio::play(SoundId sound_id, const PlayParameters& parameters) noexcept {
+  if (sound_id >= _sounds.size()) [[unlikely]]
+    return std::unexpected(re::error(Error::UnknownSound, "No sound loaded with this id"));
+  const Sound& sound = *_sounds[sound_id];
+
+  // Constant power panning
+  const f32 angle = (std::clamp(parameters.pan, -1.0f, 1.0f) + 1.0f) * std::numbers::pi_v<f32> / 4.0f;
+
+  const VoiceId voice = _next_voice++;
+  if (auto result = push(AudioMixer::Command{
+          .type = AudioMixer::Command::Type::Play,
+          .loop = parameters.loop,
+          .voice = voice,
+          .samples = sound.samples.data(),
+          .length = static_cast<u32>(sound.samples.size()),
+          .step = static_cast<f32>(sound.sample_rate) / static_cast<f32>(_mixer->sample_rate()) * parameters.pitch,
+          .gain_left = parameters.gain * std::cos(angle),
+          .gain_right = parameters.gain * std::sin(angle),
+      });
+      !result) [[unlikely]]
+    return std::unexpected(std::move(result.error()));
+
+  return voice;
+}
+
+re::expected<re::Error<Audio::Error>> Audio::stop(VoiceId voice) noexcept {
+  return push(AudioMixer::Command{.type = AudioMixer::Command::Type::Stop, .voice = voice});
+}
+
+re::expected<re::Error<Audio::Error>> Audio::set_gain(VoiceId voice, f32 gain, f32 pan) noexcept {
+  const f32 angle = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * std::numbers::pi_v<f32> / 4.0f;
+  return push(AudioMixer::Command{
+      .type = AudioMixer::Command::Type::SetGain,
+      .voice = voice,
+      .gain_left = gain * std::cos(angle),
+      .gain_right = gain * std::sin(angle),
+  });
+}
+
+re::expected<re::Error<Audio::Error>> Audio::stop_all() noexcept {
+  return push(AudioMixer::Command{.type = AudioMixer::Command::Type::StopAll});
+}
+
+re::expected<re::Error<Audio::Error>> Audio::push(const AudioMixer::Command& command) noexcept {
+  if (!_mixer->push(command)) [[unlikely]]
+    return std::unexpected(re::error(Error::CommandQueueFull, "The audio command queue is full"));
+  return re::expected<re::Error<Error>>();
+}
+
+/* Audio thread */
+void Audio::callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int UNUSED(total_amount)) {
+  AudioMixer* mixer = static_cast<AudioMixer*>(userdata);
+
+  constexpr usize frame_size = sizeof(f32) * CHANNELS;
+  usize remaining_frames = (static_cast<usize>(additional_amount) + frame_size - 1) / frame_size;
+  while (remaining_frames > 0) {
+    const usize frames = std::min(remaining_frames, mixer->max_frames());
+    SDL_PutAudioStreamData(stream, mixer->mix(frames), static_cast<int>(frames * frame_size));
+    remaining_frames -= frames;
+  }
+}
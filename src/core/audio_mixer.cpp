@@ -0,0 +1,192 @@
+#include "core/audio_mixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+/* Mixing */
+const f32* AudioMixer::mix(usize frames) noexcept {
+  frames = std::min(frames, _max_frames);
+
+  // Commands, drained in batches (one release of the ring per batch)
+  std::array<Command, COMMAND_BATCH> commands;
+  while (const usize count = _commands.try_pop_n(commands)) {
+    for (usize i = 0; i < count; i++)
+      apply(commands[i]);
+  }
+
+  // Voices
+  std::fill_n(_output.data(), frames * 2, 0.0f);
+  u32 active_voices = 0;
+  for (Voice& voice : _voices) {
+    if (!voice.active)
+      continue;
+
+    const bool still_playing = resample(voice, frames);
+    accumulate(voice, frames);
+
+    voice.active = still_playing;
+    active_voices += still_playing;
+  }
+  _active_voices.store(active_voices, std::memory_order_relaxed);
+
+  // Clip
+  f32* output = _output.data();
+  usize i = 0;
+#ifdef __SSE2__
+  const __m128 lower = _mm_set1_ps(-1.0f);
+  const __m128 upper = _mm_set1_ps(1.0f);
+  for (; i + 4 <= frames * 2; i += 4)
+    _mm_storeu_ps(output + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(output + i), lower), upper));
+#endif
+  for (; i < frames * 2; i++)
+    output[i] = std::clamp(output[i], -1.0f, 1.0f);
+
+  return output;
+}
+
+void AudioMixer::apply(const Command& command) noexcept {
+  switch (command.type) {
+    case Command::Type::Play: {
+      auto voice = std::find_if(_voices.begin(), _voices.end(), [](const Voice& voice) { return !voice.active; });
+      if (voice == _voices.end()) [[unlikely]] {
+        _dropped_voices.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      *voice = Voice{
+          .id = command.voice,
+          .samples = command.samples,
+          .length = command.length,
+          .position = 0.0,
+          .step = command.step,
+          .gain_left = command.gain_left,
+          .gain_right = command.gain_right,
+          .loop = command.loop,
+          .active = command.length > 0,
+      };
+      break;
+    }
+    case Command::Type::Stop: {
+      for (Voice& voice : _voices) {
+        if (voice.active && voice.id == command.voice)
+          voice.active = false;
+      }
+      break;
+    }
+    case Command::Type::SetGain: {
+      for (Voice& voice : _voices) {
+        if (voice.active && voice.id == command.voice) {
+          voice.gain_left = command.gain_left;
+          voice.gain_right = command.gain_right;
+        }
+      }
+      break;
+    }
+    case Command::Type::StopAll: {
+      for (Voice& voice : _voices)
+        voice.active = false;
+      break;
+    }
+  }
+}
+
+bool AudioMixer::resample(Voice& voice, usize frames) noexcept {
+  f32* output = _resampled.data();
+  const f64 length = static_cast<f64>(voice.length);
+  usize i = 0;
+
+  // Same rate, straight copies
+  if (voice.step == 1.0f && voice.position == std::floor(voice.position)) {
+    while (i < frames) {
+      const usize start = static_cast<usize>(voice.position);
+      const usize count = std::min<usize>(voice.length - start, frames - i);
+      std::memcpy(output + i, voice.samples + start, count * sizeof(f32));
+      i += count;
+      voice.position += static_cast<f64>(count);
+
+      if (voice.position >= length) {
+        if (!voice.loop) {
+          std::fill(output + i, output + frames, 0.0f);
+          return false;
+        }
+        voice.position = 0.0;
+      }
+    }
+    return true;
+  }
+
+  // Linear interpolation
+#ifdef __SSE2__
+  // 4 frames at once while the 4th one and the sample after it are inside the sound, positions stay f64 so long sounds
+  // keep their pitch. SSE2 has no gather, the samples are loaded one by one and interpolated together
+  const __m128d offsets_low = _mm_setr_pd(0.0, voice.step);
+  const __m128d offsets_high = _mm_setr_pd(2.0 * voice.step, 3.0 * voice.step);
+  const f64 block_end = length - 1.0 - 3.0 * voice.step;
+  alignas(16) std::array<i32, 4> indices;
+  for (; i + 4 <= frames && voice.position < block_end; i += 4) {
+    const __m128d position = _mm_set1_pd(voice.position);
+    const __m128d positions_low = _mm_add_pd(position, offsets_low), positions_high = _mm_add_pd(position, offsets_high);
+    const __m128i indices_low = _mm_cvttpd_epi32(positions_low), indices_high = _mm_cvttpd_epi32(positions_high);
+    const __m128 fractions = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(positions_low, _mm_cvtepi32_pd(indices_low))),
+                                           _mm_cvtpd_ps(_mm_sub_pd(positions_high, _mm_cvtepi32_pd(indices_high))));
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices.data()), _mm_unpacklo_epi64(indices_low, indices_high));
+
+    const f32* samples = voice.samples;
+    const __m128 current = _mm_setr_ps(samples[indices[0]], samples[indices[1]], samples[indices[2]], samples[indices[3]]);
+    const __m128 next = _mm_setr_ps(samples[indices[0] + 1], samples[indices[1] + 1], samples[indices[2] + 1], samples[indices[3] + 1]);
+    _mm_storeu_ps(output + i, _mm_add_ps(current, _mm_mul_ps(_mm_sub_ps(next, current), fractions)));
+
+    voice.position += 4.0 * voice.step;
+  }
+#endif
+
+  for (; i < frames; i++) {
+    if (voice.position >= length) {
+      if (!voice.loop) {
+        std::fill(output + i, output + frames, 0.0f);
+        return false;
+      }
+      voice.position = std::fmod(voice.position, length);
+    }
+
+    const usize index = static_cast<usize>(voice.position);
+    const f32 fraction = static_cast<f32>(voice.position - static_cast<f64>(index));
+    const f32 current = voice.samples[index];
+    const f32 next = index + 1 < voice.length ? voice.samples[index + 1] : (voice.loop ? voice.samples[0] : 0.0f);
+    output[i] = current + (next - current) * fraction;
+
+    voice.position += voice.step;
+  }
+
+  return voice.loop || voice.position < length;
+}
+
+void AudioMixer::accumulate(const Voice& voice, usize frames) noexcept {
+  const f32* input = _resampled.data();
+  f32* output = _output.data();
+  usize i = 0;
+
+#ifdef __SSE2__
+  // 4 mono samples -> 2 stereo pairs per half: (s0 s0 s1 s1) and (s2 s2 s3 s3)
+  const __m128 gains = _mm_setr_ps(voice.gain_left, voice.gain_right, voice.gain_left, voice.gain_right);
+  for (; i + 4 <= frames; i += 4) {
+    const __m128 samples = _mm_loadu_ps(input + i);
+    const __m128 low = _mm_mul_ps(_mm_unpacklo_ps(samples, samples), gains);
+    const __m128 high = _mm_mul_ps(_mm_unpackhi_ps(samples, samples), gains);
+
+    f32* destination = output + i * 2;
+    _mm_storeu_ps(destination, _mm_add_ps(_mm_loadu_ps(destination), low));
+    _mm_storeu_ps(destination + 4, _mm_add_ps(_mm_loadu_ps(destination + 4), high));
+  }
+#endif
+
+  for (; i < frames; i++) {
+    output[i * 2] += input[i] * voice.gain_left;
+    output[i * 2 + 1] += input[i] * voice.gain_right;
+  }
+}
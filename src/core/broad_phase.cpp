@@ -0,0 +1,139 @@
+#include "core/broad_phase.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* Bodies */
+void BroadPhase::resize(usize count) {
+  const usize previous_count = size();
+
+  _min_x.resize(count, 0.0f);
+  _max_x.resize(count, 0.0f);
+  _min_y.resize(count, 0.0f);
+  _max_y.resize(count, 0.0f);
+
+  if (count < previous_count) {
+    std::erase_if(_order, [count](Id id) { return id >= count; });
+  } else {
+    for (usize id = previous_count; id < count; id++)
+      _order.push_back(static_cast<Id>(id));
+  }
+
+  _sorted_min_x.resize(count);
+  _sorted_max_x.resize(count);
+  _sorted_min_y.resize(count);
+  _sorted_max_y.resize(count);
+
+  _full_sort = true;
+}
+
+const std::vector<BroadPhase::Pair>& BroadPhase::update() {
+  sort();
+  sweep();
+  return _pairs;
+}
+
+/* Sort */
+void BroadPhase::sort() {
+  if (_full_sort) {
+    std::ranges::sort(_order, {}, [this](Id id) { return _min_x[id]; });
+    _full_sort = false;
+  }
+
+  // Insertion sort, close to linear on the nearly sorted order of the previous tick
+  for (usize i = 1; i < _order.size(); i++) {
+    const Id id = _order[i];
+    const f32 key = _min_x[id];
+
+    usize j = i;
+    for (; j > 0 && _min_x[_order[j - 1]] > key; j--)
+      _order[j] = _order[j - 1];
+    _order[j] = id;
+  }
+
+  // Gather bounds in sort order
+  for (usize i = 0; i < _order.size(); i++) {
+    const Id id = _order[i];
+    _sorted_min_x[i] = _min_x[id];
+    _sorted_max_x[i] = _max_x[id];
+    _sorted_min_y[i] = _min_y[id];
+    _sorted_max_y[i] = _max_y[id];
+  }
+}
+
+/* Sweep */
+void BroadPhase::sweep() {
+  _pairs.clear();
+
+  const usize count = _order.size();
+  const f32* min_x = _sorted_min_x.data();
+  const f32* min_y = _sorted_min_y.data();
+  const f32* max_y = _sorted_max_y.data();
+
+  for (usize i = 0; i < count; i++) {
+    const f32 body_max_x = _sorted_max_x[i];
+    const f32 body_min_y = _sorted_min_y[i];
+    const f32 body_max_y = _sorted_max_y[i];
+
+    // Candidates are the following bodies starting before this one ends on x
+    // As min_x is sorted, the x test of a batch is true for a prefix of its lanes
+    usize j = i + 1;
+    bool x_overlap_ended = false;
+
+#if defined(__AVX__)
+    const __m256 body_max_x_8 = _mm256_set1_ps(body_max_x);
+    const __m256 body_min_y_8 = _mm256_set1_ps(body_min_y);
+    const __m256 body_max_y_8 = _mm256_set1_ps(body_max_y);
+    for (; j + 8 <= count; j += 8) {
+      const u32 x_mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(min_x + j), body_max_x_8, _CMP_LE_OQ)));
+      if (x_mask == 0) {
+        x_overlap_ended = true;
+        break;
+      }
+
+      const __m256 y_overlap = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(min_y + j), body_max_y_8, _CMP_LE_OQ),
+                                             _mm256_cmp_ps(body_min_y_8, _mm256_loadu_ps(max_y + j), _CMP_LE_OQ));
+      for (u32 mask = x_mask & static_cast<u32>(_mm256_movemask_ps(y_overlap)); mask != 0; mask &= mask - 1)
+        _pairs.push_back(Pair{_order[i], _order[j + std::countr_zero(mask)]});
+
+      if (x_mask != 0xFF) {
+        x_overlap_ended = true;
+        break;
+      }
+    }
+#elif defined(__SSE2__)
+    const __m128 body_max_x_4 = _mm_set1_ps(body_max_x);
+    const __m128 body_min_y_4 = _mm_set1_ps(body_min_y);
+    const __m128 body_max_y_4 = _mm_set1_ps(body_max_y);
+    for (; j + 4 <= count; j += 4) {
+      const u32 x_mask = static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(min_x + j), body_max_x_4)));
+      if (x_mask == 0) {
+        x_overlap_ended = true;
+        break;
+      }
+
+      const __m128 y_overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_y + j), body_max_y_4),
+                                          _mm_cmple_ps(body_min_y_4, _mm_loadu_ps(max_y + j)));
+      for (u32 mask = x_mask & static_cast<u32>(_mm_movemask_ps(y_overlap)); mask != 0; mask &= mask - 1)
+        _pairs.push_back(Pair{_order[i], _order[j + std::countr_zero(mask)]});
+
+      if (x_mask != 0xF) {
+        x_overlap_ended = true;
+        break;
+      }
+    }
+#endif
+
+    // Scalar tail (or whole sweep without SIMD)
+    if (x_overlap_ended)
+      continue;
+    for (; j < count && min_x[j] <= body_max_x; j++) {
+      if (min_y[j] <= body_max_y && body_min_y <= max_y[j])
+        _pairs.push_back(Pair{_order[i], _order[j]});
+    }
+  }
+}
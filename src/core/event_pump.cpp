@@ -0,0 +1,148 @@
+#include "core/event_pump.hpp"
+
+#include <algorithm>
+
+/* Constructor */
+EventPump::EventPump() : _events(CAPACITY) {
+  _slots.reserve(STATE_SLOTS);
+  for (usize i = 0; i < STATE_SLOTS; i++)
+    _slots.push_back(std::make_unique<Slot>());
+  _current.store(_slots.front().get(), std::memory_order_relaxed);
+}
+
+/* Member functions */
+std::span<const SDL_Event> EventPump::pump() noexcept {
+  // Next state in a slot neither published nor pinned, carries the held keys and buttons over
+  // Sequentially consistent with snapshot(): a reader that pinned a slot either is seen here, or sees it replaced
+  const Slot* current = _current.load(std::memory_order_relaxed);
+  const InputState& previous = current->state;
+  auto free_slot = std::ranges::find_if(_slots, [&](const std::unique_ptr<Slot>& slot) { return slot.get() != current && slot->readers.load() == 0; });
+  Slot* next = free_slot != _slots.end() ? free_slot->get() : _slots.emplace_back(std::make_unique<Slot>()).get();
+  InputState& state = next->state;
+  state.frame = ++_frame;
+  state.held = previous.held;
+  state.pressed.reset();
+  state.released.reset();
+  state.mouse_x = previous.mouse_x;
+  state.mouse_y = previous.mouse_y;
+  state.mouse_delta_x = state.mouse_delta_y = 0.0f;
+  state.wheel_x = state.wheel_y = 0.0f;
+  state.mouse_buttons = previous.mouse_buttons;
+
+  /* Drain */
+  SDL_PumpEvents();
+  _count = 0;
+  _received = 0;
+  while (_count < CAPACITY) {
+    // Appended after the merged events, then merged in place (the write position never passes the read position)
+    const usize first = _count;
+    const int drained = SDL_PeepEvents(_events.data() + first, static_cast<int>(std::min(BATCH, CAPACITY - first)), SDL_GETEVENT, SDL_EVENT_FIRST, SDL_EVENT_LAST);
+    if (drained <= 0)
+      break;
+
+    _received += static_cast<usize>(drained);
+    for (usize i = first; i < first + static_cast<usize>(drained); i++) {
+      const SDL_Event event = _events[i];
+      apply(state, event);
+      if (_count == 0 || !merge(_events[_count - 1], event))
+        _events[_count++] = event;
+    }
+  }
+
+  _current.store(next);
+  return std::span<const SDL_Event>(_events.data(), _count);
+}
+
+EventPump::Snapshot EventPump::snapshot() const noexcept {
+  // Pinned, then checked to still be the published one: otherwise the pump may already be rewriting it
+  while (true) {
+    Slot* slot = _current.load();
+    slot->readers.fetch_add(1);
+    if (_current.load() == slot)
+      return Snapshot(slot);
+    slot->readers.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+bool EventPump::merge(SDL_Event& previous, const SDL_Event& event) noexcept {
+  if (previous.type != event.type)
+    return false;
+
+  switch (event.type) {
+    case SDL_EVENT_MOUSE_MOTION: {
+      SDL_MouseMotionEvent& motion = previous.motion;
+      if (motion.windowID != event.motion.windowID || motion.which != event.motion.which)
+        return false;
+      motion.timestamp = event.motion.timestamp;
+      motion.state = event.motion.state;
+      motion.x = event.motion.x;
+      motion.y = event.motion.y;
+      motion.xrel += event.motion.xrel;
+      motion.yrel += event.motion.yrel;
+      return true;
+    }
+    case SDL_EVENT_FINGER_MOTION: {
+      SDL_TouchFingerEvent& finger = previous.tfinger;
+      if (finger.touchID != event.tfinger.touchID || finger.fingerID != event.tfinger.fingerID || finger.windowID != event.tfinger.windowID)
+        return false;
+      finger.timestamp = event.tfinger.timestamp;
+      finger.x = event.tfinger.x;
+      finger.y = event.tfinger.y;
+      finger.dx += event.tfinger.dx;
+      finger.dy += event.tfinger.dy;
+      finger.pressure = event.tfinger.pressure;
+      return true;
+    }
+    case SDL_EVENT_GAMEPAD_AXIS_MOTION: {
+      // Absolute values, the last one wins
+      SDL_GamepadAxisEvent& axis = previous.gaxis;
+      if (axis.which != event.gaxis.which || axis.axis != event.gaxis.axis)
+        return false;
+      axis.timestamp = event.gaxis.timestamp;
+      axis.value = event.gaxis.value;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void EventPump::apply(InputState& state, const SDL_Event& event) noexcept {
+  switch (event.type) {
+    case SDL_EVENT_KEY_DOWN:
+      if (event.key.scancode >= SDL_SCANCODE_COUNT || event.key.repeat)
+        break;
+      state.held.set(event.key.scancode);
+      state.pressed.set(event.key.scancode);
+      break;
+    case SDL_EVENT_KEY_UP:
+      if (event.key.scancode >= SDL_SCANCODE_COUNT)
+        break;
+      state.held.reset(event.key.scancode);
+      state.released.set(event.key.scancode);
+      break;
+    case SDL_EVENT_MOUSE_MOTION:
+      state.mouse_x = event.motion.x;
+      state.mouse_y = event.motion.y;
+      state.mouse_delta_x += event.motion.xrel;
+      state.mouse_delta_y += event.motion.yrel;
+      break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+      if (event.button.button == 0 || event.button.button > 32)
+        break;
+      if (event.button.down)
+        state.mouse_buttons |= u32{1} << (event.button.button - 1);
+      else
+        state.mouse_buttons &= ~(u32{1} << (event.button.button - 1));
+      state.mouse_x = event.button.x;
+      state.mouse_y = event.button.y;
+      break;
+    case SDL_EVENT_MOUSE_WHEEL:
+      state.wheel_x += event.wheel.x;
+      state.wheel_y += event.wheel.y;
+      break;
+    default:
+      break;
+  }
+}
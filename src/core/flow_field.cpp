@@ -0,0 +1,560 @@
+#include "core/flow_field.hpp"
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr u32 INF = FlowField::UNREACHABLE;
+constexpr u32 TILE_SIZE = NavigationGrid::TILE_SIZE;
+
+// Whether an agent on (x, y) can take step: stays in the grid, enters a walkable cell and doesn't cut a wall corner
+[[nodiscard]] bool can_step(const NavigationGrid& grid, u32 x, u32 y, const FlowField::Step& step) noexcept {
+  const i64 next_x = static_cast<i64>(x) + step.dx, next_y = static_cast<i64>(y) + step.dy;
+  if (next_x < 0 || next_y < 0 || next_x >= grid.width() || next_y >= grid.height())
+    return false;
+  if (!grid.is_walkable(grid.cell(static_cast<u32>(next_x), static_cast<u32>(next_y))))
+    return false;
+  return step.dx == 0 || step.dy == 0 ||
+         (grid.is_walkable(grid.cell(static_cast<u32>(next_x), y)) && grid.is_walkable(grid.cell(x, static_cast<u32>(next_y))));
+}
+
+[[nodiscard]] u32 step_target(const NavigationGrid& grid, u32 cell, const FlowField::Step& step) noexcept {
+  return static_cast<u32>(static_cast<i64>(cell) + step.dy * static_cast<i64>(grid.width()) + step.dx);
+}
+
+[[nodiscard]] usize worker_count() noexcept {
+  return std::clamp<usize>(std::thread::hardware_concurrency(), 1, FlowField::MAX_WORKERS);
+}
+
+// Calls add(tile) with the tile of cell and of its 8 neighbors (with duplicates)
+template <typename TAdd>
+void for_tiles_around(const NavigationGrid& grid, u32 cell, TAdd&& add) {
+  const u32 x = cell % grid.width(), y = cell / grid.width();
+  add(grid.tile_of(cell));
+  for (const FlowField::Step& step : FlowField::STEPS) {
+    const i64 next_x = static_cast<i64>(x) + step.dx, next_y = static_cast<i64>(y) + step.dy;
+    if (next_x >= 0 && next_y >= 0 && next_x < grid.width() && next_y < grid.height())
+      add(grid.tile_of(step_target(grid, cell, step)));
+  }
+}
+
+// Threads shared by every field, created with the first one and kept until exit so an update never starts a thread
+// Workers wait on _start, run the work, then meet the caller on _end (like the software rasterizer's)
+// When threads can't be created the pool runs with the ones it got, the caller alone at worst
+class WorkerPool {
+  std::mutex _run_mutex; // One run at a time, fields may be built off the main thread
+  std::barrier<> _start;
+  std::barrier<> _end;
+  std::atomic<bool> _stopping{false};
+  void* _work = nullptr; // Callable of the current run, called through _call
+  void (*_call)(void*) = nullptr;
+  std::vector<std::jthread> _workers;
+
+ public:
+  explicit WorkerPool(usize threads) : _start(static_cast<std::ptrdiff_t>(threads)), _end(static_cast<std::ptrdiff_t>(threads)) {
+    try {
+      _workers.reserve(threads - 1);
+      for (usize i = 1; i < threads; i++)
+        _workers.emplace_back([this] { loop(); });
+    } catch (const std::exception&) {
+      // The missing workers leave the barriers so runs don't wait for them
+      for (usize i = _workers.size() + 1; i < threads; i++) {
+        _start.arrive_and_drop();
+        _end.arrive_and_drop();
+      }
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  ~WorkerPool() {
+    _stopping.store(true, std::memory_order_relaxed);
+    _start.arrive_and_wait();
+    _workers.clear();
+  }
+
+  [[nodiscard]] static WorkerPool& instance() {
+    static WorkerPool pool(worker_count());
+    return pool;
+  }
+
+  // Runs work on every thread of the pool, the calling one included, and returns once all are done
+  // Taken by reference and called through a plain function pointer, a std::function could allocate for big captures
+  template <typename TWork>
+  void run(TWork& work) {
+    const std::scoped_lock lock(_run_mutex);
+    _work = &work;
+    _call = [](void* pointer) { (*static_cast<TWork*>(pointer))(); };
+    _start.arrive_and_wait();
+    work();
+    _end.arrive_and_wait();
+  }
+
+ private:
+  void loop() {
+    while (true) {
+      _start.arrive_and_wait();
+      if (_stopping.load(std::memory_order_relaxed))
+        return;
+      _call(_work);
+      _end.arrive_and_wait();
+    }
+  }
+};
+
+// Label-correcting wavefront over the tiles of a grid, values only decrease
+// A tile is solved by one worker at a time, it only writes its own cells but reads the cells around it. A tile activated
+// while running is flagged dirty and solved again, so a border improvement is never missed
+// Queued tiles are solved closest first (by the distance that woke them up), which keeps tiles from being solved again and
+// again with values that are about to improve
+class Wavefront {
+ public:
+  enum State : u8 {
+    Idle,
+    Queued,
+    Running,
+    RunningDirty
+  };
+
+ private:
+  struct HeapEntry {
+    u32 distance;
+    u32 index; // Cell in a tile, or tile in the queue
+
+    [[nodiscard]] bool operator>(const HeapEntry& other) const noexcept { return distance > other.distance; }
+  };
+
+  const NavigationGrid* _grid = nullptr;
+  std::atomic<u32>* _integration = nullptr;
+  u32 _target = NavigationGrid::NONE;
+  u32 _tile_count;
+  std::unique_ptr<std::atomic<u8>[]> _states;
+  std::unique_ptr<std::atomic<bool>[]> _solved;
+  std::mutex _queue_mutex;
+  std::vector<HeapEntry> _queue; // Min heap, a tile woken up closer while queued is pushed again
+  std::atomic<usize> _pending{0}; // Queued or running tiles
+
+ public:
+  // Buffers for tile_count tiles, kept by the field and reused by every run
+  explicit Wavefront(u32 tile_count)
+      : _tile_count(tile_count), _states(std::make_unique<std::atomic<u8>[]>(tile_count)), _solved(std::make_unique<std::atomic<bool>[]>(tile_count)) {
+    _queue.reserve(2 * tile_count);
+  }
+
+  [[nodiscard]] u32 tile_count() const noexcept { return _tile_count; }
+
+  // Starts a run over grid (of tile_count() tiles), every tile idle and unsolved
+  void begin(const NavigationGrid& grid, std::atomic<u32>* integration, u32 target) noexcept {
+    _grid = &grid;
+    _integration = integration;
+    _target = target;
+    for (u32 tile = 0; tile < _tile_count; tile++) {
+      _states[tile].store(Idle, std::memory_order_relaxed);
+      _solved[tile].store(false, std::memory_order_relaxed);
+    }
+    _queue.clear();
+  }
+
+  [[nodiscard]] bool is_solved(u32 tile) const noexcept { return _solved[tile].load(std::memory_order_relaxed); }
+
+  // distance: smallest value the tile can get from what woke it up
+  void activate(u32 tile, u32 distance) {
+    u8 state = _states[tile].load(std::memory_order_acquire);
+    while (true) {
+      if (state == Idle) {
+        if (_states[tile].compare_exchange_weak(state, Queued, std::memory_order_acq_rel)) {
+          // Counted before it can be popped, the activating tile is still running so workers can't see 0 in between
+          _pending.fetch_add(1, std::memory_order_relaxed);
+          push(tile, distance);
+          return;
+        }
+      } else if (state == Queued) {
+        push(tile, distance);
+        return;
+      } else if (state == Running) {
+        if (_states[tile].compare_exchange_weak(state, RunningDirty, std::memory_order_acq_rel))
+          return;
+      } else {
+        return;
+      }
+    }
+  }
+
+  // Smallest finite value in and around the tile, to queue it before anything woke it up
+  [[nodiscard]] u32 seed_distance(u32 tile) const noexcept {
+    const i64 x0 = (tile % _grid->tiles_x()) * TILE_SIZE, y0 = (tile / _grid->tiles_x()) * TILE_SIZE;
+    const i64 x_end = std::min<i64>(x0 + TILE_SIZE + 1, _grid->width()), y_end = std::min<i64>(y0 + TILE_SIZE + 1, _grid->height());
+    u32 distance = INF;
+    for (i64 y = std::max<i64>(y0 - 1, 0); y < y_end; y++)
+      for (i64 x = std::max<i64>(x0 - 1, 0); x < x_end; x++)
+        distance = std::min(distance, _integration[_grid->cell(static_cast<u32>(x), static_cast<u32>(y))].load(std::memory_order_relaxed));
+    return distance;
+  }
+
+  void work() {
+    while (_pending.load(std::memory_order_acquire) != 0) {
+      u32 tile;
+      {
+        std::unique_lock lock(_queue_mutex);
+        if (_queue.empty()) {
+          lock.unlock();
+          std::this_thread::yield();
+          continue;
+        }
+        std::ranges::pop_heap(_queue, std::greater<>());
+        tile = _queue.back().index;
+        _queue.pop_back();
+      }
+
+      // Stale entry, the tile was pushed again
+      u8 expected = Queued;
+      if (!_states[tile].compare_exchange_strong(expected, Running, std::memory_order_acq_rel))
+        continue;
+      while (true) {
+        solve(tile);
+        expected = Running;
+        if (_states[tile].compare_exchange_strong(expected, Idle, std::memory_order_acq_rel))
+          break;
+        _states[tile].store(Running, std::memory_order_release); // Was dirty
+      }
+      _pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+
+ private:
+  void push(u32 tile, u32 distance) {
+    const std::scoped_lock lock(_queue_mutex);
+    _queue.push_back(HeapEntry{distance, tile});
+    std::ranges::push_heap(_queue, std::greater<>());
+  }
+
+  // Dijkstra restricted to the tile, seeded by its border relaxed from the cells around it
+  // The first solve also seeds every finite cell (cells around reset ones), later ones only the improved border cells: the
+  // rest of the tile is still consistent, only this tile writes it
+  void solve(u32 tile) {
+    thread_local std::vector<u32> distances;
+    thread_local std::vector<HeapEntry> heap;
+
+    const u32 x0 = (tile % _grid->tiles_x()) * TILE_SIZE, y0 = (tile / _grid->tiles_x()) * TILE_SIZE;
+    const u32 width = std::min(TILE_SIZE, _grid->width() - x0), height = std::min(TILE_SIZE, _grid->height() - y0);
+    const auto inside = [&](i64 x, i64 y) { return x >= x0 && y >= y0 && x < x0 + width && y < y0 + height; };
+
+    /* Seeds */
+    const bool first = !_solved[tile].load(std::memory_order_relaxed);
+    distances.assign(width * height, INF);
+    heap.clear();
+    for (u32 local_y = 0; local_y < height; local_y++) {
+      for (u32 local_x = 0; local_x < width; local_x++) {
+        const u32 x = x0 + local_x, y = y0 + local_y, cell = _grid->cell(x, y);
+        if (!_grid->is_walkable(cell))
+          continue;
+
+        const u32 current = _integration[cell].load(std::memory_order_relaxed);
+        u32 distance = current;
+        if (cell != _target && (local_x == 0 || local_y == 0 || local_x == width - 1 || local_y == height - 1)) {
+          for (const FlowField::Step& step : FlowField::STEPS) {
+            if (inside(static_cast<i64>(x) + step.dx, static_cast<i64>(y) + step.dy) || !can_step(*_grid, x, y, step))
+              continue;
+            const u32 next = step_target(*_grid, cell, step);
+            const u32 next_distance = _integration[next].load(std::memory_order_relaxed);
+            if (next_distance != INF)
+              distance = std::min(distance, next_distance + step.weight * _grid->cost(next));
+          }
+        }
+
+        distances[local_y * width + local_x] = distance;
+        if (distance != INF && (first || distance < current))
+          heap.push_back(HeapEntry{distance, local_y * width + local_x});
+      }
+    }
+    if (heap.empty() && !first)
+      return; // Nothing improved around it
+    std::ranges::make_heap(heap, std::greater<>());
+
+    /* Local Dijkstra, backwards: a cell is relaxed from the neighbor it would step into */
+    while (!heap.empty()) {
+      std::ranges::pop_heap(heap, std::greater<>());
+      const HeapEntry entry = heap.back();
+      heap.pop_back();
+      if (entry.distance != distances[entry.index])
+        continue; // Stale
+
+      const u32 x = x0 + entry.index % width, y = y0 + entry.index / width, cell = _grid->cell(x, y);
+      for (const FlowField::Step& step : FlowField::STEPS) {
+        // Neighbor stepping onto cell, the opposite step
+        const i64 from_x = static_cast<i64>(x) - step.dx, from_y = static_cast<i64>(y) - step.dy;
+        if (!inside(from_x, from_y))
+          continue;
+        const u32 from = _grid->cell(static_cast<u32>(from_x), static_cast<u32>(from_y));
+        if (from == _target || !_grid->is_walkable(from) || !can_step(*_grid, static_cast<u32>(from_x), static_cast<u32>(from_y), step))
+          continue;
+
+        const u32 local = static_cast<u32>(from_y - y0) * width + static_cast<u32>(from_x - x0);
+        const u32 distance = entry.distance + step.weight * _grid->cost(cell);
+        if (distance < distances[local]) {
+          distances[local] = distance;
+          heap.push_back(HeapEntry{distance, local});
+          std::ranges::push_heap(heap, std::greater<>());
+        }
+      }
+    }
+
+    /* Write back, waking up the tiles next to improved border cells */
+    std::array<u32, FlowField::STEPS.size()> wake; // Smallest improvement next to each neighbor tile, in STEPS order
+    wake.fill(INF);
+    for (u32 local_y = 0; local_y < height; local_y++) {
+      for (u32 local_x = 0; local_x < width; local_x++) {
+        const u32 cell = _grid->cell(x0 + local_x, y0 + local_y);
+        const u32 distance = distances[local_y * width + local_x];
+        if (distance >= _integration[cell].load(std::memory_order_relaxed))
+          continue;
+
+        _integration[cell].store(distance, std::memory_order_relaxed);
+        for (usize i = 0; i < FlowField::STEPS.size(); i++) {
+          const i32 side_x = FlowField::STEPS[i].dx, side_y = FlowField::STEPS[i].dy;
+          if ((side_x == 0 || local_x == (side_x < 0 ? 0 : width - 1)) && (side_y == 0 || local_y == (side_y < 0 ? 0 : height - 1)))
+            wake[i] = std::min(wake[i], distance);
+        }
+      }
+    }
+    _solved[tile].store(true, std::memory_order_relaxed);
+
+    const i64 tile_x = tile % _grid->tiles_x(), tile_y = tile / _grid->tiles_x();
+    for (usize i = 0; i < FlowField::STEPS.size(); i++) {
+      const i64 next_x = tile_x + FlowField::STEPS[i].dx, next_y = tile_y + FlowField::STEPS[i].dy;
+      if (wake[i] != INF && next_x >= 0 && next_y >= 0 && next_x < _grid->tiles_x() && next_y < _grid->tiles_y())
+        activate(static_cast<u32>(next_y * _grid->tiles_x() + next_x), wake[i]);
+    }
+  }
+};
+
+} // namespace
+
+/* Scratch */
+// Sized for the grid once, so compute() and update() don't allocate afterwards: every cell is reset at most once per
+// update and tiles are listed at most once
+struct FlowField::Scratch {
+  Wavefront wavefront;
+  std::vector<u32> reset; // Cells forgotten by update()
+  std::vector<u32> tiles; // Tiles to run the wavefront from, then tiles to recompute the directions of
+  std::vector<u8> listed; // Per tile, in tiles
+
+  explicit Scratch(const NavigationGrid& grid) : wavefront(grid.tile_count()), listed(grid.tile_count(), 0) {
+    reset.reserve(grid.cell_count());
+    tiles.reserve(grid.tile_count());
+  }
+
+  void add_tile(u32 tile) {
+    if (listed[tile] == 0) {
+      listed[tile] = 1;
+      tiles.push_back(tile);
+    }
+  }
+
+  void clear_tiles() noexcept {
+    for (const u32 tile : tiles)
+      listed[tile] = 0;
+    tiles.clear();
+  }
+};
+
+/* Constructors */
+FlowField::FlowField(const NavigationGrid& grid)
+    : _target(NavigationGrid::NONE),
+      _integration(std::make_unique<std::atomic<u32>[]>(grid.cell_count())),
+      _directions(grid.cell_count(), DIRECTION_NONE),
+      _scratch(std::make_unique<Scratch>(grid)) {
+  for (u32 cell = 0; cell < grid.cell_count(); cell++)
+    _integration[cell].store(INF, std::memory_order_relaxed);
+}
+
+FlowField::FlowField(const NavigationGrid& grid, u32 target) : FlowField(grid) {
+  _target = target;
+  compute(grid);
+}
+
+FlowField::~FlowField() = default;
+
+/* Member functions */
+void FlowField::retarget(const NavigationGrid& grid, u32 target) {
+  // Buffers only change with the grid size
+  if (_directions.size() != grid.cell_count()) {
+    _integration = std::make_unique<std::atomic<u32>[]>(grid.cell_count());
+    _directions.assign(grid.cell_count(), DIRECTION_NONE);
+  }
+  if (_scratch->wavefront.tile_count() != grid.tile_count() || _scratch->reset.capacity() < grid.cell_count())
+    _scratch = std::make_unique<Scratch>(grid);
+
+  _target = target;
+  compute(grid);
+}
+
+void FlowField::compute(const NavigationGrid& grid) {
+  for (u32 cell = 0; cell < grid.cell_count(); cell++)
+    _integration[cell].store(INF, std::memory_order_relaxed);
+  std::ranges::fill(_directions, DIRECTION_NONE);
+  if (_target == NavigationGrid::NONE || !grid.is_walkable(_target))
+    return;
+
+  // The seed isn't an improvement found by a solve, so the tiles around it are queued here: a target on a tile border has
+  // neighbors in tiles its own tile wouldn't wake up
+  _integration[_target].store(0, std::memory_order_relaxed);
+  for_tiles_around(grid, _target, [this](u32 tile) { _scratch->add_tile(tile); });
+  propagate(grid);
+}
+
+void FlowField::update(const NavigationGrid& grid, std::span<const NavigationGrid::Change> changes) {
+  if (changes.empty() || _target == NavigationGrid::NONE)
+    return;
+  // Past a point resetting subtrees costs more than starting over, and a target that was a wall has no seed yet
+  if (changes.size() > grid.cell_count() / 8 || !grid.is_walkable(_target) || !is_reachable(_target)) {
+    compute(grid);
+    return;
+  }
+
+  Scratch& scratch = *_scratch;
+  std::vector<u32>& reset = scratch.reset;
+  reset.clear();
+  const auto reset_cell = [&](u32 cell) {
+    if (cell == _target || _integration[cell].load(std::memory_order_relaxed) == INF)
+      return;
+    _integration[cell].store(INF, std::memory_order_relaxed);
+    reset.push_back(cell);
+  };
+  const auto add_tile = [&](u32 tile) { scratch.add_tile(tile); };
+
+  for (const NavigationGrid::Change& change : changes) {
+    const u8 cost = grid.cost(change.cell);
+    if (cost == change.old_cost)
+      continue;
+    for_tiles_around(grid, change.cell, add_tile);
+    if (cost < change.old_cost)
+      continue; // Only shortens paths, the wavefront lowers the cells around it
+
+    // Paths through the cell got longer (or cut): forget it and the cells whose path goes through it, including
+    // diagonals that now cut a wall corner. The target keeps its 0 but its subtree is walked all the same
+    if (change.cell == _target)
+      reset.push_back(_target);
+    else
+      reset_cell(change.cell);
+    if (cost != NavigationGrid::WALL)
+      continue;
+    const u32 x = change.cell % grid.width(), y = change.cell / grid.width();
+    for (const Step& step : STEPS) {
+      const i64 next_x = static_cast<i64>(x) + step.dx, next_y = static_cast<i64>(y) + step.dy;
+      if (next_x < 0 || next_y < 0 || next_x >= grid.width() || next_y >= grid.height())
+        continue;
+      const u32 next = step_target(grid, change.cell, step);
+      const u8 direction = _directions[next];
+      if (direction >= STEPS.size() || STEPS[direction].dx == 0 || STEPS[direction].dy == 0)
+        continue;
+      // next went diagonally past change.cell if change.cell is one of the two cells beside the step
+      const i64 beside_x = next_x + STEPS[direction].dx, beside_y = next_y + STEPS[direction].dy;
+      if ((beside_x == x && next_y == y) || (next_x == x && beside_y == y))
+        reset_cell(next);
+    }
+  }
+
+  // Subtrees of the reset cells: neighbors whose direction points at a reset cell
+  for (usize i = 0; i < reset.size(); i++) {
+    const u32 cell = reset[i];
+    const u32 x = cell % grid.width(), y = cell / grid.width();
+    for (usize direction = 0; direction < STEPS.size(); direction++) {
+      const i64 from_x = static_cast<i64>(x) - STEPS[direction].dx, from_y = static_cast<i64>(y) - STEPS[direction].dy;
+      if (from_x < 0 || from_y < 0 || from_x >= grid.width() || from_y >= grid.height())
+        continue;
+      const u32 from = grid.cell(static_cast<u32>(from_x), static_cast<u32>(from_y));
+      if (_directions[from] == direction)
+        reset_cell(from);
+    }
+  }
+  for (const u32 cell : reset)
+    scratch.add_tile(grid.tile_of(cell));
+  propagate(grid);
+}
+
+glm::vec2 FlowField::direction(u32 cell) const noexcept {
+  constexpr f32 DIAGONAL = 0.70710678f;
+  static constexpr std::array<glm::vec2, 8> VECTORS{{
+      {1.0f, 0.0f},
+      {DIAGONAL, DIAGONAL},
+      {0.0f, 1.0f},
+      {-DIAGONAL, DIAGONAL},
+      {-1.0f, 0.0f},
+      {-DIAGONAL, -DIAGONAL},
+      {0.0f, -1.0f},
+      {DIAGONAL, -DIAGONAL},
+  }};
+
+  const u8 index = _directions[cell];
+  return index < VECTORS.size() ? VECTORS[index] : glm::vec2(0.0f);
+}
+
+void FlowField::propagate(const NavigationGrid& grid) {
+  Scratch& scratch = *_scratch;
+
+  /* Integration */
+  // Sorted so runs don't depend on the order changes came in
+  std::ranges::sort(scratch.tiles);
+  Wavefront& wavefront = scratch.wavefront;
+  wavefront.begin(grid, _integration.get(), _target);
+  for (const u32 tile : scratch.tiles)
+    wavefront.activate(tile, wavefront.seed_distance(tile));
+  scratch.clear_tiles();
+  auto integrate = [&] { wavefront.work(); };
+  WorkerPool::instance().run(integrate);
+
+  /* Directions, of every solved tile and its neighbors (their cells may point into it) */
+  for (u32 tile = 0; tile < grid.tile_count(); tile++) {
+    if (!wavefront.is_solved(tile))
+      continue;
+    const i64 tile_x = tile % grid.tiles_x(), tile_y = tile / grid.tiles_x();
+    for (i64 y = std::max<i64>(tile_y - 1, 0); y <= std::min<i64>(tile_y + 1, grid.tiles_y() - 1); y++)
+      for (i64 x = std::max<i64>(tile_x - 1, 0); x <= std::min<i64>(tile_x + 1, grid.tiles_x() - 1); x++)
+        scratch.add_tile(static_cast<u32>(y * grid.tiles_x() + x));
+  }
+
+  const std::vector<u32>& dirty = scratch.tiles;
+  std::atomic<usize> next_tile{0};
+  auto orient = [&] {
+    for (usize i = next_tile.fetch_add(1, std::memory_order_relaxed); i < dirty.size(); i = next_tile.fetch_add(1, std::memory_order_relaxed)) {
+      const u32 x0 = (dirty[i] % grid.tiles_x()) * TILE_SIZE, y0 = (dirty[i] / grid.tiles_x()) * TILE_SIZE;
+      const u32 x_end = std::min(x0 + TILE_SIZE, grid.width()), y_end = std::min(y0 + TILE_SIZE, grid.height());
+      for (u32 y = y0; y < y_end; y++) {
+        for (u32 x = x0; x < x_end; x++) {
+          const u32 cell = grid.cell(x, y);
+          if (cell == _target) {
+            _directions[cell] = DIRECTION_TARGET;
+            continue;
+          }
+
+          // Cheapest neighbor, first one on ties
+          u8 best = DIRECTION_NONE;
+          u32 best_distance = INF;
+          if (_integration[cell].load(std::memory_order_relaxed) != INF) {
+            for (usize direction = 0; direction < STEPS.size(); direction++) {
+              if (!can_step(grid, x, y, STEPS[direction]))
+                continue;
+              const u32 next = step_target(grid, cell, STEPS[direction]);
+              const u32 next_distance = _integration[next].load(std::memory_order_relaxed);
+              if (next_distance != INF && next_distance + STEPS[direction].weight * grid.cost(next) < best_distance) {
+                best_distance = next_distance + STEPS[direction].weight * grid.cost(next);
+                best = static_cast<u8>(direction);
+              }
+            }
+          }
+          _directions[cell] = best;
+        }
+      }
+    }
+  };
+  WorkerPool::instance().run(orient);
+  scratch.clear_tiles();
+}
@@ -0,0 +1,56 @@
+#include "core/flow_field_cache.hpp"
+
+#include <algorithm>
+
+void FlowFieldCache::reserve(const NavigationGrid& grid) {
+  for (Entry& entry : _entries)
+    if (entry.field == nullptr)
+      entry.field = std::make_unique<FlowField>(grid);
+}
+
+const FlowField& FlowFieldCache::get(const NavigationGrid& grid, u32 target) {
+  for (Entry& entry : _entries) {
+    if (entry.used && entry.field->target() == target) {
+      entry.last_use = ++_uses;
+      return *entry.field;
+    }
+  }
+
+  // An unused entry, else the least recently used one
+  Entry* slot = &_entries.front();
+  for (Entry& entry : _entries) {
+    if (!entry.used) {
+      slot = &entry;
+      break;
+    }
+    if (entry.last_use < slot->last_use)
+      slot = &entry;
+  }
+
+  if (slot->field == nullptr)
+    slot->field = std::make_unique<FlowField>(grid, target);
+  else
+    slot->field->retarget(grid, target);
+  slot->used = true;
+  slot->last_use = ++_uses;
+  return *slot->field;
+}
+
+void FlowFieldCache::update(NavigationGrid& grid) {
+  if (grid.changes().empty())
+    return;
+
+  for (Entry& entry : _entries)
+    if (entry.used)
+      entry.field->update(grid, grid.changes());
+  grid.clear_changes();
+}
+
+void FlowFieldCache::clear() noexcept {
+  for (Entry& entry : _entries)
+    entry.used = false;
+}
+
+usize FlowFieldCache::size() const noexcept {
+  return static_cast<usize>(std::ranges::count_if(_entries, [](const Entry& entry) { return entry.used; }));
+}
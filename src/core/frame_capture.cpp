@@ -0,0 +1,305 @@
+#include "core/frame_capture.hpp"
+
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_pixels.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_surface.h>
+
+#include <algorithm>
+#include <format>
+#include <system_error>
+
+namespace {
+
+/* PNG */
+constexpr std::array<u32, 256> CRC_TABLE = [] {
+  std::array<u32, 256> table{};
+  for (u32 i = 0; i < 256; i++) {
+    u32 crc = i;
+    for (u32 bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    table[i] = crc;
+  }
+  return table;
+}();
+
+u32 crc32(const u8* data, usize size, u32 crc = 0xFFFFFFFFu) noexcept {
+  for (usize i = 0; i < size; i++)
+    crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+void append_u32_big_endian(std::vector<u8>& out, u32 value) {
+  out.push_back(static_cast<u8>(value >> 24));
+  out.push_back(static_cast<u8>(value >> 16));
+  out.push_back(static_cast<u8>(value >> 8));
+  out.push_back(static_cast<u8>(value));
+}
+
+void append_chunk(std::vector<u8>& out, const char (&type)[5], const u8* data, usize size) {
+  append_u32_big_endian(out, static_cast<u32>(size));
+  const usize type_offset = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data, data + size);
+  append_u32_big_endian(out, crc32(out.data() + type_offset, size + 4) ^ 0xFFFFFFFFu);
+}
+
+// RGBA8 PNG with stored (uncompressed) deflate blocks: larger files but encoding is a few copies
+void encode_png(const u8* pixels, u32 width, u32 height, std::vector<u8>& out, std::vector<u8>& zlib) {
+  constexpr usize MAX_BLOCK_SIZE = 65535;
+  const usize row_size = usize{width} * 4;
+  const usize raw_size = (row_size + 1) * height; // Each row is prefixed by its filter type (0: none)
+
+  // zlib stream
+  zlib.clear();
+  zlib.push_back(0x78);
+  zlib.push_back(0x01);
+
+  u32 adler_a = 1, adler_b = 0;
+  usize row = 0, row_offset = 0; // Position in the filtered data
+  for (usize written = 0; written < raw_size;) {
+    const usize block_size = std::min(MAX_BLOCK_SIZE, raw_size - written);
+    zlib.push_back(written + block_size == raw_size ? 1 : 0);
+    zlib.push_back(static_cast<u8>(block_size));
+    zlib.push_back(static_cast<u8>(block_size >> 8));
+    zlib.push_back(static_cast<u8>(~block_size));
+    zlib.push_back(static_cast<u8>(~block_size >> 8));
+
+    for (usize remaining = block_size; remaining > 0;) {
+      if (row_offset == 0) {
+        // Filter byte
+        zlib.push_back(0);
+        adler_b = (adler_b + adler_a) % 65521;
+        row_offset = 1;
+        remaining--;
+        continue;
+      }
+
+      const usize count = std::min(remaining, row_size + 1 - row_offset);
+      const u8* source = pixels + row * row_size + (row_offset - 1);
+      zlib.insert(zlib.end(), source, source + count);
+      for (usize i = 0; i < count; i++) {
+        adler_a = (adler_a + source[i]) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+      }
+
+      remaining -= count;
+      row_offset += count;
+      if (row_offset == row_size + 1) {
+        row++;
+        row_offset = 0;
+      }
+    }
+    written += block_size;
+  }
+  append_u32_big_endian(zlib, (adler_b << 16) | adler_a);
+
+  // PNG file
+  out.clear();
+  constexpr u8 SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  out.insert(out.end(), std::begin(SIGNATURE), std::end(SIGNATURE));
+
+  u8 header[13];
+  const u32 size[2] = {width, height};
+  for (usize i = 0; i < 2; i++) {
+    header[i * 4 + 0] = static_cast<u8>(size[i] >> 24);
+    header[i * 4 + 1] = static_cast<u8>(size[i] >> 16);
+    header[i * 4 + 2] = static_cast<u8>(size[i] >> 8);
+    header[i * 4 + 3] = static_cast<u8>(size[i]);
+  }
+  header[8] = 8;  // Bit depth
+  header[9] = 6;  // Color type: RGBA
+  header[10] = 0; // Compression
+  header[11] = 0; // Filter
+  header[12] = 0; // Interlace
+  append_chunk(out, "IHDR", header, sizeof(header));
+  append_chunk(out, "IDAT", zlib.data(), zlib.size());
+  append_chunk(out, "IEND", nullptr, 0);
+}
+
+/* Y4M */
+// BT.601 limited range, 4:4:4 planes
+void convert_to_yuv(const u8* pixels, u32 width, u32 height, std::vector<u8>& planes) {
+  const usize pixel_count = usize{width} * height;
+  planes.resize(pixel_count * 3);
+  u8* y_plane = planes.data();
+  u8* u_plane = y_plane + pixel_count;
+  u8* v_plane = u_plane + pixel_count;
+
+  for (usize i = 0; i < pixel_count; i++) {
+    const i32 r = pixels[i * 4], g = pixels[i * 4 + 1], b = pixels[i * 4 + 2];
+    y_plane[i] = static_cast<u8>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    u_plane[i] = static_cast<u8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    v_plane[i] = static_cast<u8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  }
+}
+
+bool write_file(const std::string& path, const u8* data, usize size) {
+  SDL_IOStream* file = SDL_IOFromFile(path.c_str(), "wb");
+  if (file == nullptr)
+    return false;
+
+  const bool written = SDL_WriteIO(file, data, size) == size;
+  return SDL_CloseIO(file) && written;
+}
+
+} // namespace
+
+/* Constructors */
+FrameCapture::FrameCapture(Settings&& settings) : _settings(std::move(settings)) {
+  for (Slot& slot : _slots)
+    slot.pixels.resize(usize{_settings.width} * _settings.height * 4);
+}
+
+FrameCapture::~FrameCapture() {
+  if (_writer.joinable()) {
+    _ready_slots.release();
+    _writer.join();
+  }
+}
+
+std::expected<std::unique_ptr<FrameCapture>, re::Error<FrameCapture::Error>> FrameCapture::create(Settings settings) {
+  if (!SDL_CreateDirectory(settings.directory.c_str())) [[unlikely]]
+    return std::unexpected(re::error(Error::DirectoryCreation, std::string(SDL_GetError())));
+
+  std::unique_ptr<FrameCapture> capture{new FrameCapture(std::move(settings))};
+  try {
+    capture->_writer = std::thread(&FrameCapture::write_loop, capture.get());
+  } catch (const std::system_error& error) {
+    return std::unexpected(re::error(Error::ThreadCreation, std::string(error.what())));
+  }
+
+  return capture;
+}
+
+std::optional<FrameCapture::Settings> FrameCapture::settings_from_environment() {
+  const char* format = SDL_getenv("SDL_TEST_CAPTURE");
+  if (format == nullptr)
+    return std::nullopt;
+
+  Settings settings{};
+  if (SDL_strcasecmp(format, "raw") == 0)
+    settings.format = Format::Raw;
+  else if (SDL_strcasecmp(format, "y4m") == 0)
+    settings.format = Format::Y4m;
+  else
+    settings.format = Format::Png;
+
+  if (const char* directory = SDL_getenv("SDL_TEST_CAPTURE_DIR"); directory != nullptr) {
+    settings.directory = directory;
+    if (!settings.directory.empty() && settings.directory.back() != '/')
+      settings.directory.push_back('/');
+  }
+
+  return settings;
+}
+
+/* Render thread */
+void FrameCapture::capture(SDL_Renderer* renderer) noexcept {
+  _frame++;
+
+  Slot& slot = _slots[_write_index];
+  if (slot.state.load(std::memory_order_acquire) != SlotState::Free) {
+    _dropped_frames.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  SDL_Surface* surface = SDL_RenderReadPixels(renderer, nullptr);
+  if (surface == nullptr) [[unlikely]] {
+    _failed_frames.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Only grows when the output gets bigger than expected
+  const usize size = static_cast<usize>(surface->w) * static_cast<usize>(surface->h) * 4;
+  if (slot.pixels.size() < size) [[unlikely]]
+    slot.pixels.resize(size);
+
+  const bool converted = SDL_ConvertPixels(surface->w, surface->h, surface->format, surface->pixels, surface->pitch,
+                                           SDL_PIXELFORMAT_RGBA32, slot.pixels.data(), surface->w * 4);
+  slot.width = static_cast<u32>(surface->w);
+  slot.height = static_cast<u32>(surface->h);
+  slot.frame = _frame;
+  SDL_DestroySurface(surface);
+
+  if (!converted) [[unlikely]] {
+    _failed_frames.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Hand over to the writer
+  slot.state.store(SlotState::Ready, std::memory_order_release);
+  _write_index = (_write_index + 1) % RING_SIZE;
+  _ready_slots.release();
+}
+
+/* Writer thread */
+void FrameCapture::write_loop() {
+  // Encoding buffers, reused between frames
+  std::vector<u8> encoded;
+  std::vector<u8> scratch;
+
+  // Current Y4M stream
+  SDL_IOStream* stream = nullptr;
+  u32 stream_width = 0, stream_height = 0;
+
+  usize read_index = 0;
+  while (true) {
+    _ready_slots.acquire();
+
+    // Slots are filled in order, a release without ready slot is the stop signal
+    Slot& slot = _slots[read_index];
+    if (slot.state.load(std::memory_order_acquire) != SlotState::Ready)
+      break;
+
+    bool written = false;
+    switch (_settings.format) {
+      case Format::Raw: {
+        const std::string path = std::format("{}frame_{:06}_{}x{}.rgba", _settings.directory, slot.frame, slot.width, slot.height);
+        written = write_file(path, slot.pixels.data(), usize{slot.width} * slot.height * 4);
+        break;
+      }
+      case Format::Png: {
+        encode_png(slot.pixels.data(), slot.width, slot.height, encoded, scratch);
+        written = write_file(std::format("{}frame_{:06}.png", _settings.directory, slot.frame), encoded.data(), encoded.size());
+        break;
+      }
+      case Format::Y4m: {
+        // A Y4M stream has a fixed size, start a new one when the output is resized
+        if (stream == nullptr || stream_width != slot.width || stream_height != slot.height) {
+          if (stream != nullptr)
+            SDL_CloseIO(stream);
+
+          stream_width = slot.width;
+          stream_height = slot.height;
+          stream = SDL_IOFromFile(std::format("{}capture_{}x{}.y4m", _settings.directory, stream_width, stream_height).c_str(), "wb");
+          if (stream != nullptr) {
+            const std::string header = std::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", stream_width, stream_height, _settings.frame_rate);
+            SDL_WriteIO(stream, header.data(), header.size());
+          }
+        }
+
+        if (stream != nullptr) {
+          convert_to_yuv(slot.pixels.data(), slot.width, slot.height, encoded);
+          constexpr char FRAME_HEADER[] = "FRAME\n";
+          written = SDL_WriteIO(stream, FRAME_HEADER, sizeof(FRAME_HEADER) - 1) == sizeof(FRAME_HEADER) - 1 &&
+                    SDL_WriteIO(stream, encoded.data(), encoded.size()) == encoded.size();
+        }
+        break;
+      }
+    }
+
+    if (written)
+      _written_frames.fetch_add(1, std::memory_order_relaxed);
+    else
+      _failed_frames.fetch_add(1, std::memory_order_relaxed);
+
+    slot.state.store(SlotState::Free, std::memory_order_release);
+    read_index = (read_index + 1) % RING_SIZE;
+  }
+
+  if (stream != nullptr)
+    SDL_CloseIO(stream);
+}
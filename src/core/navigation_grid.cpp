@@ -0,0 +1,34 @@
+#include "core/navigation_grid.hpp"
+
+#include <algorithm>
+#include <format>
+
+std::expected<NavigationGrid, re::Error<NavigationGrid::Error>> NavigationGrid::create(u32 width, u32 height, f32 cell_size, u8 cost) {
+  if (width == 0 || height == 0 || cell_size <= 0.0f) [[unlikely]]
+    return std::unexpected(re::error(Error::InvalidSize, std::format("Invalid navigation grid of {}x{} cells of {}", width, height, cell_size)));
+
+  const u32 tiles = ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+  if (tiles > MAX_TILES) [[unlikely]]
+    return std::unexpected(re::error(Error::TooLarge, std::format("Navigation grid of {}x{} cells needs {} tiles, at most {} are supported", width, height, tiles, MAX_TILES)));
+
+  return NavigationGrid(width, height, cell_size, cost);
+}
+
+void NavigationGrid::set_cost(u32 cell, u8 cost) {
+  if (_costs[cell] == cost)
+    return;
+
+  // Only the cost before the first change matters, fields were computed with it
+  if (!_changed.test(cell)) {
+    _changed.set(cell);
+    _changes.push_back(Change{cell, _costs[cell]});
+  }
+  _costs[cell] = cost;
+}
+
+void NavigationGrid::fill_rect(u32 x, u32 y, u32 width, u32 height, u8 cost) {
+  const u32 x_end = std::min(x + width, _width), y_end = std::min(y + height, _height);
+  for (u32 cell_y = y; cell_y < y_end; cell_y++)
+    for (u32 cell_x = x; cell_x < x_end; cell_x++)
+      set_cost(cell(cell_x, cell_y), cost);
+}
@@ -0,0 +1,138 @@
+#include "core/performance_overlay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+namespace {
+
+constexpr SDL_FColor BACKGROUND_COLOR{0.0f, 0.0f, 0.0f, 0.7f};
+constexpr SDL_FColor BUDGET_COLOR{0.4f, 0.4f, 0.4f, 1.0f};
+constexpr SDL_FColor FRAME_COLOR{1.0f, 1.0f, 1.0f, 1.0f};
+constexpr SDL_FColor TEXT_COLOR{1.0f, 1.0f, 1.0f, 1.0f};
+constexpr SDL_FColor OVER_BUDGET_COLOR{1.0f, 0.3f, 0.3f, 1.0f};
+
+struct PhaseStyle {
+  PerformanceOverlay::Phase phase;
+  const char* label;
+  SDL_FColor color;
+};
+
+// Stacked bottom to top in this order
+constexpr std::array<PhaseStyle, 4> PHASE_STYLES{{
+    {PerformanceOverlay::Phase::Input, "input", {0.95f, 0.80f, 0.25f, 1.0f}},
+    {PerformanceOverlay::Phase::Update, "update", {0.30f, 0.60f, 1.00f, 1.0f}},
+    {PerformanceOverlay::Phase::Draw, "draw", {0.35f, 0.85f, 0.40f, 1.0f}},
+    {PerformanceOverlay::Phase::Present, "present", {0.85f, 0.40f, 0.85f, 1.0f}},
+}};
+
+void set_color(SDL_Renderer* renderer, SDL_FColor color) noexcept {
+  SDL_SetRenderDrawColorFloat(renderer, color.r, color.g, color.b, color.a);
+}
+
+// Formats into buffer (truncated if too long) and draws it, returns the width drawn
+template <typename... Args>
+f32 draw_text(SDL_Renderer* renderer, f32 x, f32 y, std::format_string<Args...> format, Args&&... args) noexcept {
+  std::array<char, 96> buffer;
+  const auto result = std::format_to_n(buffer.data(), buffer.size() - 1, format, std::forward<Args>(args)...);
+  *result.out = '\0';
+  SDL_RenderDebugText(renderer, x, y, buffer.data());
+  return static_cast<f32>(result.out - buffer.data()) * SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+}
+
+} // namespace
+
+void PerformanceOverlay::record(const FrameStats& stats) noexcept {
+  _history[_next] = stats;
+  _next = (_next + 1) % HISTORY;
+  _count = std::min(_count + 1, HISTORY);
+}
+
+void PerformanceOverlay::draw(SDL_Renderer* renderer) noexcept {
+  if (!_visible || _count == 0)
+    return;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  const f32 left = MARGIN;
+  const f32 top = MARGIN;
+  const f32 graph_bottom = top + GRAPH_HEIGHT;
+  const auto to_height = [](f32 time) { return std::min(time / GRAPH_RANGE, 1.0f) * GRAPH_HEIGHT; };
+
+  /* Background */
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  set_color(renderer, BACKGROUND_COLOR);
+  const SDL_FRect background{left - 4.0f, top - 4.0f, GRAPH_WIDTH + 8.0f, GRAPH_HEIGHT + 8.0f + LINE_HEIGHT * TEXT_LINES};
+  SDL_RenderFillRect(renderer, &background);
+
+  /* Phase bars, newest on the right */
+  int vertex_count = 0, index_count = 0;
+  for (usize age = 0; age < _count; age++) {
+    const FrameStats& stats = frame(age);
+    const f32 x = left + static_cast<f32>(HISTORY - 1 - age) * BAR_WIDTH;
+
+    f32 bottom = graph_bottom;
+    for (const PhaseStyle& style : PHASE_STYLES) {
+      // Clipped at the top of the graph
+      const f32 height = std::min(stats.phases[static_cast<usize>(style.phase)] / GRAPH_RANGE * GRAPH_HEIGHT, bottom - top);
+      if (height <= 0.0f)
+        continue;
+
+      const int first = vertex_count;
+      _vertices[vertex_count++] = SDL_Vertex{{x, bottom - height}, style.color, {}};
+      _vertices[vertex_count++] = SDL_Vertex{{x + BAR_WIDTH, bottom - height}, style.color, {}};
+      _vertices[vertex_count++] = SDL_Vertex{{x + BAR_WIDTH, bottom}, style.color, {}};
+      _vertices[vertex_count++] = SDL_Vertex{{x, bottom}, style.color, {}};
+      for (int corner : {0, 1, 2, 0, 2, 3})
+        _indices[index_count++] = first + corner;
+      bottom -= height;
+    }
+  }
+  if (index_count > 0)
+    SDL_RenderGeometry(renderer, nullptr, _vertices.data(), vertex_count, _indices.data(), index_count);
+
+  /* Budget lines (60 and 30 fps) */
+  set_color(renderer, BUDGET_COLOR);
+  SDL_RenderLine(renderer, left, graph_bottom - to_height(1000.0f / 60.0f), left + GRAPH_WIDTH, graph_bottom - to_height(1000.0f / 60.0f));
+  SDL_RenderLine(renderer, left, top, left + GRAPH_WIDTH, top);
+
+  /* Frame time */
+  f32 total = 0.0f, worst = 0.0f;
+  for (usize age = 0; age < _count; age++) {
+    const f32 frame_time = frame(age).frame_time;
+    total += frame_time;
+    worst = std::max(worst, frame_time);
+    _line[_count - 1 - age] = SDL_FPoint{left + (static_cast<f32>(HISTORY - 1 - age) + 0.5f) * BAR_WIDTH, graph_bottom - to_height(frame_time)};
+  }
+  set_color(renderer, FRAME_COLOR);
+  SDL_RenderLines(renderer, _line.data(), static_cast<int>(_count));
+
+  /* Numbers of the last frame */
+  const FrameStats& last = frame(0);
+  f32 y = graph_bottom + 6.0f;
+
+  set_color(renderer, TEXT_COLOR);
+  const f32 width = draw_text(renderer, left, y, "frame {:6.2f} ms  avg {:6.2f}  max {:6.2f}  ", last.frame_time, total / static_cast<f32>(_count), worst);
+  set_color(renderer, _cost > COST_BUDGET ? OVER_BUDGET_COLOR : TEXT_COLOR);
+  draw_text(renderer, left + width, y, "overlay {:4.2f}", _cost);
+  y += LINE_HEIGHT;
+
+  f32 x = left;
+  for (const PhaseStyle& style : PHASE_STYLES) {
+    set_color(renderer, style.color);
+    x += draw_text(renderer, x, y, "{} {:.2f}  ", style.label, last.phases[static_cast<usize>(style.phase)]);
+  }
+  y += LINE_HEIGHT;
+
+  set_color(renderer, TEXT_COLOR);
+  if constexpr (AllocationTracker::enabled)
+    draw_text(renderer, left, y, "events {}  allocations {}", last.events, last.allocations);
+  else
+    draw_text(renderer, left, y, "events {}  allocations n/a (SDL_TEST_ALLOCATION_TRACKING)", last.events);
+
+  // SDL batches render commands until present, flushing hands them to the backend here so their execution is timed too
+  // (rasterization with the software renderer, driver submission otherwise, the GPU work itself can't be timed by SDL)
+  // The present right after would have flushed them anyway
+  SDL_FlushRenderer(renderer);
+  _cost = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
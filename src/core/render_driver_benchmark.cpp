@@ -0,0 +1,308 @@
+#include "core/render_driver_benchmark.hpp"
+
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_surface.h>
+#include <SDL3/SDL_version.h>
+#include <SDL3/SDL_video.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <string_view>
+
+namespace {
+
+struct Scene {
+  std::vector<SDL_FRect> rects;
+  std::vector<SDL_FRect> sprites;
+};
+
+// Same scene for every driver, positions from a fixed LCG
+Scene make_scene() {
+  using Benchmark = RenderDriverBenchmark;
+
+  u32 state = 0x12345678u;
+  auto next = [&state](f32 max) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<f32>(state >> 8) / static_cast<f32>(1u << 24) * max;
+  };
+
+  constexpr f32 size = static_cast<f32>(Benchmark::TARGET_SIZE);
+  Scene scene;
+  scene.rects.reserve(Benchmark::RECT_COUNT);
+  for (u32 i = 0; i < Benchmark::RECT_COUNT; i++)
+    scene.rects.push_back(SDL_FRect{next(size), next(size), 2.0f + next(14.0f), 2.0f + next(14.0f)});
+
+  scene.sprites.reserve(Benchmark::SPRITE_COUNT);
+  for (u32 i = 0; i < Benchmark::SPRITE_COUNT; i++)
+    scene.sprites.push_back(SDL_FRect{next(size), next(size), Benchmark::SPRITE_SIZE, Benchmark::SPRITE_SIZE});
+
+  return scene;
+}
+
+using SpritePixels = std::array<u32, RenderDriverBenchmark::SPRITE_SIZE * RenderDriverBenchmark::SPRITE_SIZE>;
+
+// Soft disc, exercises alpha blending
+SpritePixels sprite_pixels() {
+  using Benchmark = RenderDriverBenchmark;
+
+  SpritePixels pixels{};
+  constexpr f32 radius = Benchmark::SPRITE_SIZE / 2.0f;
+  for (u32 y = 0; y < Benchmark::SPRITE_SIZE; y++)
+    for (u32 x = 0; x < Benchmark::SPRITE_SIZE; x++) {
+      const f32 dx = static_cast<f32>(x) + 0.5f - radius, dy = static_cast<f32>(y) + 0.5f - radius;
+      const f32 coverage = std::clamp(radius - SDL_sqrtf(dx * dx + dy * dy), 0.0f, 1.0f);
+      pixels[y * Benchmark::SPRITE_SIZE + x] = 0x00FFFFFFu | (static_cast<u32>(coverage * 255.0f) << 24);
+    }
+
+  return pixels;
+}
+
+SDL_Texture* make_sprite(SDL_Renderer* renderer, const SpritePixels& pixels) {
+  using Benchmark = RenderDriverBenchmark;
+
+  SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, Benchmark::SPRITE_SIZE, Benchmark::SPRITE_SIZE);
+  if (texture == nullptr)
+    return nullptr;
+
+  SDL_UpdateTexture(texture, nullptr, pixels.data(), Benchmark::SPRITE_SIZE * sizeof(u32));
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  return texture;
+}
+
+// Frame time in seconds, nothing if the driver fails to draw
+std::optional<f64> draw_frames(SDL_Renderer* renderer, SDL_Texture* target, SDL_Texture* sprite, Scene& scene) {
+  using Benchmark = RenderDriverBenchmark;
+  using Clock = std::chrono::steady_clock;
+
+  constexpr usize COLOR_BATCHES = 8;
+  constexpr usize batch_size = Benchmark::RECT_COUNT / COLOR_BATCHES;
+  constexpr SDL_Rect sync_rect{0, 0, 1, 1};
+
+  if (!SDL_SetRenderTarget(renderer, target))
+    return std::nullopt;
+
+  Clock::time_point start{};
+  for (u32 frame = 0; frame < Benchmark::WARMUP_FRAMES + Benchmark::MEASURED_FRAMES; frame++) {
+    if (frame == Benchmark::WARMUP_FRAMES)
+      start = Clock::now();
+
+    SDL_SetRenderDrawColor(renderer, 16, 16, 24, 255);
+    SDL_RenderClear(renderer);
+
+    // Batched rects, one draw color per batch
+    for (usize batch = 0; batch < COLOR_BATCHES; batch++) {
+      SDL_SetRenderDrawColor(renderer, static_cast<u8>(64 + batch * 24), static_cast<u8>(200 - batch * 16), 128, 255);
+      SDL_RenderFillRects(renderer, scene.rects.data() + batch * batch_size, static_cast<int>(batch_size));
+    }
+
+    // Blended sprites, moving so no frame is identical
+    for (SDL_FRect& destination : scene.sprites) {
+      destination.x = destination.x + 1.0f >= Benchmark::TARGET_SIZE ? 0.0f : destination.x + 1.0f;
+      SDL_RenderTexture(renderer, sprite, nullptr, &destination);
+    }
+
+    // Reading a pixel back waits for the GPU, otherwise only command submission would be measured
+    SDL_Surface* pixel = SDL_RenderReadPixels(renderer, &sync_rect);
+    if (pixel == nullptr)
+      return std::nullopt;
+    SDL_DestroySurface(pixel);
+  }
+
+  const std::chrono::duration<f64> elapsed = Clock::now() - start;
+  return elapsed.count() / Benchmark::MEASURED_FRAMES;
+}
+
+// Same frames through the rasterizer, the copy to the target is part of the frame time
+std::optional<f64> draw_rasterizer_frames(SDL_Renderer* renderer, SDL_Texture* target, SDL_Texture* sprite, SoftwareRasterizer& rasterizer, Scene& scene) {
+  using Benchmark = RenderDriverBenchmark;
+  using Clock = std::chrono::steady_clock;
+  using Command = SoftwareRasterizer::Command;
+
+  constexpr usize COLOR_BATCHES = 8;
+  constexpr usize batch_size = Benchmark::RECT_COUNT / COLOR_BATCHES;
+  constexpr SDL_Rect sync_rect{0, 0, 1, 1};
+
+  if (!SDL_SetRenderTarget(renderer, target))
+    return std::nullopt;
+
+  Clock::time_point start{};
+  for (u32 frame = 0; frame < Benchmark::WARMUP_FRAMES + Benchmark::MEASURED_FRAMES; frame++) {
+    if (frame == Benchmark::WARMUP_FRAMES)
+      start = Clock::now();
+
+    rasterizer.clear(16, 16, 24);
+
+    for (usize batch = 0; batch < COLOR_BATCHES; batch++) {
+      const SDL_Color color{static_cast<u8>(64 + batch * 24), static_cast<u8>(200 - batch * 16), 128, 255};
+      for (usize i = batch * batch_size; i < (batch + 1) * batch_size; i++)
+        rasterizer.submit(Command{RenderQueue::Type::FillRect, RenderQueue::BlendMode::None, color, nullptr, SDL_FRect{}, scene.rects[i]});
+    }
+
+    for (SDL_FRect& destination : scene.sprites) {
+      destination.x = destination.x + 1.0f >= Benchmark::TARGET_SIZE ? 0.0f : destination.x + 1.0f;
+      rasterizer.submit(Command{RenderQueue::Type::Texture, RenderQueue::BlendMode::Blend, SDL_Color{255, 255, 255, 255}, sprite, SDL_FRect{}, destination});
+    }
+
+    rasterizer.render();
+    if (!rasterizer.present(renderer))
+      return std::nullopt;
+
+    SDL_Surface* pixel = SDL_RenderReadPixels(renderer, &sync_rect);
+    if (pixel == nullptr)
+      return std::nullopt;
+    SDL_DestroySurface(pixel);
+  }
+
+  const std::chrono::duration<f64> elapsed = Clock::now() - start;
+  return elapsed.count() / Benchmark::MEASURED_FRAMES;
+}
+
+} // namespace
+
+/* Benchmark */
+std::optional<f64> RenderDriverBenchmark::measure(const char* driver) {
+  SDL_Window* window = SDL_CreateWindow("Render driver benchmark", TARGET_SIZE, TARGET_SIZE, SDL_WINDOW_HIDDEN);
+  if (window == nullptr)
+    return std::nullopt;
+
+  std::optional<f64> frame_time;
+  if (SDL_Renderer* renderer = SDL_CreateRenderer(window, driver); renderer != nullptr) {
+    SDL_Texture* target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, TARGET_SIZE, TARGET_SIZE);
+    SDL_Texture* sprite = make_sprite(renderer, sprite_pixels());
+    if (target != nullptr && sprite != nullptr) {
+      Scene scene = make_scene();
+      frame_time = draw_frames(renderer, target, sprite, scene);
+    }
+
+    if (sprite != nullptr)
+      SDL_DestroyTexture(sprite);
+    if (target != nullptr)
+      SDL_DestroyTexture(target);
+    SDL_DestroyRenderer(renderer);
+  }
+
+  SDL_DestroyWindow(window);
+  return frame_time;
+}
+
+std::optional<f64> RenderDriverBenchmark::measure_rasterizer(SoftwareRasterizer::Settings settings) {
+  SDL_Window* window = SDL_CreateWindow("Render driver benchmark", TARGET_SIZE, TARGET_SIZE, SDL_WINDOW_HIDDEN);
+  if (window == nullptr)
+    return std::nullopt;
+
+  std::optional<f64> frame_time;
+  if (SDL_Renderer* renderer = SDL_CreateRenderer(window, "software"); renderer != nullptr) {
+    SDL_Texture* target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, TARGET_SIZE, TARGET_SIZE);
+    const SpritePixels pixels = sprite_pixels();
+    SDL_Texture* sprite = make_sprite(renderer, pixels);
+
+    if (target != nullptr && sprite != nullptr) {
+      // Destroyed before the renderer owning its streaming texture
+      if (auto rasterizer = SoftwareRasterizer::create(TARGET_SIZE, TARGET_SIZE, settings)) {
+        (*rasterizer)->add_image(sprite, SDL_PIXELFORMAT_ARGB8888, SPRITE_SIZE, SPRITE_SIZE);
+        (*rasterizer)->update_image(sprite, pixels.data(), SPRITE_SIZE * sizeof(u32));
+
+        Scene scene = make_scene();
+        frame_time = draw_rasterizer_frames(renderer, target, sprite, **rasterizer, scene);
+      }
+    }
+
+    if (sprite != nullptr)
+      SDL_DestroyTexture(sprite);
+    if (target != nullptr)
+      SDL_DestroyTexture(target);
+    SDL_DestroyRenderer(renderer);
+  }
+
+  SDL_DestroyWindow(window);
+  return frame_time;
+}
+
+std::vector<RenderDriverBenchmark::Result> RenderDriverBenchmark::run() {
+  std::vector<Result> results;
+  const int driver_count = SDL_GetNumRenderDrivers();
+  for (int i = 0; i < driver_count; i++) {
+    const char* driver = SDL_GetRenderDriver(i);
+    if (driver == nullptr)
+      continue;
+
+    if (std::optional<f64> frame_time = measure(driver))
+      results.push_back(Result{driver, *frame_time});
+  }
+
+  return results;
+}
+
+/* Selection */
+std::expected<std::string, re::Error<RenderDriverBenchmark::Error>> RenderDriverBenchmark::select() {
+  const std::string path = cache_path();
+  const std::string key = cache_key();
+
+  // Cache: "<key>\n<driver>\n"
+  if (!path.empty()) {
+    usize size = 0;
+    if (char* data = static_cast<char*>(SDL_LoadFile(path.c_str(), &size)); data != nullptr) {
+      const std::string_view content(data, size);
+      const usize key_end = content.find('\n');
+      const usize driver_end = content.find('\n', key_end + 1);
+
+      std::string driver;
+      if (key_end != std::string_view::npos && driver_end != std::string_view::npos && content.substr(0, key_end) == key)
+        driver = content.substr(key_end + 1, driver_end - key_end - 1);
+      SDL_free(data);
+
+      if (!driver.empty())
+        return driver;
+    }
+  }
+
+  // Probe
+  const std::vector<Result> results = run();
+  if (results.empty()) [[unlikely]]
+    return std::unexpected(re::error(Error::NoDriver, "No render driver could run the benchmark"));
+
+  const Result& fastest = *std::ranges::min_element(results, {}, &Result::frame_time);
+
+  // A failed save only means probing again next launch
+  if (!path.empty()) {
+    const std::string content = std::format("{}\n{}\n", key, fastest.driver);
+    SDL_SaveFile(path.c_str(), content.data(), content.size());
+  }
+
+  return fastest.driver;
+}
+
+void RenderDriverBenchmark::invalidate() {
+  if (const std::string path = cache_path(); !path.empty())
+    SDL_RemovePath(path.c_str());
+}
+
+std::string RenderDriverBenchmark::cache_path() {
+  char* pref_path = SDL_GetPrefPath("UnderScroll", "sdl_test");
+  if (pref_path == nullptr)
+    return std::string();
+
+  std::string path = std::format("{}{}", pref_path, CACHE_FILE);
+  SDL_free(pref_path);
+  return path;
+}
+
+std::string RenderDriverBenchmark::cache_key() {
+  const char* video_driver = SDL_GetCurrentVideoDriver();
+  std::string key = std::format("sdl={};video={};render=", SDL_GetVersion(), video_driver != nullptr ? video_driver : "none");
+
+  const int driver_count = SDL_GetNumRenderDrivers();
+  for (int i = 0; i < driver_count; i++) {
+    if (i != 0)
+      key.push_back(',');
+    if (const char* driver = SDL_GetRenderDriver(i); driver != nullptr)
+      key.append(driver);
+  }
+
+  return key;
+}
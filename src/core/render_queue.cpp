@@ -0,0 +1,206 @@
+#include "core/render_queue.hpp"
+
+#include "core/software_rasterizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+
+constexpr SDL_BlendMode to_sdl_blend_mode(RenderQueue::BlendMode blend) noexcept {
+  switch (blend) {
+    case RenderQueue::BlendMode::None: return SDL_BLENDMODE_NONE;
+    case RenderQueue::BlendMode::Blend: return SDL_BLENDMODE_BLEND;
+    case RenderQueue::BlendMode::Add: return SDL_BLENDMODE_ADD;
+    case RenderQueue::BlendMode::Mod: return SDL_BLENDMODE_MOD;
+    case RenderQueue::BlendMode::Mul: return SDL_BLENDMODE_MUL;
+  }
+  return SDL_BLENDMODE_NONE;
+}
+
+constexpr bool operator==(const SDL_Color& lhs, const SDL_Color& rhs) noexcept {
+  return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+}
+
+} // namespace
+
+/* Submission */
+void RenderQueue::submit(u64 key, const Command& command) {
+  _entries.push_back(Entry{key, static_cast<u32>(_commands.size())});
+  _commands.push_back(command);
+}
+
+void RenderQueue::fill_rect(const SDL_FRect& rect, SDL_Color color, u8 layer, u32 depth, BlendMode blend) {
+  submit(SortKey::make(layer, blend, 0, depth), Command{Type::FillRect, blend, color, nullptr, {}, rect});
+}
+
+void RenderQueue::rect(const SDL_FRect& rect, SDL_Color color, u8 layer, u32 depth, BlendMode blend) {
+  submit(SortKey::make(layer, blend, 0, depth), Command{Type::Rect, blend, color, nullptr, {}, rect});
+}
+
+void RenderQueue::line(f32 x1, f32 y1, f32 x2, f32 y2, SDL_Color color, u8 layer, u32 depth, BlendMode blend) {
+  submit(SortKey::make(layer, blend, 0, depth), Command{Type::Line, blend, color, nullptr, {}, {x1, y1, x2, y2}});
+}
+
+void RenderQueue::texture(SDL_Texture* texture, const SDL_FRect* source, const SDL_FRect& destination, u8 layer, u32 depth, BlendMode blend, SDL_Color modulation) {
+  submit(SortKey::make(layer, blend, texture_id(texture), depth),
+         Command{Type::Texture, blend, modulation, texture, source != nullptr ? *source : SDL_FRect{}, destination});
+}
+
+void RenderQueue::texture_rotated(SDL_Texture* texture, const SDL_FRect* source, const SDL_FRect& destination, f32 angle, u8 layer, u32 depth, BlendMode blend, SDL_Color modulation) {
+  submit(SortKey::make(layer, blend, texture_id(texture), depth),
+         Command{Type::Texture, blend, modulation, texture, source != nullptr ? *source : SDL_FRect{}, destination, angle});
+}
+
+u32 RenderQueue::texture_id(SDL_Texture* texture) {
+  // Few textures per frame, a linear search is cheaper than hashing
+  // Id 0 is reserved for untextured commands
+  for (usize i = 0; i < _textures.size(); i++) {
+    if (_textures[i] == texture)
+      return static_cast<u32>(i + 1);
+  }
+
+  _textures.push_back(texture);
+  return static_cast<u32>(_textures.size());
+}
+
+/* Flush */
+void RenderQueue::flush(SDL_Renderer* renderer) {
+  _stats = Stats{.commands = _commands.size()};
+  if (_commands.empty())
+    return;
+
+  sort();
+
+  // Current renderer state, unknown at first
+  bool has_draw_state = false;
+  SDL_Color draw_color{};
+  BlendMode draw_blend{};
+  const Command* last_texture_command = nullptr;
+
+  const auto set_draw_state = [&](const Command& command) {
+    if (!has_draw_state || draw_blend != command.blend) {
+      SDL_SetRenderDrawBlendMode(renderer, to_sdl_blend_mode(command.blend));
+      draw_blend = command.blend;
+      _stats.state_changes++;
+    }
+    if (!has_draw_state || !(draw_color == command.color)) {
+      SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+      draw_color = command.color;
+      _stats.state_changes++;
+    }
+    has_draw_state = true;
+  };
+
+  usize i = 0;
+  while (i < _entries.size()) {
+    const Command& command = _commands[_entries[i].index];
+
+    switch (command.type) {
+      case Type::FillRect:
+      case Type::Rect: {
+        set_draw_state(command);
+
+        // Merge following rects sharing the same type and state
+        _rect_batch.clear();
+        for (; i < _entries.size(); i++) {
+          const Command& next = _commands[_entries[i].index];
+          if (next.type != command.type || next.blend != command.blend || !(next.color == command.color))
+            break;
+          _rect_batch.push_back(next.destination);
+        }
+
+        if (command.type == Type::FillRect)
+          SDL_RenderFillRects(renderer, _rect_batch.data(), static_cast<int>(_rect_batch.size()));
+        else
+          SDL_RenderRects(renderer, _rect_batch.data(), static_cast<int>(_rect_batch.size()));
+        _stats.draw_calls++;
+        break;
+      }
+      case Type::Line: {
+        set_draw_state(command);
+        SDL_RenderLine(renderer, command.destination.x, command.destination.y, command.destination.w, command.destination.h);
+        _stats.draw_calls++;
+        i++;
+        break;
+      }
+      case Type::Texture: {
+        // Texture state lives on the texture itself
+        if (last_texture_command == nullptr || last_texture_command->texture != command.texture ||
+            last_texture_command->blend != command.blend || !(last_texture_command->color == command.color)) {
+          SDL_SetTextureBlendMode(command.texture, to_sdl_blend_mode(command.blend));
+          SDL_SetTextureColorMod(command.texture, command.color.r, command.color.g, command.color.b);
+          SDL_SetTextureAlphaMod(command.texture, command.color.a);
+          _stats.state_changes++;
+        }
+        last_texture_command = &command;
+
+        const bool whole_texture = command.source.w == 0.0f || command.source.h == 0.0f;
+        if (command.angle != 0.0f)
+          SDL_RenderTextureRotated(renderer, command.texture, whole_texture ? nullptr : &command.source, &command.destination, command.angle, nullptr, SDL_FLIP_NONE);
+        else
+          SDL_RenderTexture(renderer, command.texture, whole_texture ? nullptr : &command.source, &command.destination);
+        _stats.draw_calls++;
+        i++;
+        break;
+      }
+    }
+  }
+
+  clear();
+}
+
+void RenderQueue::flush(SoftwareRasterizer& rasterizer) {
+  // One draw call: the whole frame is a single texture upload
+  _stats = Stats{.commands = _commands.size(), .draw_calls = _commands.empty() ? 0u : 1u};
+
+  sort();
+  for (const Entry& entry : _entries)
+    rasterizer.submit(_commands[entry.index]);
+  rasterizer.render(); // Even without commands, a clear may be pending
+
+  clear();
+}
+
+void RenderQueue::clear() noexcept {
+  _commands.clear();
+  _entries.clear();
+  _textures.clear();
+}
+
+/* Sort */
+// LSD radix sort on the 64-bit keys, one byte per pass
+// Stable, so commands with equal keys keep their submission order
+// Passes where every key has the same byte are skipped (e.g. unused layers or depth)
+void RenderQueue::sort() {
+  const usize count = _entries.size();
+  if (count < 2)
+    return;
+
+  constexpr usize PASSES = sizeof(u64);
+  std::array<std::array<u32, 256>, PASSES> histograms{};
+  for (const Entry& entry : _entries) {
+    for (usize pass = 0; pass < PASSES; pass++)
+      histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+  }
+
+  _scratch.resize(count);
+  for (usize pass = 0; pass < PASSES; pass++) {
+    std::array<u32, 256>& histogram = histograms[pass];
+    const u32 shift = static_cast<u32>(pass * 8);
+
+    if (histogram[(_entries[0].key >> shift) & 0xFF] == count)
+      continue;
+
+    // Counts to offsets
+    u32 offset = 0;
+    for (u32& bucket : histogram)
+      offset += std::exchange(bucket, offset);
+
+    for (const Entry& entry : _entries)
+      _scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+
+    std::swap(_entries, _scratch);
+  }
+}
@@ -1,14 +1,275 @@
 #include "core/renderer.hpp"
 
+#include <SDL3/SDL_hints.h>
+
+#include <algorithm>
+#include <cmath>
+
 SDL_Renderer* Renderer::get_raw() const {
   return _renderer;
 }
 
+RenderQueue& Renderer::queue() const {
+  return _queue;
+}
+
 void Renderer::clear(u8 r, u8 g, u8 b, u8 a) const {
+  if (_software != nullptr) {
+    _software->clear(r, g, b, a);
+    return;
+  }
+
   SDL_SetRenderDrawColor(_renderer, r, g, b, a);
   SDL_RenderClear(_renderer);
 }
 
-void Renderer::present() const {
+void Renderer::begin_frame() {
+  if (_software != nullptr) {
+    int width = 0, height = 0;
+    SDL_GetCurrentRenderOutputSize(_renderer, &width, &height);
+    // Out of memory for the new size, fall back to the SDL renderer
+    if (!_software->resize(static_cast<u32>(width), static_cast<u32>(height))) [[unlikely]]
+      disable_software_rasterizer();
+
+    _software_resolved = false;
+    return;
+  }
+
+  if (!_resolution)
+    return;
+
+  // The target can't follow the output size anymore, draw directly
+  if (!update_target()) [[unlikely]] {
+    disable_dynamic_resolution();
+    return;
+  }
+
+  _frame_start = std::chrono::steady_clock::now();
+  const f32 scale = static_cast<f32>(_resolution->scale());
+  SDL_SetRenderTarget(_renderer, _target);
+  SDL_SetRenderScale(_renderer, scale, scale);
+}
+
+void Renderer::resolve() {
+  if (_software != nullptr) {
+    // Once per frame, the overlay draws over the copied framebuffer
+    if (!_software_resolved) {
+      _queue.flush(*_software);
+      _software->present(_renderer);
+      _software_resolved = true;
+    }
+    return;
+  }
+
+  _queue.flush(_renderer);
+
+  if (_resolution && _target != nullptr && SDL_GetRenderTarget(_renderer) == _target) {
+    // Upscale the drawn part of the target to the window
+    // Linear filtering blends the last drawn texels with their right and bottom neighbors, so the last drawn column and
+    // row are copied into them first (a 1 texel guard band): the edges are clamped and the whole drawn part is shown
+    f32 width = 0.0f, height = 0.0f;
+    SDL_GetTextureSize(_target, &width, &height);
+    const f32 scale = static_cast<f32>(_resolution->scale());
+    const f32 drawn_width = std::max(std::floor(width * scale), 1.0f), drawn_height = std::max(std::floor(height * scale), 1.0f);
+
+    // Texel to texel copies, through the guard textures since a texture can't be drawn onto itself
+    SDL_BlendMode blend = SDL_BLENDMODE_BLEND;
+    SDL_GetTextureBlendMode(_target, &blend);
+    SDL_SetTextureBlendMode(_target, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(_target, SDL_SCALEMODE_NEAREST);
+    const auto copy_edge = [&](SDL_Texture* guard, const SDL_FRect& edge, const SDL_FRect& band) {
+      const SDL_FRect guarded{0.0f, 0.0f, edge.w, edge.h};
+      SDL_SetRenderTarget(_renderer, guard);
+      SDL_SetRenderScale(_renderer, 1.0f, 1.0f);
+      SDL_RenderTexture(_renderer, _target, &edge, &guarded);
+      SDL_SetRenderTarget(_renderer, _target);
+      SDL_SetRenderScale(_renderer, 1.0f, 1.0f);
+      SDL_RenderTexture(_renderer, guard, &guarded, &band);
+    };
+    if (drawn_width < width)
+      copy_edge(_guard_column, {drawn_width - 1.0f, 0.0f, 1.0f, drawn_height}, {drawn_width, 0.0f, 1.0f, drawn_height});
+    if (drawn_height < height) {
+      // Includes the corner texel of the column band
+      const f32 row_width = std::min(drawn_width + 1.0f, width);
+      copy_edge(_guard_row, {0.0f, drawn_height - 1.0f, row_width, 1.0f}, {0.0f, drawn_height, row_width, 1.0f});
+    }
+    SDL_SetTextureScaleMode(_target, SDL_SCALEMODE_LINEAR);
+    SDL_SetTextureBlendMode(_target, blend);
+
+    const SDL_FRect source{0.0f, 0.0f, drawn_width, drawn_height};
+    SDL_SetRenderTarget(_renderer, nullptr);
+    SDL_RenderTexture(_renderer, _target, &source, nullptr);
+
+    // Batched commands run here, the vsync wait in SDL_RenderPresent isn't render time
+    SDL_FlushRenderer(_renderer);
+    _resolution->update(std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - _frame_start).count());
+  }
+}
+
+void Renderer::present() {
+  resolve();
+  if (_capture != nullptr)
+    _capture->capture(_renderer);
   SDL_RenderPresent(_renderer);
 }
+
+re::expected<re::Error<Renderer::Error>> Renderer::start_capture(FrameCapture::Settings settings) {
+  if (settings.width == 0 || settings.height == 0) {
+    int width = 0, height = 0;
+    SDL_GetCurrentRenderOutputSize(_renderer, &width, &height);
+    settings.width = static_cast<u32>(width);
+    settings.height = static_cast<u32>(height);
+  }
+
+  auto capture = FrameCapture::create(std::move(settings));
+  if (!capture) [[unlikely]]
+    return std::unexpected(re::error(Error::CaptureStart, "Failed to start frame capture", std::move(capture.error())));
+
+  _capture = std::move(*capture);
+  return re::expected<re::Error<Error>>();
+}
+
+void Renderer::stop_capture() {
+  _capture.reset();
+}
+
+const FrameCapture* Renderer::capture() const noexcept {
+  return _capture.get();
+}
+
+re::expected<re::Error<Renderer::Error>> Renderer::enable_dynamic_resolution(ResolutionController::Settings settings) {
+  _resolution.emplace(settings);
+  if (!update_target()) [[unlikely]] {
+    _resolution.reset();
+    return std::unexpected(re::error(Error::TargetCreation, std::string(SDL_GetError())));
+  }
+
+  return re::expected<re::Error<Error>>();
+}
+
+void Renderer::disable_dynamic_resolution() {
+  if (_target != nullptr && SDL_GetRenderTarget(_renderer) == _target)
+    SDL_SetRenderTarget(_renderer, nullptr);
+  destroy_target();
+  _resolution.reset();
+}
+
+const ResolutionController* Renderer::resolution() const noexcept {
+  return _resolution ? &*_resolution : nullptr;
+}
+
+re::expected<re::Error<Renderer::Error>> Renderer::enable_software_rasterizer(SoftwareRasterizer::Settings settings) {
+  int width = 0, height = 0;
+  SDL_GetCurrentRenderOutputSize(_renderer, &width, &height);
+
+  auto rasterizer = SoftwareRasterizer::create(static_cast<u32>(width), static_cast<u32>(height), settings);
+  if (!rasterizer) [[unlikely]]
+    return std::unexpected(re::error(Error::SoftwareRasterizer, "Failed to create the software rasterizer", std::move(rasterizer.error())));
+
+  // Textures created before only get their CPU copy on their next update_texture()
+  _textures.for_each([&](TextureHandle, SDL_Texture* texture) { (*rasterizer)->add_image(texture, texture->format, static_cast<u32>(texture->w), static_cast<u32>(texture->h)); });
+
+  disable_dynamic_resolution();
+  _software = std::move(*rasterizer);
+  _software_resolved = false;
+  return re::expected<re::Error<Error>>();
+}
+
+void Renderer::disable_software_rasterizer() {
+  _software.reset();
+}
+
+const SoftwareRasterizer* Renderer::software_rasterizer() const noexcept {
+  return _software.get();
+}
+
+std::expected<Renderer::TextureHandle, re::Error<Renderer::Error>> Renderer::create_texture(SDL_PixelFormat format, SDL_TextureAccess access, u32 width, u32 height) {
+  SDL_Texture* texture = SDL_CreateTexture(_renderer, format, access, static_cast<int>(width), static_cast<int>(height));
+  if (texture == nullptr) [[unlikely]]
+    return std::unexpected(re::error(Error::TextureCreation, std::string(SDL_GetError())));
+
+  if (_software != nullptr)
+    _software->add_image(texture, format, width, height);
+  return _textures.emplace(texture);
+}
+
+bool Renderer::update_texture(TextureHandle handle, const void* pixels, int pitch) {
+  SDL_Texture* const* texture = _textures.get(handle);
+  if (texture == nullptr)
+    return false;
+
+  if (_software != nullptr)
+    _software->update_image(*texture, pixels, pitch);
+  return SDL_UpdateTexture(*texture, nullptr, pixels, pitch);
+}
+
+void Renderer::destroy_texture(TextureHandle handle) {
+  if (SDL_Texture* const* texture = _textures.get(handle)) {
+    if (_software != nullptr)
+      _software->remove_image(*texture);
+    SDL_DestroyTexture(*texture);
+    _textures.erase(handle);
+  }
+}
+
+SDL_Texture* Renderer::texture(TextureHandle handle) const noexcept {
+  SDL_Texture* const* texture = _textures.get(handle);
+  return texture != nullptr ? *texture : nullptr;
+}
+
+bool Renderer::update_target() {
+  int width = 0, height = 0;
+  SDL_GetCurrentRenderOutputSize(_renderer, &width, &height);
+
+  if (_target != nullptr) {
+    f32 target_width = 0.0f, target_height = 0.0f;
+    SDL_GetTextureSize(_target, &target_width, &target_height);
+    if (static_cast<int>(target_width) == width && static_cast<int>(target_height) == height)
+      return true;
+
+    destroy_target();
+  }
+
+  _target = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+  _guard_column = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, 1, height);
+  _guard_row = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, 1);
+  if (_target == nullptr || _guard_column == nullptr || _guard_row == nullptr) [[unlikely]] {
+    destroy_target();
+    return false;
+  }
+
+  // Bilinear upscale, exact copies of the edges
+  SDL_SetTextureScaleMode(_target, SDL_SCALEMODE_LINEAR);
+  SDL_SetTextureScaleMode(_guard_column, SDL_SCALEMODE_NEAREST);
+  SDL_SetTextureScaleMode(_guard_row, SDL_SCALEMODE_NEAREST);
+  SDL_SetTextureBlendMode(_guard_column, SDL_BLENDMODE_NONE);
+  SDL_SetTextureBlendMode(_guard_row, SDL_BLENDMODE_NONE);
+  return true;
+}
+
+void Renderer::destroy_target() noexcept {
+  for (SDL_Texture** texture : {&_target, &_guard_column, &_guard_row}) {
+    if (*texture != nullptr)
+      SDL_DestroyTexture(*texture);
+    *texture = nullptr;
+  }
+}
+
+std::expected<Renderer, re::Error<Renderer::Error>> Renderer::create_auto(Window& window) {
+  // An explicit SDL_RENDER_DRIVER wins over the benchmark
+  if (SDL_GetHint(SDL_HINT_RENDER_DRIVER) != nullptr)
+    return create(window, Driver::Default);
+
+  // Without any usable driver in the benchmark, let SDL decide
+  std::expected<std::string, re::Error<RenderDriverBenchmark::Error>> driver = RenderDriverBenchmark::select();
+  if (!driver) [[unlikely]]
+    return create(window, Driver::Default);
+
+  SDL_Renderer* renderer = SDL_CreateRenderer(window.get_raw(), driver->c_str());
+  if (renderer != nullptr)
+    return Renderer(renderer);
+
+  // The cached driver doesn't work anymore (e.g. the window needs other flags), probe again next launch
+  RenderDriverBenchmark::invalidate();
+  return create(window, Driver::Default);
+}
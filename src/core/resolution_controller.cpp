@@ -0,0 +1,43 @@
+#include "core/resolution_controller.hpp"
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+std::optional<ResolutionController::Settings> ResolutionController::settings_from_environment() {
+  const char* budget = SDL_getenv("SDL_TEST_DYNAMIC_RESOLUTION");
+  if (budget == nullptr)
+    return std::nullopt;
+
+  Settings settings{};
+  if (const f64 value = SDL_atof(budget); value > 0.0)
+    settings.budget = value;
+  return settings;
+}
+
+bool ResolutionController::update(f64 frame_time) noexcept {
+  _samples[_sample_count++] = frame_time;
+  if (_sample_count < WINDOW_SIZE)
+    return false;
+
+  _sample_count = 0;
+  _last_average = std::accumulate(_samples.begin(), _samples.end(), 0.0) / static_cast<f64>(WINDOW_SIZE);
+
+  f64 scale = _scale;
+  if (_last_average > _settings.budget) {
+    // At least one step down, rounded down
+    const f64 target = _scale * std::max(std::sqrt(_settings.budget / _last_average), 1.0 - MAX_DROP);
+    scale = std::min(std::floor(target / STEP) * STEP, _scale - STEP);
+  } else if (_last_average < _settings.budget * RAISE_THRESHOLD) {
+    scale = _scale + STEP;
+  }
+
+  scale = std::clamp(scale, _settings.min_scale, _settings.max_scale);
+  if (scale == _scale)
+    return false;
+
+  _scale = scale;
+  return true;
+}
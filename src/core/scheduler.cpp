@@ -0,0 +1,163 @@
+#include "core/scheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <new>
+
+namespace {
+
+// Task frames, recycled per power of two size class (64 B to 4 KiB) and carved from 64 KiB chunks
+// Main thread only, chunks are kept until exit
+class FramePool {
+ public:
+  static constexpr usize MIN_BLOCK = 64;
+  static constexpr usize CLASS_COUNT = 7;
+  static constexpr usize MAX_BLOCK = MIN_BLOCK << (CLASS_COUNT - 1);
+  static constexpr usize CHUNK_SIZE = 64 * 1024;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  std::array<FreeBlock*, CLASS_COUNT> _free{};
+  std::vector<std::unique_ptr<std::byte[]>> _chunks;
+  std::byte* _cursor = nullptr;
+  usize _remaining = 0;
+
+ public:
+  [[nodiscard]] void* allocate(usize size) {
+    if (size > MAX_BLOCK) [[unlikely]]
+      return ::operator new(size);
+
+    const usize size_class = class_of(size);
+    if (FreeBlock* block = _free[size_class]) {
+      _free[size_class] = block->next;
+      return block;
+    }
+
+    const usize block_size = MIN_BLOCK << size_class;
+    if (_remaining < block_size) {
+      // The end of the previous chunk is lost, at most MAX_BLOCK - MIN_BLOCK bytes
+      _chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(CHUNK_SIZE));
+      _cursor = _chunks.back().get();
+      _remaining = CHUNK_SIZE;
+    }
+
+    void* block = _cursor;
+    _cursor += block_size;
+    _remaining -= block_size;
+    return block;
+  }
+
+  void deallocate(void* pointer, usize size) noexcept {
+    if (size > MAX_BLOCK) [[unlikely]] {
+      ::operator delete(pointer, size);
+      return;
+    }
+
+    const usize size_class = class_of(size);
+    _free[size_class] = ::new (pointer) FreeBlock{_free[size_class]};
+  }
+
+ private:
+  [[nodiscard]] static usize class_of(usize size) noexcept { return static_cast<usize>(std::bit_width((std::max(size, usize{1}) - 1) / MIN_BLOCK)); }
+};
+
+FramePool& frame_pool() {
+  static FramePool pool;
+  return pool;
+}
+
+} // namespace
+
+thread_local Scheduler* Scheduler::_current = nullptr;
+
+/* Task */
+void* Task::promise_type::operator new(usize size) {
+  return frame_pool().allocate(size);
+}
+
+void Task::promise_type::operator delete(void* pointer, usize size) noexcept {
+  frame_pool().deallocate(pointer, size);
+}
+
+std::coroutine_handle<> Task::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+  if (std::coroutine_handle<> continuation = handle.promise().continuation)
+    return continuation;
+
+  Scheduler::_current->retire(handle);
+  return std::noop_coroutine();
+}
+
+/* Scheduler */
+void Scheduler::spawn(Task&& task) {
+  std::coroutine_handle<Task::promise_type> handle = std::exchange(task._handle, nullptr);
+  if (!handle) [[unlikely]]
+    return;
+
+  handle.promise().root_index = _tasks.size();
+  _tasks.push_back(handle);
+  _next_frame.push_back(handle);
+}
+
+void Scheduler::run(f64 delta_time) {
+  const Clock::time_point start = Clock::now();
+  _frame++;
+  _time += delta_time / 1000.0;
+
+  /* Wake up */
+  // Carried over tasks stay ahead of the ones becoming ready now
+  _ready.insert(_ready.end(), _next_frame.begin(), _next_frame.end());
+  _next_frame.clear();
+
+  while (!_timers.empty() && _timers.top().wake_time <= _time) {
+    _ready.push_back(_timers.top().handle);
+    _timers.pop();
+  }
+
+  std::erase_if(_waiting, [this](const Waiting& waiting) {
+    if (!waiting.is_ready(waiting.value))
+      return false;
+    _ready.push_back(waiting.handle);
+    return true;
+  });
+
+  /* Resume */
+  // Tasks suspending again go to _next_frame, _timers or _waiting, never back into _ready
+  Scheduler* previous = std::exchange(_current, this);
+  const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64, std::milli>(_budget));
+  usize resumed = 0;
+  while (resumed < _ready.size()) {
+    _ready[resumed++].resume();
+    if (Clock::now() - start >= budget)
+      break;
+  }
+  _current = previous;
+
+  _ready.erase(_ready.begin(), _ready.begin() + static_cast<std::ptrdiff_t>(resumed));
+}
+
+void Scheduler::retire(std::coroutine_handle<Task::promise_type> handle) noexcept {
+  // Swap and pop
+  const usize index = handle.promise().root_index;
+  _tasks[index] = _tasks.back();
+  _tasks[index].promise().root_index = index;
+  _tasks.pop_back();
+
+  handle.destroy();
+}
+
+void Scheduler::destroy_tasks() noexcept {
+  // Destroying a spawned task destroys the tasks it awaits (owned by its frame), queued handles all belong to one of them
+  for (std::coroutine_handle<Task::promise_type> handle : _tasks)
+    handle.destroy();
+
+  _tasks.clear();
+  _ready.clear();
+  _next_frame.clear();
+  _timers = {};
+  _waiting.clear();
+}
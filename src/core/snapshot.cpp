@@ -0,0 +1,363 @@
+#include "core/snapshot.hpp"
+
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <print>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAPSHOT_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr usize align_up(usize value, usize alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+constexpr usize page_count(u64 size) noexcept {
+  return static_cast<usize>((size + SnapshotWriter::PAGE_SIZE - 1) / SnapshotWriter::PAGE_SIZE);
+}
+
+// Word at a time multiplicative hash, only used to detect changed pages
+u64 hash_page(const std::byte* data, usize size) noexcept {
+  u64 hash = 0xcbf29ce484222325ULL ^ size;
+  usize i = 0;
+  for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+    u64 word;
+    std::memcpy(&word, data + i, sizeof(u64));
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++)
+    hash = (hash ^ static_cast<u64>(data[i])) * 0x100000001B3ULL;
+  return hash;
+}
+
+bool write_file(const std::string& path, std::span<const std::byte> bytes) noexcept {
+  SDL_IOStream* file = SDL_IOFromFile(path.c_str(), "wb");
+  if (file == nullptr) [[unlikely]]
+    return false;
+
+  const usize written = SDL_WriteIO(file, bytes.data(), bytes.size());
+  const bool closed = SDL_CloseIO(file);
+  return written == bytes.size() && closed;
+}
+
+} // namespace
+
+/* SnapshotWriter */
+std::span<const std::byte> SnapshotWriter::write_full() {
+  _buffer.clear();
+  reserve(sizeof(SnapshotHeader), alignof(SnapshotHeader));
+  const usize table_offset = reserve(sizeof(SnapshotSection) * _sections.size(), alignof(SnapshotSection));
+
+  for (usize i = 0; i < _sections.size(); i++) {
+    const PendingSection& section = _sections[i];
+    const usize offset = reserve(section.bytes.size(), ALIGNMENT);
+    std::memcpy(_buffer.data() + offset, section.bytes.data(), section.bytes.size());
+
+    const SnapshotSection entry{section.id, section.element_size, offset, section.bytes.size(), 0, 0};
+    std::memcpy(_buffer.data() + table_offset + i * sizeof(SnapshotSection), &entry, sizeof(SnapshotSection));
+
+    // Remember page hashes for the next diff
+    PageHashes& hashes = page_hashes(section.id);
+    hashes.size = section.bytes.size();
+    hashes.hashes.resize(page_count(hashes.size));
+    for (usize page = 0; page < hashes.hashes.size(); page++) {
+      const usize begin = page * PAGE_SIZE;
+      hashes.hashes[page] = hash_page(section.bytes.data() + begin, std::min(PAGE_SIZE, section.bytes.size() - begin));
+    }
+  }
+
+  // Room for a diff of every page, the largest snapshot of the chain, so the diffs that follow don't allocate
+  usize largest_diff = align_up(sizeof(SnapshotHeader), alignof(SnapshotSection)) + sizeof(SnapshotSection) * _sections.size();
+  for (const PendingSection& section : _sections) {
+    const usize pages = page_count(section.bytes.size());
+    largest_diff = align_up(align_up(largest_diff, ALIGNMENT) + pages * sizeof(u32), ALIGNMENT) + pages * PAGE_SIZE;
+  }
+  _buffer.reserve(largest_diff);
+
+  _sequence = 0;
+  _has_base = true;
+  write_header(SnapshotHeader::Kind::Full, static_cast<u32>(_sections.size()));
+  _sections.clear();
+
+  return _buffer;
+}
+
+std::expected<std::span<const std::byte>, re::Error<SnapshotWriter::Error>> SnapshotWriter::write_diff() {
+  if (!_has_base) [[unlikely]] {
+    _sections.clear();
+    return std::unexpected(re::error(Error::NoBaseSnapshot, "A full snapshot must be written before a diff"));
+  }
+
+  _buffer.clear();
+  reserve(sizeof(SnapshotHeader), alignof(SnapshotHeader));
+  const usize table_offset = reserve(sizeof(SnapshotSection) * _sections.size(), alignof(SnapshotSection));
+
+  for (usize i = 0; i < _sections.size(); i++) {
+    const PendingSection& section = _sections[i];
+    const usize size = section.bytes.size();
+    const usize pages = page_count(size);
+
+    // Find dirty pages, every page is dirty if the section was resized
+    PageHashes& hashes = page_hashes(section.id);
+    const bool resized = hashes.size != size;
+    hashes.size = size;
+    hashes.hashes.resize(pages);
+
+    _dirty_pages.clear();
+    _dirty_pages.resize(pages);
+    for (usize page = 0; page < pages; page++) {
+      const usize begin = page * PAGE_SIZE;
+      const u64 hash = hash_page(section.bytes.data() + begin, std::min(PAGE_SIZE, size - begin));
+      if (resized || hashes.hashes[page] != hash) {
+        hashes.hashes[page] = hash;
+        _dirty_pages.set(page);
+      }
+    }
+
+    // Page indices then page data
+    const usize dirty_count = _dirty_pages.count();
+    const usize indices_offset = reserve(dirty_count * sizeof(u32), ALIGNMENT);
+    const usize data_offset = reserve(dirty_count * PAGE_SIZE, ALIGNMENT);
+
+    usize k = 0;
+    _dirty_pages.for_each_set([&](usize page) {
+      const u32 index = static_cast<u32>(page);
+      const usize begin = page * PAGE_SIZE;
+      std::memcpy(_buffer.data() + indices_offset + k * sizeof(u32), &index, sizeof(u32));
+      std::memcpy(_buffer.data() + data_offset + k * PAGE_SIZE, section.bytes.data() + begin, std::min(PAGE_SIZE, size - begin));
+      k++;
+    });
+
+    const SnapshotSection entry{section.id, section.element_size, indices_offset, size, static_cast<u32>(dirty_count), 0};
+    std::memcpy(_buffer.data() + table_offset + i * sizeof(SnapshotSection), &entry, sizeof(SnapshotSection));
+  }
+
+  _sequence++;
+  write_header(SnapshotHeader::Kind::Diff, static_cast<u32>(_sections.size()));
+  _sections.clear();
+
+  return std::span<const std::byte>(_buffer);
+}
+
+re::expected<re::Error<SnapshotWriter::Error>> SnapshotWriter::save(const std::string& path) const {
+  if (!write_file(path, _buffer)) [[unlikely]]
+    return std::unexpected(re::error(Error::FileWriting, std::format("Failed to write [{}]: {}", path, SDL_GetError())));
+
+  return re::expected<re::Error<Error>>();
+}
+
+SnapshotWriter::PageHashes& SnapshotWriter::page_hashes(u32 id) {
+  auto it = std::find_if(_page_hashes.begin(), _page_hashes.end(), [id](const PageHashes& hashes) { return hashes.id == id; });
+  if (it != _page_hashes.end())
+    return *it;
+
+  return _page_hashes.emplace_back(PageHashes{id, 0, {}});
+}
+
+usize SnapshotWriter::reserve(usize size, usize alignment) {
+  const usize offset = align_up(_buffer.size(), alignment);
+  _buffer.resize(offset + size);
+  return offset;
+}
+
+void SnapshotWriter::write_header(SnapshotHeader::Kind kind, u32 section_count) {
+  const SnapshotHeader header{SnapshotHeader::MAGIC, SnapshotHeader::VERSION, kind, section_count, _sequence, _buffer.size()};
+  std::memcpy(_buffer.data(), &header, sizeof(SnapshotHeader));
+}
+
+/* SnapshotSaver */
+SnapshotSaver::~SnapshotSaver() {
+  if (!_writer.joinable())
+    return;
+
+  _ready_jobs.release();
+  _writer.join();
+}
+
+std::expected<std::unique_ptr<SnapshotSaver>, re::Error<SnapshotSaver::Error>> SnapshotSaver::create(std::vector<std::string> paths, usize reserved_bytes) {
+  std::unique_ptr<SnapshotSaver> saver{new SnapshotSaver(std::move(paths))};
+  for (Job& job : saver->_jobs)
+    job.bytes.reserve(reserved_bytes);
+
+  try {
+    saver->_writer = std::thread(&SnapshotSaver::write_loop, saver.get());
+  } catch (const std::system_error& error) {
+    return std::unexpected(re::error(Error::ThreadCreation, std::string(error.what())));
+  }
+
+  return saver;
+}
+
+void SnapshotSaver::save(u32 sequence, std::span<const std::byte> bytes) {
+  // The writer handles jobs in order, so the slot of this one is free once fewer than QUEUE_SIZE saves are pending
+  for (u32 pending = _pending.load(std::memory_order_acquire); pending >= QUEUE_SIZE; pending = _pending.load(std::memory_order_acquire))
+    _pending.wait(pending, std::memory_order_acquire);
+
+  Job& job = _jobs[_submitted++ % QUEUE_SIZE];
+  job.sequence = sequence;
+  job.bytes.assign(bytes.begin(), bytes.end());
+  _pending.fetch_add(1, std::memory_order_relaxed);
+  _ready_jobs.release();
+}
+
+void SnapshotSaver::wait() noexcept {
+  for (u32 pending = _pending.load(std::memory_order_acquire); pending != 0; pending = _pending.load(std::memory_order_acquire))
+    _pending.wait(pending, std::memory_order_acquire);
+}
+
+void SnapshotSaver::write_loop() {
+  while (true) {
+    _ready_jobs.acquire();
+
+    // Jobs are counted before their release, a release without pending job is the stop signal
+    if (_pending.load(std::memory_order_acquire) == 0)
+      break;
+
+    const Job& job = _jobs[_written++ % QUEUE_SIZE];
+    if (job.sequence == 0) {
+      for (u32 sequence = 1; sequence < _paths.size(); sequence++)
+        SDL_RemovePath(_paths[sequence].c_str());
+    }
+    if (!write_file(_paths[job.sequence], job.bytes)) [[unlikely]] {
+      _failed_saves.fetch_add(1, std::memory_order_relaxed);
+      std::println("Failed to save snapshot [{}]: {}", _paths[job.sequence], SDL_GetError());
+    }
+
+    _pending.fetch_sub(1, std::memory_order_release);
+    _pending.notify_all();
+  }
+}
+
+/* SnapshotView */
+std::expected<SnapshotView, re::Error<SnapshotView::Error>> SnapshotView::create(std::span<const std::byte> data) {
+  if (data.size() < sizeof(SnapshotHeader)) [[unlikely]]
+    return std::unexpected(re::error(Error::TooSmall, "Data is smaller than a snapshot header"));
+
+  const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(data.data());
+  if (header.magic != SnapshotHeader::MAGIC) [[unlikely]]
+    return std::unexpected(re::error(Error::BadMagic, "Data is not a snapshot"));
+  if (header.version != SnapshotHeader::VERSION) [[unlikely]]
+    return std::unexpected(re::error(Error::UnsupportedVersion, std::format("Snapshot version {} is not supported (expected {})", header.version, SnapshotHeader::VERSION)));
+  if (header.size > data.size()) [[unlikely]]
+    return std::unexpected(re::error(Error::OutOfBounds, "Snapshot is truncated"));
+
+  // Validate the section table once so accesses don't need to
+  const usize table_offset = align_up(sizeof(SnapshotHeader), alignof(SnapshotSection));
+  if (table_offset + u64{header.section_count} * sizeof(SnapshotSection) > header.size) [[unlikely]]
+    return std::unexpected(re::error(Error::OutOfBounds, "Section table is out of bounds"));
+
+  const SnapshotSection* sections = reinterpret_cast<const SnapshotSection*>(data.data() + table_offset);
+  for (u32 i = 0; i < header.section_count; i++) {
+    // Sizes are compared to the room left after the offset, offset + size could wrap around
+    const SnapshotSection& section = sections[i];
+    if (section.offset > header.size) [[unlikely]]
+      return std::unexpected(re::error(Error::OutOfBounds, std::format("Section {} is out of bounds", section.id)));
+
+    const u64 room = header.size - section.offset;
+    const u64 size = header.kind == SnapshotHeader::Kind::Full
+                         ? section.size
+                         : align_up(section.offset + u64{section.page_count} * sizeof(u32), SnapshotWriter::ALIGNMENT) - section.offset + u64{section.page_count} * SnapshotWriter::PAGE_SIZE;
+    if (size > room) [[unlikely]]
+      return std::unexpected(re::error(Error::OutOfBounds, std::format("Section {} is out of bounds", section.id)));
+  }
+
+  return SnapshotView(data.first(header.size));
+}
+
+re::expected<re::Error<SnapshotView::Error>> SnapshotView::apply(u32 id, std::span<std::byte> destination) const {
+  std::expected<const SnapshotSection*, re::Error<Error>> entry = find_section(id, SnapshotHeader::Kind::Diff);
+  if (!entry) [[unlikely]]
+    return std::unexpected(std::move(entry.error()));
+
+  const SnapshotSection& section = **entry;
+  if (destination.size() != section.size) [[unlikely]]
+    return std::unexpected(re::error(Error::SizeMismatch, std::format("Section {} applies to {} bytes, got {}", id, section.size, destination.size())));
+
+  const u32* indices = reinterpret_cast<const u32*>(_data.data() + section.offset);
+  const std::byte* pages = _data.data() + align_up(section.offset + section.page_count * sizeof(u32), SnapshotWriter::ALIGNMENT);
+  for (u32 k = 0; k < section.page_count; k++) {
+    const usize begin = static_cast<usize>(indices[k]) * SnapshotWriter::PAGE_SIZE;
+    if (begin >= destination.size()) [[unlikely]]
+      return std::unexpected(re::error(Error::OutOfBounds, std::format("Page {} of section {} is out of bounds", indices[k], id)));
+
+    std::memcpy(destination.data() + begin, pages + k * SnapshotWriter::PAGE_SIZE, std::min(SnapshotWriter::PAGE_SIZE, destination.size() - begin));
+  }
+
+  return re::expected<re::Error<Error>>();
+}
+
+std::expected<const SnapshotSection*, re::Error<SnapshotView::Error>> SnapshotView::find_section(u32 id, SnapshotHeader::Kind kind) const {
+  if (header().kind != kind) [[unlikely]]
+    return std::unexpected(re::error(Error::WrongKind, kind == SnapshotHeader::Kind::Full ? "Expected a full snapshot" : "Expected a diff snapshot"));
+
+  const SnapshotSection* sections = reinterpret_cast<const SnapshotSection*>(_data.data() + align_up(sizeof(SnapshotHeader), alignof(SnapshotSection)));
+  for (u32 i = 0; i < header().section_count; i++) {
+    if (sections[i].id == id)
+      return &sections[i];
+  }
+
+  return std::unexpected(re::error(Error::MissingSection, std::format("Snapshot has no section {}", id)));
+}
+
+/* MappedFile */
+std::expected<MappedFile, re::Error<MappedFile::Error>> MappedFile::open(const std::string& path) {
+#ifdef SNAPSHOT_USE_MMAP
+  const int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0) [[unlikely]]
+    return std::unexpected(re::error(Error::Opening, std::format("Failed to open [{}]", path)));
+
+  struct stat file_stat;
+  if (fstat(file, &file_stat) != 0) [[unlikely]] {
+    ::close(file);
+    return std::unexpected(re::error(Error::Opening, std::format("Failed to stat [{}]", path)));
+  }
+
+  const usize size = static_cast<usize>(file_stat.st_size);
+  if (size == 0) {
+    ::close(file);
+    return MappedFile(nullptr, 0, false);
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file); // The mapping keeps the file alive
+  if (data == MAP_FAILED) [[unlikely]]
+    return std::unexpected(re::error(Error::Mapping, std::format("Failed to map [{}]", path)));
+
+  return MappedFile(static_cast<const std::byte*>(data), size, true);
+#else
+  usize size = 0;
+  void* data = SDL_LoadFile(path.c_str(), &size);
+  if (data == nullptr) [[unlikely]]
+    return std::unexpected(re::error(Error::Opening, std::string(SDL_GetError())));
+
+  return MappedFile(static_cast<const std::byte*>(data), size, false);
+#endif
+}
+
+void MappedFile::release() noexcept {
+  if (_data == nullptr)
+    return;
+
+#ifdef SNAPSHOT_USE_MMAP
+  if (_mapped)
+    munmap(const_cast<std::byte*>(_data), _size);
+  else
+    SDL_free(const_cast<std::byte*>(_data));
+#else
+  SDL_free(const_cast<std::byte*>(_data));
+#endif
+  _data = nullptr;
+}
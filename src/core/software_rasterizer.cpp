@@ -0,0 +1,565 @@
+#include "core/software_rasterizer.hpp"
+
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <string>
+#include <system_error>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using BlendMode = RenderQueue::BlendMode;
+
+constexpr u32 WHITE = 0xFFFFFFFFu;
+
+/* Pixels */
+// ARGB8888: bytes B, G, R, A in memory
+constexpr u32 pack(SDL_Color color) noexcept {
+  return u32{color.a} << 24 | u32{color.r} << 16 | u32{color.g} << 8 | u32{color.b};
+}
+
+// round(a * b / 255) for 8 bit values, the vector paths compute exactly the same
+constexpr u32 mul255(u32 a, u32 b) noexcept {
+  const u32 t = a * b + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+constexpr u32 modulate(u32 pixel, u32 modulation) noexcept {
+  u32 result = 0;
+  for (u32 shift = 0; shift < 32; shift += 8)
+    result |= mul255((pixel >> shift) & 0xFF, (modulation >> shift) & 0xFF) << shift;
+  return result;
+}
+
+// SDL blend modes (non premultiplied)
+constexpr u32 blend_pixel(u32 destination, u32 source, BlendMode blend) noexcept {
+  if (blend == BlendMode::None)
+    return source;
+
+  const u32 source_alpha = source >> 24, inverse_alpha = 255 - source_alpha;
+  u32 result = blend == BlendMode::Blend ? (source_alpha + mul255(destination >> 24, inverse_alpha)) << 24 : destination & 0xFF000000u;
+  for (u32 shift = 0; shift < 24; shift += 8) {
+    const u32 s = (source >> shift) & 0xFF, d = (destination >> shift) & 0xFF;
+    u32 channel = 0;
+    switch (blend) {
+      case BlendMode::Blend: channel = mul255(s, source_alpha) + mul255(d, inverse_alpha); break;
+      case BlendMode::Add: channel = std::min(mul255(s, source_alpha) + d, 255u); break;
+      case BlendMode::Mod: channel = mul255(s, d); break;
+      case BlendMode::Mul: channel = std::min(mul255(s, d) + mul255(d, inverse_alpha), 255u); break;
+      case BlendMode::None: break;
+    }
+    result |= channel << shift;
+  }
+  return result;
+}
+
+/* Vectors */
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+using Vector = __m256i;
+constexpr usize LANES = 8; // Pixels per vector
+
+inline Vector load(const u32* pixels) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)); }
+inline void store(u32* pixels, Vector value) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value); }
+inline Vector broadcast32(u32 value) noexcept { return _mm256_set1_epi32(static_cast<int>(value)); }
+inline Vector broadcast64(u64 value) noexcept { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+inline Vector broadcast16(u16 value) noexcept { return _mm256_set1_epi16(static_cast<short>(value)); }
+inline Vector zero() noexcept { return _mm256_setzero_si256(); }
+inline Vector unpack_low(Vector value) noexcept { return _mm256_unpacklo_epi8(value, zero()); }
+inline Vector unpack_high(Vector value) noexcept { return _mm256_unpackhi_epi8(value, zero()); }
+inline Vector pack(Vector low, Vector high) noexcept { return _mm256_packus_epi16(low, high); }
+inline Vector add16(Vector a, Vector b) noexcept { return _mm256_add_epi16(a, b); }
+inline Vector sub16(Vector a, Vector b) noexcept { return _mm256_sub_epi16(a, b); }
+inline Vector mul16(Vector a, Vector b) noexcept { return _mm256_mullo_epi16(a, b); }
+inline Vector shift_right16(Vector value, int count) noexcept { return _mm256_srli_epi16(value, count); }
+inline Vector bit_and(Vector a, Vector b) noexcept { return _mm256_and_si256(a, b); }
+inline Vector bit_or(Vector a, Vector b) noexcept { return _mm256_or_si256(a, b); }
+inline Vector alpha16(Vector value) noexcept { return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(value, 0xFF), 0xFF); }
+#else
+using Vector = __m128i;
+constexpr usize LANES = 4;
+
+inline Vector load(const u32* pixels) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)); }
+inline void store(u32* pixels, Vector value) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), value); }
+inline Vector broadcast32(u32 value) noexcept { return _mm_set1_epi32(static_cast<int>(value)); }
+inline Vector broadcast64(u64 value) noexcept { return _mm_set1_epi64x(static_cast<long long>(value)); }
+inline Vector broadcast16(u16 value) noexcept { return _mm_set1_epi16(static_cast<short>(value)); }
+inline Vector zero() noexcept { return _mm_setzero_si128(); }
+inline Vector unpack_low(Vector value) noexcept { return _mm_unpacklo_epi8(value, zero()); }
+inline Vector unpack_high(Vector value) noexcept { return _mm_unpackhi_epi8(value, zero()); }
+inline Vector pack(Vector low, Vector high) noexcept { return _mm_packus_epi16(low, high); }
+inline Vector add16(Vector a, Vector b) noexcept { return _mm_add_epi16(a, b); }
+inline Vector sub16(Vector a, Vector b) noexcept { return _mm_sub_epi16(a, b); }
+inline Vector mul16(Vector a, Vector b) noexcept { return _mm_mullo_epi16(a, b); }
+inline Vector shift_right16(Vector value, int count) noexcept { return _mm_srli_epi16(value, count); }
+inline Vector bit_and(Vector a, Vector b) noexcept { return _mm_and_si128(a, b); }
+inline Vector bit_or(Vector a, Vector b) noexcept { return _mm_or_si128(a, b); }
+inline Vector alpha16(Vector value) noexcept { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xFF), 0xFF); }
+#endif
+
+// Unpacked pixels have one channel per 16 bit lane (B, G, R, A)
+const u64 COLOR_LANES = 0x0000FFFFFFFFFFFFull;
+const u64 ALPHA_255 = 0x00FF000000000000ull;
+
+inline Vector mul255(Vector a, Vector b) noexcept {
+  const Vector t = add16(mul16(a, b), broadcast16(128));
+  return shift_right16(add16(t, shift_right16(t, 8)), 8);
+}
+
+// Blend and Add on unpacked pixels, the others stay scalar
+template <BlendMode Blend>
+inline Vector blend_unpacked(Vector destination, Vector source) noexcept {
+  const Vector alpha = alpha16(source);
+  if constexpr (Blend == BlendMode::Blend) {
+    // Color: s * a + d * (1 - a), alpha: a + d * (1 - a)
+    const Vector factor = bit_or(bit_and(alpha, broadcast64(COLOR_LANES)), broadcast64(ALPHA_255));
+    return add16(mul255(source, factor), mul255(destination, sub16(broadcast16(255), alpha)));
+  } else {
+    // Color: s * a + d (saturated by pack), alpha: d
+    return add16(mul255(source, bit_and(alpha, broadcast64(COLOR_LANES))), destination);
+  }
+}
+
+template <BlendMode Blend, bool Modulated, bool Constant>
+usize blend_vectors(u32* destination, const u32* source, usize count, u32 modulation) noexcept {
+  const Vector modulation16 = unpack_low(broadcast32(modulation));
+  Vector constant_low{}, constant_high{};
+  if constexpr (Constant) {
+    constant_low = unpack_low(broadcast32(*source));
+    constant_high = constant_low;
+  }
+
+  usize i = 0;
+  for (; i + LANES <= count; i += LANES) {
+    Vector source_low, source_high;
+    if constexpr (Constant) {
+      source_low = constant_low;
+      source_high = constant_high;
+    } else {
+      const Vector pixels = load(source + i);
+      source_low = unpack_low(pixels);
+      source_high = unpack_high(pixels);
+    }
+    if constexpr (Modulated) {
+      source_low = mul255(source_low, modulation16);
+      source_high = mul255(source_high, modulation16);
+    }
+
+    if constexpr (Blend == BlendMode::None) {
+      store(destination + i, pack(source_low, source_high));
+    } else {
+      const Vector pixels = load(destination + i);
+      store(destination + i, pack(blend_unpacked<Blend>(unpack_low(pixels), source_low), blend_unpacked<Blend>(unpack_high(pixels), source_high)));
+    }
+  }
+  return i;
+}
+#endif
+
+// Blends count pixels of source (modulated) into destination, or a single color when Constant
+template <bool Constant>
+void blend_span(u32* destination, const u32* source, usize count, u32 modulation, BlendMode blend) noexcept {
+  usize done = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  const bool modulated = modulation != WHITE;
+  const auto vectors = [&]<BlendMode Blend>() {
+    return modulated ? blend_vectors<Blend, true, Constant>(destination, source, count, modulation)
+                     : blend_vectors<Blend, false, Constant>(destination, source, count, modulation);
+  };
+  switch (blend) {
+    case BlendMode::None: done = vectors.template operator()<BlendMode::None>(); break;
+    case BlendMode::Blend: done = vectors.template operator()<BlendMode::Blend>(); break;
+    case BlendMode::Add: done = vectors.template operator()<BlendMode::Add>(); break;
+    default: break;
+  }
+#endif
+
+  for (usize i = done; i < count; i++) {
+    const u32 pixel = Constant ? *source : source[i];
+    destination[i] = blend_pixel(destination[i], modulation != WHITE ? modulate(pixel, modulation) : pixel, blend);
+  }
+}
+
+void fill_span(u32* destination, usize count, u32 color, BlendMode blend) noexcept {
+  // Opaque blending is a plain store
+  if (blend == BlendMode::Blend && (color >> 24) == 255)
+    blend = BlendMode::None;
+  blend_span<true>(destination, &color, count, WHITE, blend);
+}
+
+[[nodiscard]] i32 round_to_pixel(f32 value) noexcept {
+  return static_cast<i32>(std::lround(value));
+}
+
+[[nodiscard]] usize default_thread_count() noexcept {
+  return std::clamp<usize>(std::thread::hardware_concurrency(), 1, SoftwareRasterizer::MAX_THREADS);
+}
+
+} // namespace
+
+/* Constructors */
+SoftwareRasterizer::~SoftwareRasterizer() {
+  _stopping.store(true, std::memory_order_relaxed);
+  _start.arrive_and_wait();
+  _workers.clear();
+
+  if (_texture != nullptr)
+    SDL_DestroyTexture(_texture);
+  if (_framebuffer != nullptr)
+    SDL_DestroySurface(_framebuffer);
+}
+
+std::expected<std::unique_ptr<SoftwareRasterizer>, re::Error<SoftwareRasterizer::Error>> SoftwareRasterizer::create(u32 width, u32 height, Settings settings) {
+  const usize threads = settings.threads != 0 ? std::min<usize>(settings.threads, MAX_THREADS) : default_thread_count();
+  std::unique_ptr<SoftwareRasterizer> rasterizer{new SoftwareRasterizer(threads)};
+
+  try {
+    for (usize i = 1; i < threads; i++)
+      rasterizer->_workers.emplace_back(&SoftwareRasterizer::work, rasterizer.get());
+  } catch (const std::system_error& error) {
+    // The missing workers leave the barriers so the destructor doesn't wait for them
+    for (usize i = rasterizer->_workers.size() + 1; i < threads; i++) {
+      rasterizer->_start.arrive_and_drop();
+      rasterizer->_end.arrive_and_drop();
+    }
+    return std::unexpected(re::error(Error::ThreadCreation, std::string(error.what())));
+  }
+
+  if (!rasterizer->resize(width, height)) [[unlikely]]
+    return std::unexpected(re::error(Error::SurfaceCreation, std::string(SDL_GetError())));
+
+  return rasterizer;
+}
+
+std::optional<SoftwareRasterizer::Settings> SoftwareRasterizer::settings_from_environment() {
+  const char* threads = SDL_getenv("SDL_TEST_SOFTWARE_RASTERIZER");
+  if (threads == nullptr)
+    return std::nullopt;
+
+  return Settings{.threads = static_cast<u32>(std::max(SDL_atoi(threads), 0))};
+}
+
+/* Framebuffer */
+bool SoftwareRasterizer::resize(u32 width, u32 height) {
+  width = std::max(width, 1u);
+  height = std::max(height, 1u);
+  if (_framebuffer != nullptr && static_cast<u32>(_framebuffer->w) == width && static_cast<u32>(_framebuffer->h) == height)
+    return true;
+
+  SDL_Surface* framebuffer = SDL_CreateSurface(static_cast<int>(width), static_cast<int>(height), SDL_PIXELFORMAT_ARGB8888);
+  if (framebuffer == nullptr) [[unlikely]]
+    return false;
+
+  if (_framebuffer != nullptr)
+    SDL_DestroySurface(_framebuffer);
+  _framebuffer = framebuffer;
+  _tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  _tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+  return true;
+}
+
+/* Images */
+void SoftwareRasterizer::add_image(const SDL_Texture* texture, SDL_PixelFormat format, u32 width, u32 height) {
+  Image& image = _images[texture];
+  image.format = format;
+  image.width = width;
+  image.height = height;
+  image.pixels.assign(usize{width} * height, 0);
+  _last_texture = nullptr; // The map may have moved its images
+}
+
+void SoftwareRasterizer::update_image(const SDL_Texture* texture, const void* pixels, int pitch) {
+  auto it = _images.find(texture);
+  if (it == _images.end())
+    return;
+
+  Image& image = it->second;
+  if (image.format == SDL_PIXELFORMAT_ARGB8888) {
+    for (u32 y = 0; y < image.height; y++)
+      std::memcpy(image.pixels.data() + usize{y} * image.width, static_cast<const u8*>(pixels) + static_cast<usize>(pitch) * y, image.width * sizeof(u32));
+  } else {
+    SDL_ConvertPixels(static_cast<int>(image.width), static_cast<int>(image.height), image.format, pixels, pitch,
+                      SDL_PIXELFORMAT_ARGB8888, image.pixels.data(), static_cast<int>(image.width * sizeof(u32)));
+  }
+}
+
+void SoftwareRasterizer::remove_image(const SDL_Texture* texture) {
+  _images.erase(texture);
+  _last_texture = nullptr;
+}
+
+/* Frame */
+void SoftwareRasterizer::clear(u8 r, u8 g, u8 b, u8 a) noexcept {
+  // Anything submitted before is covered anyway
+  _commands.clear();
+  _clear_color = pack(SDL_Color{r, g, b, a});
+}
+
+void SoftwareRasterizer::submit(const Command& command) {
+  const i32 width = _framebuffer->w, height = _framebuffer->h;
+  const SDL_FRect& destination = command.destination;
+
+  Bounds bounds{};
+  const Image* image = nullptr;
+  switch (command.type) {
+    case RenderQueue::Type::FillRect:
+    case RenderQueue::Type::Rect:
+      bounds = {round_to_pixel(destination.x), round_to_pixel(destination.y), round_to_pixel(destination.x + destination.w), round_to_pixel(destination.y + destination.h)};
+      break;
+    case RenderQueue::Type::Line: {
+      const i32 x1 = round_to_pixel(destination.x), y1 = round_to_pixel(destination.y), x2 = round_to_pixel(destination.w), y2 = round_to_pixel(destination.h);
+      bounds = {std::min(x1, x2), std::min(y1, y2), std::max(x1, x2) + 1, std::max(y1, y2) + 1};
+      break;
+    }
+    case RenderQueue::Type::Texture: {
+      if (command.texture != _last_texture) {
+        auto it = _images.find(command.texture);
+        _last_texture = command.texture;
+        _last_image = it != _images.end() ? &it->second : nullptr;
+      }
+      image = _last_image;
+      if (image == nullptr || image->width == 0 || image->height == 0)
+        return;
+
+      if (command.angle == 0.0f) {
+        bounds = {round_to_pixel(destination.x), round_to_pixel(destination.y), round_to_pixel(destination.x + destination.w), round_to_pixel(destination.y + destination.h)};
+      } else {
+        // Box around the rotated destination
+        const f32 radians = command.angle * std::numbers::pi_v<f32> / 180.0f;
+        const f32 half_width = (std::abs(std::cos(radians)) * destination.w + std::abs(std::sin(radians)) * destination.h) * 0.5f;
+        const f32 half_height = (std::abs(std::sin(radians)) * destination.w + std::abs(std::cos(radians)) * destination.h) * 0.5f;
+        const f32 center_x = destination.x + destination.w * 0.5f, center_y = destination.y + destination.h * 0.5f;
+        bounds = {static_cast<i32>(std::floor(center_x - half_width)), static_cast<i32>(std::floor(center_y - half_height)),
+                  static_cast<i32>(std::ceil(center_x + half_width)), static_cast<i32>(std::ceil(center_y + half_height))};
+      }
+      break;
+    }
+  }
+
+  bounds = {std::max(bounds.x0, 0), std::max(bounds.y0, 0), std::min(bounds.x1, width), std::min(bounds.y1, height)};
+  if (bounds.x0 >= bounds.x1 || bounds.y0 >= bounds.y1)
+    return;
+
+  _commands.push_back(DrawCommand{command, image, bounds});
+}
+
+void SoftwareRasterizer::render() {
+  if (_commands.empty() && !_clear_color)
+    return;
+
+  /* Binning */
+  // Counts per tile, then end offsets, then commands placed backwards so each bin keeps the submission order
+  const u32 tile_count = _tiles_x * _tiles_y;
+  _bin_offsets.assign(tile_count + 1, 0);
+  const auto for_each_tile = [this](const Bounds& bounds, auto&& function) {
+    for (u32 tile_y = static_cast<u32>(bounds.y0) / TILE_SIZE; tile_y <= static_cast<u32>(bounds.y1 - 1) / TILE_SIZE; tile_y++)
+      for (u32 tile_x = static_cast<u32>(bounds.x0) / TILE_SIZE; tile_x <= static_cast<u32>(bounds.x1 - 1) / TILE_SIZE; tile_x++)
+        function(tile_y * _tiles_x + tile_x);
+  };
+
+  for (const DrawCommand& command : _commands)
+    for_each_tile(command.bounds, [this](u32 tile) { _bin_offsets[tile]++; });
+  u32 total = 0;
+  for (u32 tile = 0; tile < tile_count; tile++)
+    _bin_offsets[tile] = total += _bin_offsets[tile];
+  _bin_offsets[tile_count] = total;
+
+  _bin_commands.resize(total);
+  for (usize i = _commands.size(); i-- > 0;)
+    for_each_tile(_commands[i].bounds, [&](u32 tile) { _bin_commands[--_bin_offsets[tile]] = static_cast<u32>(i); });
+
+  /* Tiles, on every thread */
+  _next_tile.store(0, std::memory_order_relaxed);
+  _start.arrive_and_wait();
+  draw_tiles();
+  _end.arrive_and_wait();
+
+  _commands.clear();
+  _clear_color.reset();
+}
+
+bool SoftwareRasterizer::present(SDL_Renderer* renderer) {
+  if (_texture == nullptr || _texture_renderer != renderer || _texture->w != _framebuffer->w || _texture->h != _framebuffer->h) {
+    if (_texture != nullptr)
+      SDL_DestroyTexture(_texture);
+
+    _texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, _framebuffer->w, _framebuffer->h);
+    _texture_renderer = renderer;
+    if (_texture == nullptr) [[unlikely]]
+      return false;
+    SDL_SetTextureBlendMode(_texture, SDL_BLENDMODE_NONE);
+  }
+
+  return SDL_UpdateTexture(_texture, nullptr, _framebuffer->pixels, _framebuffer->pitch) && SDL_RenderTexture(renderer, _texture, nullptr, nullptr);
+}
+
+/* Pixels */
+u32 SoftwareRasterizer::blend_pixel(u32 destination, u32 source, BlendMode blend, u32 modulation) noexcept {
+  return ::blend_pixel(destination, modulation != WHITE ? modulate(source, modulation) : source, blend);
+}
+
+void SoftwareRasterizer::blend_row(u32* destination, const u32* source, usize count, u32 modulation, BlendMode blend) noexcept {
+  blend_span<false>(destination, source, count, modulation, blend);
+}
+
+void SoftwareRasterizer::fill_row(u32* destination, usize count, u32 color, BlendMode blend) noexcept {
+  fill_span(destination, count, color, blend);
+}
+
+/* Workers */
+void SoftwareRasterizer::work() {
+  while (true) {
+    _start.arrive_and_wait();
+    if (_stopping.load(std::memory_order_relaxed))
+      return;
+
+    draw_tiles();
+    _end.arrive_and_wait();
+  }
+}
+
+void SoftwareRasterizer::draw_tiles() noexcept {
+  const u32 tile_count = _tiles_x * _tiles_y;
+  for (u32 tile = _next_tile.fetch_add(1, std::memory_order_relaxed); tile < tile_count; tile = _next_tile.fetch_add(1, std::memory_order_relaxed))
+    draw_tile(tile);
+}
+
+void SoftwareRasterizer::draw_tile(u32 tile) noexcept {
+  const u32 first = _bin_offsets[tile], last = _bin_offsets[tile + 1];
+  if (first == last && !_clear_color)
+    return;
+
+  const i32 tile_x0 = static_cast<i32>((tile % _tiles_x) * TILE_SIZE), tile_y0 = static_cast<i32>((tile / _tiles_x) * TILE_SIZE);
+  const i32 tile_x1 = std::min(tile_x0 + static_cast<i32>(TILE_SIZE), _framebuffer->w), tile_y1 = std::min(tile_y0 + static_cast<i32>(TILE_SIZE), _framebuffer->h);
+  const auto row = [this](i32 y) { return reinterpret_cast<u32*>(static_cast<u8*>(_framebuffer->pixels) + static_cast<usize>(_framebuffer->pitch) * static_cast<usize>(y)); };
+
+  if (_clear_color) {
+    for (i32 y = tile_y0; y < tile_y1; y++)
+      fill_span(row(y) + tile_x0, static_cast<usize>(tile_x1 - tile_x0), *_clear_color, BlendMode::None);
+  }
+
+  std::array<u32, TILE_SIZE> samples; // Texture row, before blending
+  std::array<u32, TILE_SIZE> columns;
+  for (u32 bin = first; bin < last; bin++) {
+    const DrawCommand& draw = _commands[_bin_commands[bin]];
+    const Command& command = draw.command;
+    const i32 x0 = std::max(draw.bounds.x0, tile_x0), y0 = std::max(draw.bounds.y0, tile_y0);
+    const i32 x1 = std::min(draw.bounds.x1, tile_x1), y1 = std::min(draw.bounds.y1, tile_y1);
+    const u32 color = pack(command.color);
+
+    switch (command.type) {
+      case RenderQueue::Type::FillRect:
+        for (i32 y = y0; y < y1; y++)
+          fill_span(row(y) + x0, static_cast<usize>(x1 - x0), color, command.blend);
+        break;
+
+      case RenderQueue::Type::Rect: {
+        // Edges of the unclipped rect, only those inside the tile are drawn
+        const i32 left = round_to_pixel(command.destination.x), top = round_to_pixel(command.destination.y);
+        const i32 right = round_to_pixel(command.destination.x + command.destination.w) - 1, bottom = round_to_pixel(command.destination.y + command.destination.h) - 1;
+        for (i32 y = y0; y < y1; y++) {
+          if (y == top || y == bottom) {
+            fill_span(row(y) + x0, static_cast<usize>(x1 - x0), color, command.blend);
+            continue;
+          }
+          if (left >= x0 && left < x1)
+            fill_span(row(y) + left, 1, color, command.blend);
+          if (right != left && right >= x0 && right < x1)
+            fill_span(row(y) + right, 1, color, command.blend);
+        }
+        break;
+      }
+
+      case RenderQueue::Type::Line: {
+        // Bresenham over the whole line, only the pixels of the tile are written
+        i32 x = round_to_pixel(command.destination.x), y = round_to_pixel(command.destination.y);
+        const i32 end_x = round_to_pixel(command.destination.w), end_y = round_to_pixel(command.destination.h);
+        const i32 dx = std::abs(end_x - x), dy = -std::abs(end_y - y);
+        const i32 step_x = x < end_x ? 1 : -1, step_y = y < end_y ? 1 : -1;
+        i32 error = dx + dy;
+        while (true) {
+          if (x >= x0 && x < x1 && y >= y0 && y < y1)
+            fill_span(row(y) + x, 1, color, command.blend);
+          if (x == end_x && y == end_y)
+            break;
+          const i32 error2 = error * 2;
+          if (error2 >= dy) {
+            error += dy;
+            x += step_x;
+          }
+          if (error2 <= dx) {
+            error += dx;
+            y += step_y;
+          }
+        }
+        break;
+      }
+
+      case RenderQueue::Type::Texture: {
+        // Nearest sampling of the source rect, from pixel centers
+        const Image& image = *draw.image;
+        const bool whole_texture = command.source.w == 0.0f || command.source.h == 0.0f;
+        const SDL_FRect source = whole_texture ? SDL_FRect{0.0f, 0.0f, static_cast<f32>(image.width), static_cast<f32>(image.height)} : command.source;
+        const SDL_FRect& destination = command.destination;
+        const f32 scale_x = source.w / destination.w, scale_y = source.h / destination.h;
+        const auto sample = [&](f32 local_x, f32 local_y) {
+          const u32 u = static_cast<u32>(std::clamp(source.x + local_x * scale_x, 0.0f, static_cast<f32>(image.width - 1)));
+          const u32 v = static_cast<u32>(std::clamp(source.y + local_y * scale_y, 0.0f, static_cast<f32>(image.height - 1)));
+          return image.pixels[usize{v} * image.width + u];
+        };
+
+        if (command.angle == 0.0f) {
+          // Source columns are the same on every row
+          for (i32 x = x0; x < x1; x++)
+            columns[static_cast<usize>(x - x0)] = static_cast<u32>(std::clamp(source.x + (static_cast<f32>(x) + 0.5f - destination.x) * scale_x, 0.0f, static_cast<f32>(image.width - 1)));
+
+          for (i32 y = y0; y < y1; y++) {
+            const u32 v = static_cast<u32>(std::clamp(source.y + (static_cast<f32>(y) + 0.5f - destination.y) * scale_y, 0.0f, static_cast<f32>(image.height - 1)));
+            const u32* source_row = image.pixels.data() + usize{v} * image.width;
+            for (i32 x = x0; x < x1; x++)
+              samples[static_cast<usize>(x - x0)] = source_row[columns[static_cast<usize>(x - x0)]];
+            blend_span<false>(row(y) + x0, samples.data(), static_cast<usize>(x1 - x0), color, command.blend);
+          }
+          break;
+        }
+
+        // Rotated: pixel centers rotated back into the destination rect, each row crosses it once (convex)
+        const f32 radians = command.angle * std::numbers::pi_v<f32> / 180.0f;
+        const f32 cos = std::cos(radians), sin = std::sin(radians);
+        const f32 center_x = destination.x + destination.w * 0.5f, center_y = destination.y + destination.h * 0.5f;
+        for (i32 y = y0; y < y1; y++) {
+          const f32 offset_y = static_cast<f32>(y) + 0.5f - center_y;
+          i32 run_start = -1, run_end = -1;
+          for (i32 x = x0; x < x1; x++) {
+            const f32 offset_x = static_cast<f32>(x) + 0.5f - center_x;
+            const f32 local_x = cos * offset_x + sin * offset_y + destination.w * 0.5f;
+            const f32 local_y = -sin * offset_x + cos * offset_y + destination.h * 0.5f;
+            if (local_x < 0.0f || local_y < 0.0f || local_x >= destination.w || local_y >= destination.h) {
+              if (run_start >= 0)
+                break;
+              continue;
+            }
+            if (run_start < 0)
+              run_start = x;
+            run_end = x + 1;
+            samples[static_cast<usize>(x - run_start)] = sample(local_x, local_y);
+          }
+          if (run_start >= 0)
+            blend_span<false>(row(y) + run_start, samples.data(), static_cast<usize>(run_end - run_start), color, command.blend);
+        }
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,138 @@
+#include "core/spatial_hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/* Modification */
+void SpatialHash::reserve(const Bounds& world) {
+  const CellRange cells = cell_range(world);
+  _cells.reserve(_cells.size() + static_cast<usize>(cells.max.x - cells.min.x + 1) * static_cast<usize>(cells.max.y - cells.min.y + 1));
+  for (i32 y = cells.min.y; y <= cells.max.y; y++) {
+    for (i32 x = cells.min.x; x <= cells.max.x; x++)
+      _cells.try_emplace(cell_key(x, y));
+  }
+}
+
+void SpatialHash::insert(Id id, const Bounds& bounds) {
+  if (id >= _objects.size()) {
+    _objects.resize(id + 1);
+    _query_stamps.resize(id + 1, 0);
+  }
+
+  Object& object = _objects[id];
+  if (object.alive)
+    remove_from_cells(id, object.cells);
+
+  object = Object{bounds, cell_range(bounds), true};
+  add_to_cells(id, object.cells);
+}
+
+void SpatialHash::move(Id id, const Bounds& bounds) {
+  if (!contains(id)) [[unlikely]] {
+    insert(id, bounds);
+    return;
+  }
+
+  Object& object = _objects[id];
+  object.bounds = bounds;
+
+  const CellRange cells = cell_range(bounds);
+  if (cells == object.cells) [[likely]]
+    return;
+
+  remove_from_cells(id, object.cells);
+  add_to_cells(id, cells);
+  object.cells = cells;
+}
+
+void SpatialHash::remove(Id id) {
+  if (!contains(id))
+    return;
+
+  remove_from_cells(id, _objects[id].cells);
+  _objects[id].alive = false;
+}
+
+void SpatialHash::clear() {
+  for (auto& [key, ids] : _cells) {
+    ids.clear();
+    release_if_empty(ids);
+  }
+  for (Object& object : _objects)
+    object.alive = false;
+}
+
+/* Queries */
+void SpatialHash::query_rect(const Bounds& rect, std::vector<Id>& out) const {
+  for_each_in_rect(rect, [&out](Id id) { out.push_back(id); });
+}
+
+void SpatialHash::query_radius(glm::vec2 center, f32 radius, std::vector<Id>& out) const {
+  const f32 radius_squared = radius * radius;
+
+  for_each_in_rect(Bounds{center - glm::vec2(radius), center + glm::vec2(radius)}, [&](Id id) {
+    // Distance from the center to the closest point of the bounds
+    const Bounds& bounds = _objects[id].bounds;
+    const glm::vec2 delta = center - glm::clamp(center, bounds.min, bounds.max);
+    if (delta.x * delta.x + delta.y * delta.y <= radius_squared)
+      out.push_back(id);
+  });
+}
+
+/* Private helpers */
+SpatialHash::CellRange SpatialHash::cell_range(const Bounds& bounds) const noexcept {
+  return CellRange{
+      glm::ivec2(static_cast<i32>(std::floor(bounds.min.x * _inverse_cell_size)), static_cast<i32>(std::floor(bounds.min.y * _inverse_cell_size))),
+      glm::ivec2(static_cast<i32>(std::floor(bounds.max.x * _inverse_cell_size)), static_cast<i32>(std::floor(bounds.max.y * _inverse_cell_size))),
+  };
+}
+
+void SpatialHash::add_to_cells(Id id, const CellRange& cells) {
+  for (i32 y = cells.min.y; y <= cells.max.y; y++) {
+    for (i32 x = cells.min.x; x <= cells.max.x; x++)
+      push_id(_cells[cell_key(x, y)], id);
+  }
+}
+
+void SpatialHash::remove_from_cells(Id id, const CellRange& cells) {
+  for (i32 y = cells.min.y; y <= cells.max.y; y++) {
+    for (i32 x = cells.min.x; x <= cells.max.x; x++) {
+      auto cell = _cells.find(cell_key(x, y));
+      if (cell == _cells.end()) [[unlikely]]
+        continue;
+
+      // Order inside a cell doesn't matter, swap and pop
+      CellIds& ids = cell->second;
+      if (auto it = std::find(ids.begin(), ids.end(), id); it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+        release_if_empty(ids);
+      }
+    }
+  }
+}
+
+void SpatialHash::push_id(CellIds& ids, Id id) {
+  // Spilling, a spare buffer is taken over (moving a vector on the heap moves its storage) rather than allocating one
+  if (ids.size() == INLINE_CELL_IDS && ids.is_inline() && !_spare_ids.empty()) {
+    CellIds& spare = _spare_ids.back();
+    spare.assign(ids.begin(), ids.end());
+    ids = std::move(spare);
+    _spare_ids.pop_back();
+  }
+  ids.push_back(id);
+}
+
+void SpatialHash::release_if_empty(CellIds& ids) {
+  if (ids.empty() && !ids.is_inline())
+    _spare_ids.push_back(std::move(ids)); // Leaves ids inline
+}
+
+u32 SpatialHash::next_query_stamp() const {
+  if (++_query_stamp == 0) [[unlikely]] {
+    // Wrapped around, old stamps could collide with new ones
+    std::fill(_query_stamps.begin(), _query_stamps.end(), 0);
+    _query_stamp = 1;
+  }
+  return _query_stamp;
+}
@@ -0,0 +1,39 @@
+#include "core/startup_profile.hpp"
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+bool StartupProfile::report_requested() {
+  return SDL_getenv("SDL_TEST_STARTUP_PROFILE") != nullptr;
+}
+
+void StartupProfile::record(const char* name, Clock::time_point start, Clock::time_point end, bool background) noexcept {
+  const usize index = _count.fetch_add(1, std::memory_order_relaxed);
+  if (index >= MAX_STAGES) [[unlikely]]
+    return;
+
+  const auto milliseconds = [this](Clock::time_point time) { return std::chrono::duration<f64, std::milli>(time - _start).count(); };
+  _stages[index] = Stage{name, milliseconds(start), milliseconds(end), background};
+}
+
+void StartupProfile::first_frame() noexcept {
+  if (!_first_frame)
+    _first_frame = std::chrono::duration<f64, std::milli>(Clock::now() - _start).count();
+}
+
+std::span<const StartupProfile::Stage> StartupProfile::stages() const noexcept {
+  return std::span(_stages.data(), std::min(_count.load(std::memory_order_relaxed), MAX_STAGES));
+}
+
+std::string StartupProfile::report() const {
+  std::vector<Stage> stages(this->stages().begin(), this->stages().end());
+  std::ranges::stable_sort(stages, {}, &Stage::start);
+
+  std::string report = _first_frame ? std::format("[STARTUP] first frame after {:.1f} ms", *_first_frame) : std::string("[STARTUP] no frame presented yet");
+  for (const Stage& stage : stages)
+    report += std::format("\n  {:<24}{:>8.1f} ms  ({:.1f} to {:.1f}){}", stage.name, stage.end - stage.start, stage.start, stage.end, stage.background ? "  [background]" : "");
+  return report;
+}
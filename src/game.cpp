@@ -1,11 +1,145 @@
 #include "game.hpp"
 
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_mouse.h>
+#include <SDL3/SDL_stdinc.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <print>
+#include <random>
+#include <rerror/error_formatter.hpp>
+#include <span>
+#include <utility>
+
+template class StaticApplication<Game>;
+
+std::expected<Game::World, re::AnyError> Game::generate_world() {
+  // Spawn bodies across the whole world, most of them off screen
+  std::mt19937 random_engine{42};
+  std::uniform_real_distribution<f32> position_x(0.0f, WORLD_SIZE.x);
+  std::uniform_real_distribution<f32> position_y(0.0f, WORLD_SIZE.y);
+  std::uniform_real_distribution<f32> velocity(-120.0f, 120.0f);
+  std::uniform_real_distribution<f32> half_size(2.0f, MAX_HALF_SIZE);
+  std::uniform_int_distribution<u32> palette_index(0, PALETTE.size() - 1);
+
+  // Navigation grid over the world, with random walls
+  auto navigation = NavigationGrid::create(static_cast<u32>(WORLD_SIZE.x / NAVIGATION_CELL_SIZE), static_cast<u32>(WORLD_SIZE.y / NAVIGATION_CELL_SIZE), NAVIGATION_CELL_SIZE);
+  if (!navigation) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Navigation, "Failed to create navigation grid", std::move(navigation.error())));
+
+  std::uniform_int_distribution<u32> wall_x(0, navigation->width() - 1);
+  std::uniform_int_distribution<u32> wall_y(0, navigation->height() - 1);
+  std::uniform_int_distribution<u32> wall_length(1, 12);
+  for (u32 i = 0; i < WALL_COUNT; i++) {
+    // Thin horizontal or vertical segments
+    const u32 length = wall_length(random_engine);
+    if (i % 2 == 0)
+      navigation->fill_rect(wall_x(random_engine), wall_y(random_engine), length, 1, NavigationGrid::WALL);
+    else
+      navigation->fill_rect(wall_x(random_engine), wall_y(random_engine), 1, length, NavigationGrid::WALL);
+  }
+  navigation->clear_changes(); // No field yet
+
+  std::vector<Body> bodies;
+  bodies.reserve(BODY_COUNT);
+  for (usize i = 0; i < BODY_COUNT; i++) {
+    glm::vec2 position;
+    do {
+      position = {position_x(random_engine), position_y(random_engine)};
+    } while (!is_open(*navigation, position));
+
+    const f32 half = half_size(random_engine);
+    bodies.push_back(Body{
+        .position = position,
+        .velocity = {velocity(random_engine), velocity(random_engine)},
+        .half_size = {half, half},
+        .palette_index = static_cast<u8>(palette_index(random_engine)),
+        .neighbors = 0,
+    });
+  }
+
+  return World{std::move(*navigation), std::move(bodies)};
+}
+
 re::expected<re::AnyError> Game::setup() noexcept {
+  // The world was generated by create(), its fields are built now so picking goals doesn't allocate while playing
+  _flow_fields.clear();
+  _flow_fields.reserve(*_navigation);
+  _goal = NavigationGrid::NONE;
+
+  // Bodies stay in the world but their bounds can stick out of it by their size
+  _spatial_hash.reserve({glm::vec2(-MAX_HALF_SIZE), WORLD_SIZE + glm::vec2(MAX_HALF_SIZE)});
+  rebuild_indices();
+  _neighbors.reserve(64);
+
+  // Impacts, a white ring tinted when drawn
+  _impacts.reserve(MAX_IMPACTS);
+  auto impact_texture = _renderer.create_texture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, IMPACT_TEXTURE_SIZE, IMPACT_TEXTURE_SIZE);
+  if (!impact_texture) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Resources, "Failed to create impact texture", std::move(impact_texture.error())));
+  _impact_texture = *impact_texture;
+
+  std::array<u32, IMPACT_TEXTURE_SIZE * IMPACT_TEXTURE_SIZE> pixels{};
+  constexpr f32 center = IMPACT_TEXTURE_SIZE / 2.0f, radius = center - 3.0f;
+  for (u32 y = 0; y < IMPACT_TEXTURE_SIZE; y++) {
+    for (u32 x = 0; x < IMPACT_TEXTURE_SIZE; x++) {
+      const f32 distance = std::hypot(static_cast<f32>(x) + 0.5f - center, static_cast<f32>(y) + 0.5f - center);
+      const f32 alpha = std::clamp(1.0f - std::abs(distance - radius) / 2.5f, 0.0f, 1.0f);
+      pixels[y * IMPACT_TEXTURE_SIZE + x] = static_cast<u32>(alpha * 255.0f) << 24 | 0x00FFFFFFu;
+    }
+  }
+  _renderer.update_texture(_impact_texture, pixels.data(), IMPACT_TEXTURE_SIZE * sizeof(u32));
+
+  // Snapshots go to the user's preference directory (created by SDL), written by a background thread
+  std::string snapshot_directory;
+  if (char* pref_path = SDL_GetPrefPath("UnderScroll", "sdl_test"); pref_path != nullptr) {
+    snapshot_directory = pref_path;
+    SDL_free(pref_path);
+  }
+  _snapshot_paths.clear();
+  for (u32 sequence = 0; sequence < SNAPSHOT_CHAIN_LENGTH; sequence++)
+    _snapshot_paths.push_back(std::format("{}snapshot_{:04}.bin", snapshot_directory, sequence));
+
+  // A full snapshot and a diff built once size the writer's buffers and page hashes, so saving doesn't allocate in game
+  const SavedState state{_camera, _goal};
+  add_snapshot_sections(state);
+  (void)_snapshot_writer.write_full();
+  add_snapshot_sections(state);
+  (void)_snapshot_writer.write_diff();
+  _snapshot_writer.reset();
+  if (auto saver = SnapshotSaver::create(_snapshot_paths, _snapshot_writer.capacity()); saver)
+    _snapshot_saver = std::move(*saver);
+
   return re::expected<re::AnyError>();
 }
 
 re::expected<re::AnyError> Game::input(const SDL_Event& event) noexcept {
   switch (event.type) {
+    case SDL_EVENT_KEY_DOWN:
+      if (event.key.repeat)
+        break;
+      // A failed save or load is reported, the game goes on
+      if (event.key.scancode == SAVE_KEY) {
+        if (auto saved = save_snapshot(); !saved) [[unlikely]]
+          std::println("{:#?}", saved.error());
+      } else if (event.key.scancode == LOAD_KEY) {
+        if (auto loaded = load_snapshot(); !loaded) [[unlikely]]
+          std::println("{:#?}", loaded.error());
+      }
+      break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN: {
+      const u32 cell = _navigation->cell_at(_camera + glm::vec2(event.button.x, event.button.y));
+      if (cell == NavigationGrid::NONE)
+        break;
+      if (event.button.button == SDL_BUTTON_LEFT && _navigation->is_walkable(cell))
+        _goal = cell;
+      else if (event.button.button == SDL_BUTTON_RIGHT && cell != _goal)
+        _navigation->set_cost(cell, _navigation->is_walkable(cell) ? NavigationGrid::WALL : 1);
+      break;
+    }
     default:
       break;
   }
@@ -13,12 +147,262 @@ re::expected<re::AnyError> Game::input(const SDL_Event& event) noexcept {
   return re::expected<re::AnyError>();
 }
 
-re::expected<re::AnyError> Game::update(double UNUSED(delta_time)) noexcept {
+re::expected<re::AnyError> Game::update(double delta_time) noexcept {
+  const f32 dt = static_cast<f32>(delta_time / 1000.0); // In s
+
+  /* Camera */
+  const InputState& input = input_state();
+  const glm::vec2 camera_direction{
+      static_cast<f32>(input.is_held(SDL_SCANCODE_D) || input.is_held(SDL_SCANCODE_RIGHT)) - static_cast<f32>(input.is_held(SDL_SCANCODE_A) || input.is_held(SDL_SCANCODE_LEFT)),
+      static_cast<f32>(input.is_held(SDL_SCANCODE_S) || input.is_held(SDL_SCANCODE_DOWN)) - static_cast<f32>(input.is_held(SDL_SCANCODE_W) || input.is_held(SDL_SCANCODE_UP)),
+  };
+  _camera = glm::clamp(_camera + camera_direction * (CAMERA_SPEED * dt), glm::vec2(0.0f), WORLD_SIZE);
+
+  /* Navigation */
+  // Cached fields follow the walls changed since the last frame, then every body shares the goal's field
+  _flow_fields.update(*_navigation);
+  const FlowField* field = _goal != NavigationGrid::NONE ? &_flow_fields.get(*_navigation, _goal) : nullptr;
+
+  /* Movement */
+  const f32 steering = std::min(STEERING * dt, 1.0f);
+  std::uniform_real_distribution<f32> respawn_x(0.0f, WORLD_SIZE.x);
+  std::uniform_real_distribution<f32> respawn_y(0.0f, WORLD_SIZE.y);
+  for (usize i = 0; i < _bodies.size(); i++) {
+    Body& body = _bodies[i];
+    if (field != nullptr) {
+      // Bodies reaching the goal start over somewhere else, so they never all pile up on it
+      if (_navigation->cell_at(body.position) == _goal) {
+        do {
+          body.position = {respawn_x(_random_engine), respawn_y(_random_engine)};
+        } while (!is_open(body.position));
+      }
+      if (const glm::vec2 direction = field->direction_at(*_navigation, body.position); direction != glm::vec2(0.0f))
+        body.velocity += (direction * AGENT_SPEED - body.velocity) * steering;
+    }
+
+    // Walls stop bodies, unless they already are in one (spawned in a wall added since)
+    const glm::vec2 previous = body.position;
+    body.position += body.velocity * dt;
+    if (!is_open(body.position) && is_open(previous)) {
+      body.position = previous;
+      body.velocity = -body.velocity;
+    }
+
+    // Bounce on world borders
+    for (i32 axis = 0; axis < 2; axis++) {
+      if (body.position[axis] < 0.0f || body.position[axis] > WORLD_SIZE[axis]) {
+        body.position[axis] = glm::clamp(body.position[axis], 0.0f, WORLD_SIZE[axis]);
+        body.velocity[axis] = -body.velocity[axis];
+      }
+    }
+
+    const SpatialHash::Bounds bounds = bounds_of(body);
+    _spatial_hash.move(static_cast<SpatialHash::Id>(i), bounds);
+    _broad_phase.set_bounds(static_cast<BroadPhase::Id>(i), bounds.min, bounds.max);
+  }
+
+  /* Collisions */
+  // Broad-phase pairs already overlap, bounce bodies moving towards each other
+  for (const BroadPhase::Pair& pair : _broad_phase.update()) {
+    Body& a = _bodies[pair.a];
+    Body& b = _bodies[pair.b];
+
+    const glm::vec2 offset = b.position - a.position;
+    const glm::vec2 relative_velocity = b.velocity - a.velocity;
+    if (offset.x * relative_velocity.x + offset.y * relative_velocity.y < 0.0f) {
+      std::swap(a.velocity, b.velocity);
+      if (_impacts.size() < MAX_IMPACTS)
+        _impacts.emplace(Impact{(a.position + b.position) * 0.5f, 0.0f, a.palette_index});
+    }
+  }
+
+  /* Impacts */
+  _impacts.for_each([&](uh::handle<Impact, u64> handle, Impact& impact) {
+    impact.age += dt;
+    if (impact.age >= IMPACT_DURATION)
+      _impacts.erase(handle);
+  });
+
+  /* Neighbors */
+  for (Body& body : _bodies) {
+    _neighbors.clear();
+    _spatial_hash.query_radius(body.position, NEIGHBOR_RADIUS, _neighbors);
+    body.neighbors = static_cast<u32>(_neighbors.size()) - 1; // Minus itself
+  }
+
   return re::expected<re::AnyError>();
 }
 
 re::expected<re::AnyError> Game::draw() const noexcept {
   _renderer.clear(20, 20, 20);
 
+  // Only submit bodies overlapping the view
+  int view_width = 0, view_height = 0;
+  SDL_GetCurrentRenderOutputSize(_renderer.get_raw(), &view_width, &view_height);
+  const SpatialHash::Bounds view{_camera, _camera + glm::vec2(static_cast<f32>(view_width), static_cast<f32>(view_height))};
+
+  RenderQueue& queue = _renderer.queue();
+
+  // Walls and goal, below the bodies
+  const u32 first_x = static_cast<u32>(std::max(view.min.x / NAVIGATION_CELL_SIZE, 0.0f)), first_y = static_cast<u32>(std::max(view.min.y / NAVIGATION_CELL_SIZE, 0.0f));
+  const u32 last_x = std::min(static_cast<u32>(view.max.x / NAVIGATION_CELL_SIZE), _navigation->width() - 1);
+  const u32 last_y = std::min(static_cast<u32>(view.max.y / NAVIGATION_CELL_SIZE), _navigation->height() - 1);
+  for (u32 y = first_y; y <= last_y; y++) {
+    for (u32 x = first_x; x <= last_x; x++) {
+      const u32 cell = _navigation->cell(x, y);
+      if (_navigation->is_walkable(cell) && cell != _goal)
+        continue;
+      const glm::vec2 top_left = glm::vec2(static_cast<f32>(x), static_cast<f32>(y)) * NAVIGATION_CELL_SIZE - _camera;
+      const f32 inset = cell == _goal ? NAVIGATION_CELL_SIZE / 4.0f : 0.0f;
+      queue.fill_rect(SDL_FRect{top_left.x + inset, top_left.y + inset, NAVIGATION_CELL_SIZE - inset * 2.0f, NAVIGATION_CELL_SIZE - inset * 2.0f},
+                      cell == _goal ? GOAL_COLOR : WALL_COLOR, 0, cell == _goal ? 1 : 0);
+    }
+  }
+
+  _spatial_hash.for_each_in_rect(view, [&](SpatialHash::Id id) {
+    const Body& body = _bodies[id];
+    const glm::vec2 top_left = body.position - body.half_size - _camera;
+    const bool crowded = body.neighbors >= CROWDED_NEIGHBORS;
+
+    // Depth groups bodies by color so the queue merges them into few draw calls
+    const u32 color_group = crowded ? static_cast<u32>(PALETTE.size()) : body.palette_index;
+    queue.fill_rect(SDL_FRect{top_left.x, top_left.y, body.half_size.x * 2.0f, body.half_size.y * 2.0f},
+                    crowded ? CROWDED_COLOR : PALETTE[body.palette_index], 1, color_group);
+  });
+
+  // Impacts grow and fade out, above the bodies
+  if (SDL_Texture* impact_texture = _renderer.texture(_impact_texture)) {
+    _impacts.for_each([&](uh::handle<Impact, u64>, const Impact& impact) {
+      if (impact.position.x + IMPACT_SIZE < view.min.x || impact.position.x - IMPACT_SIZE > view.max.x ||
+          impact.position.y + IMPACT_SIZE < view.min.y || impact.position.y - IMPACT_SIZE > view.max.y)
+        return;
+
+      const f32 progress = impact.age / IMPACT_DURATION;
+      const f32 half = IMPACT_SIZE * (0.25f + 0.75f * progress) * 0.5f;
+      const glm::vec2 top_left = impact.position - glm::vec2(half) - _camera;
+      SDL_Color color = PALETTE[impact.palette_index];
+      color.a = static_cast<u8>((1.0f - progress) * 255.0f);
+      queue.texture(impact_texture, nullptr, SDL_FRect{top_left.x, top_left.y, half * 2.0f, half * 2.0f}, 2, 0, RenderQueue::BlendMode::Add, color);
+    });
+  }
+
+  return re::expected<re::AnyError>();
+}
+
+/* Snapshots */
+re::expected<re::AnyError> Game::save_snapshot() {
+  const SavedState state{_camera, _goal};
+  add_snapshot_sections(state);
+
+  std::span<const std::byte> bytes;
+  if (!_snapshot_writer.has_base() || _snapshot_writer.sequence() + 1 >= SNAPSHOT_CHAIN_LENGTH) {
+    // New chain, diffs of the previous one don't apply anymore (removed before writing it)
+    bytes = _snapshot_writer.write_full();
+  } else {
+    auto diff = _snapshot_writer.write_diff();
+    if (!diff) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, "Failed to build snapshot diff", std::move(diff.error())));
+    bytes = *diff;
+  }
+
+  // Written in the background, files are only read back after the writer is done with them (see load_snapshot())
+  if (_snapshot_saver) {
+    _snapshot_saver->save(_snapshot_writer.sequence(), bytes);
+    return re::expected<re::AnyError>();
+  }
+
+  if (_snapshot_writer.sequence() == 0) {
+    for (u32 sequence = 1; sequence < SNAPSHOT_CHAIN_LENGTH; sequence++)
+      SDL_RemovePath(snapshot_path(sequence).c_str());
+  }
+  if (auto saved = _snapshot_writer.save(snapshot_path(_snapshot_writer.sequence())); !saved) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Failed to save snapshot", std::move(saved.error())));
+
+  return re::expected<re::AnyError>();
+}
+
+re::expected<re::AnyError> Game::load_snapshot() {
+  if (_snapshot_saver)
+    _snapshot_saver->wait();
+
+  /* Full snapshot, read in place */
+  auto base_file = MappedFile::open(snapshot_path(0));
+  if (!base_file) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Failed to open base snapshot", std::move(base_file.error())));
+
+  auto base = SnapshotView::create(base_file->bytes());
+  if (!base) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Invalid base snapshot", std::move(base.error())));
+
+  auto state = base->section<SavedState>(static_cast<u32>(SnapshotSectionId::State));
+  if (!state) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Base snapshot has no valid state", std::move(state.error())));
+  auto bodies = base->section<Body>(static_cast<u32>(SnapshotSectionId::Bodies));
+  if (!bodies) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Base snapshot has no valid bodies", std::move(bodies.error())));
+  auto costs = base->section<u8>(static_cast<u32>(SnapshotSectionId::Navigation));
+  if (!costs) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Base snapshot has no valid navigation grid", std::move(costs.error())));
+  if (state->size() != 1) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, "Base snapshot state is malformed"));
+  if (costs->size() != _navigation->cell_count()) [[unlikely]]
+    return std::unexpected(re::anyError(Error::Snapshot, std::format("Snapshot navigation grid has {} cells, expected {}", costs->size(), _navigation->cell_count())));
+
+  SavedState restored_state = state->front();
+  _bodies.assign(bodies->begin(), bodies->end());
+  std::vector<u8> restored_costs(costs->begin(), costs->end());
+
+  /* Diffs, applied in sequence until the chain ends */
+  for (u32 sequence = 1; sequence < SNAPSHOT_CHAIN_LENGTH; sequence++) {
+    const std::string& path = snapshot_path(sequence);
+    if (!SDL_GetPathInfo(path.c_str(), nullptr))
+      break;
+
+    auto diff_file = MappedFile::open(path);
+    if (!diff_file) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, std::format("Failed to open snapshot diff {}", sequence), std::move(diff_file.error())));
+
+    auto diff = SnapshotView::create(diff_file->bytes());
+    if (!diff) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, std::format("Invalid snapshot diff {}", sequence), std::move(diff.error())));
+    if (diff->header().sequence != sequence)
+      break;
+
+    if (auto applied = diff->apply(static_cast<u32>(SnapshotSectionId::State), std::as_writable_bytes(std::span(&restored_state, 1))); !applied) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, std::format("Failed to apply snapshot diff {}", sequence), std::move(applied.error())));
+    if (auto applied = diff->apply(static_cast<u32>(SnapshotSectionId::Bodies), std::as_writable_bytes(std::span(_bodies))); !applied) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, std::format("Failed to apply snapshot diff {}", sequence), std::move(applied.error())));
+    if (auto applied = diff->apply(static_cast<u32>(SnapshotSectionId::Navigation), std::as_writable_bytes(std::span(restored_costs))); !applied) [[unlikely]]
+      return std::unexpected(re::anyError(Error::Snapshot, std::format("Failed to apply snapshot diff {}", sequence), std::move(applied.error())));
+  }
+
+  // Walls and goal, cached fields were computed for other costs
+  for (u32 cell = 0; cell < _navigation->cell_count(); cell++)
+    _navigation->set_cost(cell, restored_costs[cell]);
+  _navigation->clear_changes();
+  _flow_fields.clear();
+  const u32 goal = restored_state.goal;
+  _goal = goal < _navigation->cell_count() && _navigation->is_walkable(goal) ? goal : NavigationGrid::NONE;
+
+  _camera = restored_state.camera;
+  _impacts.clear();
+  rebuild_indices();
+
   return re::expected<re::AnyError>();
 }
+
+void Game::add_snapshot_sections(const SavedState& state) {
+  _snapshot_writer.add_section(static_cast<u32>(SnapshotSectionId::State), std::span<const SavedState>(&state, 1));
+  _snapshot_writer.add_section(static_cast<u32>(SnapshotSectionId::Bodies), std::span<const Body>(_bodies));
+  _snapshot_writer.add_section(static_cast<u32>(SnapshotSectionId::Navigation), _navigation->costs());
+}
+
+void Game::rebuild_indices() {
+  _spatial_hash.clear();
+  _broad_phase.resize(_bodies.size());
+  for (usize i = 0; i < _bodies.size(); i++) {
+    const SpatialHash::Bounds bounds = bounds_of(_bodies[i]);
+    _spatial_hash.insert(static_cast<SpatialHash::Id>(i), bounds);
+    _broad_phase.set_bounds(static_cast<BroadPhase::Id>(i), bounds.min, bounds.max);
+  }
+}
@@ -8,17 +8,27 @@
 #include <rerror/error_formatter.hpp>
 #include <unders_helpers/types.hpp>
 
+#include "core/allocation_tracker.hpp"
+#include "core/renderer.hpp"
 #include "core/window.hpp"
 #include "game.hpp"
 
 int main() {
-  auto game = Game::create("SDL Test", 720, 480, Window::Flags::Resizable);
+  auto game = Game::create("SDL Test", 720, 480, Window::Flags::Resizable, Renderer::Driver::Auto);
   if (!game) {
     std::println("{:#?}", game.error());
     return 1;
   }
 
   auto result = game->run();
+
+  if constexpr (AllocationTracker::enabled) {
+    const AllocationTracker::Summary summary = AllocationTracker::summary();
+    std::println("[ALLOCATIONS] frames: {}, total: {} ({} bytes), after warmup: {} ({} bytes), peak per frame: {}",
+                 summary.frames, summary.total.allocations, summary.total.bytes,
+                 summary.steady_state.allocations, summary.steady_state.bytes, summary.peak_frame_allocations);
+  }
+
   if (!result) {
     std::println("{:#?}", result.error());
     return 1;
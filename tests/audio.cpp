@@ -0,0 +1,259 @@
+#include <SDL3/SDL_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <print>
+#include <vector>
+
+#include "core/audio.hpp"
+#include "core/audio_mixer.hpp"
+#include "test.hpp"
+
+// AudioMixer output: hundreds of voices summed up to the voice limit, the command queue filling up then draining,
+// stop/gain/stop all by voice, sounds ending or looping, linear resampling against a scalar reference and clipping
+// Then the same voices played through Audio on SDL's dummy device, the callback applying them
+// Prints the cost of mixing a buffer of every voice, resampled and at the device rate
+
+namespace {
+
+using Command = AudioMixer::Command;
+
+constexpr u32 SAMPLE_RATE = 48000;
+constexpr usize MAX_FRAMES = 1024;
+constexpr usize ODD_FRAMES = 203; // Not a multiple of the vector widths
+constexpr f32 LEVEL = 0.001f;     // 256 voices stay far from clipping
+constexpr f32 EPSILON = 1e-5f;
+constexpr usize RESAMPLED_BUFFERS = 16; // Long enough for the slowest step to reach the end of the sound
+constexpr usize BENCHMARK_BUFFERS = 2'000;
+
+Command play(AudioMixer::VoiceId voice, const std::vector<f32>& sound, f32 step = 1.0f, bool loop = true, f32 gain_left = 1.0f, f32 gain_right = 0.5f) {
+  return Command{
+      .type = Command::Type::Play,
+      .loop = loop,
+      .voice = voice,
+      .samples = sound.data(),
+      .length = static_cast<u32>(sound.size()),
+      .step = step,
+      .gain_left = gain_left,
+      .gain_right = gain_right,
+  };
+}
+
+bool near(f32 a, f32 b) {
+  return std::abs(a - b) <= EPSILON;
+}
+
+// Every frame of the output equals left/right
+bool constant_output(const f32* output, usize frames, f32 left, f32 right) {
+  for (usize i = 0; i < frames; i++) {
+    if (!near(output[i * 2], left) || !near(output[i * 2 + 1], right))
+      return false;
+  }
+  return true;
+}
+
+// Voices past MAX_VOICES are dropped, the others add up
+void check_voice_limit() {
+  const std::vector<f32> sound(MAX_FRAMES, LEVEL);
+  AudioMixer mixer(SAMPLE_RATE, MAX_FRAMES);
+  constexpr usize PLAYED = AudioMixer::MAX_VOICES + 44;
+  for (u32 voice = 0; voice < PLAYED; voice++)
+    check(mixer.push(play(voice, sound)));
+
+  const f32* output = mixer.mix(ODD_FRAMES);
+  check(mixer.active_voices() == AudioMixer::MAX_VOICES && mixer.dropped_voices() == PLAYED - AudioMixer::MAX_VOICES);
+  check(constant_output(output, ODD_FRAMES, AudioMixer::MAX_VOICES * LEVEL, AudioMixer::MAX_VOICES * LEVEL * 0.5f));
+
+  // Asking for more than max_frames mixes max_frames
+  output = mixer.mix(MAX_FRAMES * 4);
+  check(constant_output(output, MAX_FRAMES, AudioMixer::MAX_VOICES * LEVEL, AudioMixer::MAX_VOICES * LEVEL * 0.5f));
+}
+
+// The queue takes COMMAND_CAPACITY commands until mix() drains it, in order
+void check_commands() {
+  const std::vector<f32> sound(MAX_FRAMES, LEVEL);
+  AudioMixer mixer(SAMPLE_RATE, MAX_FRAMES);
+
+  usize pushed = 0;
+  while (mixer.push(play(static_cast<u32>(pushed % 8), sound)) && pushed <= AudioMixer::COMMAND_CAPACITY)
+    pushed++;
+  check(pushed == AudioMixer::COMMAND_CAPACITY);
+  (void)mixer.mix(ODD_FRAMES);
+  check(mixer.active_voices() == AudioMixer::MAX_VOICES);
+
+  // Stop all, then 8 voices of which 2 are stopped and 1 made louder, in the same batch
+  check(mixer.push(Command{.type = Command::Type::StopAll}));
+  for (u32 voice = 0; voice < 8; voice++)
+    check(mixer.push(play(voice, sound)));
+  check(mixer.push(Command{.type = Command::Type::Stop, .voice = 3}));
+  check(mixer.push(Command{.type = Command::Type::Stop, .voice = 5}));
+  check(mixer.push(Command{.type = Command::Type::SetGain, .voice = 1, .gain_left = 3.0f, .gain_right = 0.0f}));
+  check(mixer.push(Command{.type = Command::Type::Stop, .voice = 100})); // Unknown voice
+  const f32* output = mixer.mix(ODD_FRAMES);
+  check(mixer.active_voices() == 6);
+  check(constant_output(output, ODD_FRAMES, 8.0f * LEVEL, 2.5f * LEVEL));
+
+  // Emptied queue: the mixer keeps going without commands
+  output = mixer.mix(ODD_FRAMES);
+  check(mixer.active_voices() == 6 && constant_output(output, ODD_FRAMES, 8.0f * LEVEL, 2.5f * LEVEL));
+}
+
+// Ramps ending inside a buffer, then looping back to their start
+void check_end_and_loop() {
+  std::vector<f32> ramp(100);
+  for (usize i = 0; i < ramp.size(); i++)
+    ramp[i] = static_cast<f32>(i) * LEVEL;
+
+  AudioMixer mixer(SAMPLE_RATE, MAX_FRAMES);
+  check(mixer.push(play(0, ramp, 1.0f, false, 1.0f, 0.0f)));
+  const f32* output = mixer.mix(ODD_FRAMES);
+  bool ended = true;
+  for (usize i = 0; i < ODD_FRAMES; i++)
+    ended &= near(output[i * 2], i < ramp.size() ? ramp[i] : 0.0f);
+  check(ended && mixer.active_voices() == 0);
+
+  check(mixer.push(play(1, ramp, 1.0f, true, 1.0f, 0.0f)));
+  output = mixer.mix(ODD_FRAMES);
+  bool looped = true;
+  for (usize i = 0; i < ODD_FRAMES; i++)
+    looped &= near(output[i * 2], ramp[i % ramp.size()]);
+  check(looped && mixer.active_voices() == 1);
+
+  // An empty sound never plays
+  const std::vector<f32> empty;
+  check(mixer.push(Command{.type = Command::Type::StopAll}));
+  check(mixer.push(play(2, empty, 1.0f, true)));
+  (void)mixer.mix(ODD_FRAMES);
+  check(mixer.active_voices() == 0);
+}
+
+// Linear interpolation, one frame at a time with f64 positions like the scalar path
+void resample_reference(const std::vector<f32>& sound, f32 step, bool loop, f64& position, std::vector<f32>& out, usize frames) {
+  const f64 length = static_cast<f64>(sound.size());
+  for (usize i = 0; i < frames; i++) {
+    if (position >= length) {
+      if (!loop) {
+        out.push_back(0.0f);
+        continue;
+      }
+      position = std::fmod(position, length);
+    }
+    const usize index = static_cast<usize>(position);
+    const f32 fraction = static_cast<f32>(position - static_cast<f64>(index));
+    const f32 next = index + 1 < sound.size() ? sound[index + 1] : (loop ? sound[0] : 0.0f);
+    out.push_back(sound[index] + (next - sound[index]) * fraction);
+    position += step;
+  }
+}
+
+// Steps below and above 1, over several buffers of odd sizes so the vector blocks stop at every offset
+void check_resampling() {
+  std::vector<f32> sound(997);
+  for (usize i = 0; i < sound.size(); i++)
+    sound[i] = std::sin(static_cast<f32>(i) * 0.05f) * 0.5f;
+
+  for (const f32 step : {0.37f, 0.5f, 1.5f, 2.25f, 1.0f / 3.0f}) {
+    for (const bool loop : {false, true}) {
+      AudioMixer mixer(SAMPLE_RATE, MAX_FRAMES);
+      check(mixer.push(play(0, sound, step, loop, 1.0f, 0.0f)));
+
+      f64 position = 0.0;
+      std::vector<f32> expected;
+      bool matches = true;
+      for (usize buffer = 0; buffer < RESAMPLED_BUFFERS; buffer++) {
+        const usize frames = ODD_FRAMES + buffer * 7;
+        expected.clear();
+        resample_reference(sound, step, loop, position, expected, frames);
+        const f32* output = mixer.mix(frames);
+        for (usize i = 0; i < frames; i++)
+          matches &= near(output[i * 2], expected[i]) && output[i * 2 + 1] == 0.0f;
+      }
+      check(matches);
+      check(mixer.active_voices() == (loop ? 1u : 0u));
+    }
+  }
+}
+
+void check_clipping() {
+  const std::vector<f32> loud(MAX_FRAMES, 0.5f);
+  AudioMixer mixer(SAMPLE_RATE, MAX_FRAMES);
+  for (u32 voice = 0; voice < 4; voice++)
+    check(mixer.push(play(voice, loud, 1.0f, true, 1.0f, -1.0f))); // Inverted on the right
+  check(constant_output(mixer.mix(ODD_FRAMES), ODD_FRAMES, 1.0f, -1.0f));
+
+  // 0.5 + 0.25 stays as is
+  check(mixer.push(Command{.type = Command::Type::StopAll}));
+  check(mixer.push(play(0, loud, 1.0f, true, 1.0f, -1.0f)));
+  check(mixer.push(play(1, loud, 1.0f, true, 0.5f, -0.5f)));
+  check(constant_output(mixer.mix(ODD_FRAMES), ODD_FRAMES, 0.75f, -0.75f));
+}
+
+// Hundreds of voices through Audio, the dummy device's callback picks them up on its own thread
+void check_device() {
+  auto audio = Audio::create();
+  if (!check(audio.has_value()))
+    return;
+
+  auto sound = audio->add_sound(std::vector<f32>(SAMPLE_RATE, LEVEL), SAMPLE_RATE / 2);
+  if (!check(sound.has_value()))
+    return;
+
+  constexpr usize PLAYED = AudioMixer::MAX_VOICES + 44;
+  std::vector<Audio::VoiceId> voices;
+  for (usize i = 0; i < PLAYED; i++) {
+    auto voice = audio->play(*sound, Audio::PlayParameters{.gain = 0.5f, .pan = -0.5f, .loop = true});
+    if (check(voice.has_value()))
+      voices.push_back(*voice);
+  }
+  check(std::ranges::adjacent_find(voices, std::ranges::greater_equal()) == voices.end()); // Increasing ids
+
+  // Polled, the callback runs every few ms
+  const auto wait_for = [&](auto&& condition) {
+    for (u32 attempt = 0; attempt < 400 && !condition(); attempt++)
+      SDL_Delay(5);
+    return condition();
+  };
+  check(wait_for([&] { return audio->mixer().active_voices() == AudioMixer::MAX_VOICES; }));
+  check(audio->mixer().dropped_voices() == PLAYED - AudioMixer::MAX_VOICES);
+
+  check(audio->stop(voices.front()).has_value());
+  check(wait_for([&] { return audio->mixer().active_voices() == AudioMixer::MAX_VOICES - 1; }));
+  check(audio->set_gain(voices[1], 0.25f).has_value());
+  check(audio->stop_all().has_value());
+  check(wait_for([&] { return audio->mixer().active_voices() == 0; }));
+
+  check(!audio->play(1000).has_value()); // Unknown sound
+}
+
+void benchmark() {
+  const std::vector<f32> sound(SAMPLE_RATE, LEVEL);
+  constexpr usize FRAMES = Audio::DEFAULT_BUFFER_FRAMES;
+  for (const f32 step : {1.0f, 0.9186f}) { // Device rate, then 44.1 kHz to 48 kHz
+    AudioMixer mixer(SAMPLE_RATE, FRAMES);
+    for (u32 voice = 0; voice < AudioMixer::MAX_VOICES; voice++)
+      check(mixer.push(play(voice, sound, step)));
+
+    f32 sum = 0.0f;
+    const f64 time = nanoseconds_per(BENCHMARK_BUFFERS, [&] {
+      for (usize buffer = 0; buffer < BENCHMARK_BUFFERS; buffer++)
+        sum += mixer.mix(FRAMES)[0];
+    });
+    check(sum > 0.0f);
+
+    std::println("[AUDIO] {} voices, {} frames at step {}: {:.1f} us per buffer", AudioMixer::MAX_VOICES, FRAMES, step, time / 1000.0);
+  }
+}
+
+} // namespace
+
+int main() {
+  check_voice_limit();
+  check_commands();
+  check_end_and_loop();
+  check_resampling();
+  check_clipping();
+  check_device();
+  benchmark();
+  return failures();
+}
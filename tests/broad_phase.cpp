@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <print>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/broad_phase.hpp"
+#include "test.hpp"
+
+// Sort and sweep against the naive O(n^2) test of every pair, on bodies moving a little every tick like in the game
+// Checks both return the same pairs and prints the time per tick of each
+
+namespace {
+
+constexpr usize BODY_COUNT = 4'000;
+constexpr usize TICKS = 60;
+constexpr f32 WORLD_SIZE = 4'000.0f;
+constexpr f32 MAX_HALF_SIZE = 12.0f;
+constexpr f32 MAX_SPEED = 3.0f; // Per tick
+
+struct Body {
+  glm::vec2 position;
+  glm::vec2 velocity;
+  f32 half_size;
+};
+
+glm::vec2 min_of(const Body& body) {
+  return body.position - glm::vec2(body.half_size, body.half_size);
+}
+glm::vec2 max_of(const Body& body) {
+  return body.position + glm::vec2(body.half_size, body.half_size);
+}
+
+using PairKey = std::pair<BroadPhase::Id, BroadPhase::Id>;
+
+PairKey key_of(BroadPhase::Id a, BroadPhase::Id b) {
+  return a < b ? PairKey{a, b} : PairKey{b, a};
+}
+
+// Same inclusive overlap test as the sweep
+void naive_pairs(const std::vector<Body>& bodies, std::vector<PairKey>& pairs) {
+  pairs.clear();
+  for (usize i = 0; i < bodies.size(); i++) {
+    for (usize j = i + 1; j < bodies.size(); j++) {
+      const glm::vec2 a_min = min_of(bodies[i]), a_max = max_of(bodies[i]);
+      const glm::vec2 b_min = min_of(bodies[j]), b_max = max_of(bodies[j]);
+      if (a_min.x <= b_max.x && b_min.x <= a_max.x && a_min.y <= b_max.y && b_min.y <= a_max.y)
+        pairs.push_back(key_of(static_cast<BroadPhase::Id>(i), static_cast<BroadPhase::Id>(j)));
+    }
+  }
+}
+
+void step(std::vector<Body>& bodies) {
+  for (Body& body : bodies) {
+    body.position += body.velocity;
+    for (i32 axis = 0; axis < 2; axis++) {
+      if (body.position[axis] < 0.0f || body.position[axis] > WORLD_SIZE) {
+        body.position[axis] = std::clamp(body.position[axis], 0.0f, WORLD_SIZE);
+        body.velocity[axis] = -body.velocity[axis];
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 random(30);
+  std::uniform_real_distribution<f32> position(0.0f, WORLD_SIZE);
+  std::uniform_real_distribution<f32> velocity(-MAX_SPEED, MAX_SPEED);
+  std::uniform_real_distribution<f32> half_size(1.0f, MAX_HALF_SIZE);
+
+  std::vector<Body> bodies(BODY_COUNT);
+  for (Body& body : bodies)
+    body = Body{{position(random), position(random)}, {velocity(random), velocity(random)}, half_size(random)};
+
+  BroadPhase broad_phase;
+  broad_phase.resize(bodies.size());
+
+  std::vector<PairKey> expected, found;
+  f64 naive_time = 0.0, broad_phase_time = 0.0;
+  usize pair_count = 0;
+  for (usize tick = 0; tick < TICKS; tick++) {
+    step(bodies);
+
+    naive_time += nanoseconds_per(1, [&] { naive_pairs(bodies, expected); });
+    broad_phase_time += nanoseconds_per(1, [&] {
+      for (usize i = 0; i < bodies.size(); i++)
+        broad_phase.set_bounds(static_cast<BroadPhase::Id>(i), min_of(bodies[i]), max_of(bodies[i]));
+      broad_phase.update();
+    });
+
+    found.clear();
+    for (const BroadPhase::Pair& pair : broad_phase.pairs())
+      found.push_back(key_of(pair.a, pair.b));
+    std::ranges::sort(expected);
+    std::ranges::sort(found);
+    check(std::ranges::adjacent_find(found) == found.end()); // Each pair once
+    check(found == expected);
+    pair_count += expected.size();
+  }
+
+  // Shrinking then growing keeps the order valid for the remaining ids
+  bodies.resize(BODY_COUNT / 2);
+  broad_phase.resize(bodies.size());
+  bodies.resize(BODY_COUNT);
+  broad_phase.resize(bodies.size());
+  for (usize i = BODY_COUNT / 2; i < bodies.size(); i++)
+    bodies[i] = Body{{position(random), position(random)}, {}, half_size(random)};
+  for (usize i = 0; i < bodies.size(); i++)
+    broad_phase.set_bounds(static_cast<BroadPhase::Id>(i), min_of(bodies[i]), max_of(bodies[i]));
+  naive_pairs(bodies, expected);
+  found.clear();
+  for (const BroadPhase::Pair& pair : broad_phase.update())
+    found.push_back(key_of(pair.a, pair.b));
+  std::ranges::sort(expected);
+  std::ranges::sort(found);
+  check(found == expected);
+
+  std::println("[BROAD_PHASE] {} bodies, {:.1f} pairs/tick: naive {:.3f} ms/tick, sort and sweep {:.3f} ms/tick", BODY_COUNT,
+               static_cast<f64>(pair_count) / TICKS, naive_time / TICKS / 1e6, broad_phase_time / TICKS / 1e6);
+  return failures();
+}
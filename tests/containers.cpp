@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <print>
+#include <random>
+#include <string>
+#include <unders_helpers/flat_hash_map.hpp>
+#include <unders_helpers/small_vector.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "test.hpp"
+
+// flat_hash_map and small_vector replay the same random operations as std::unordered_map and std::vector and must end
+// up with the same content (strings as elements, so moves and destructions are exercised)
+// Prints insert/lookup times against std::unordered_map and short-lived vectors against std::vector
+
+namespace {
+
+constexpr usize OPERATION_COUNT = 200'000;
+constexpr u32 KEY_RANGE = 20'000; // Small enough for inserts to hit existing keys and erases to leave tombstones
+constexpr usize BENCHMARK_COUNT = 1'000'000;
+constexpr usize INLINE_SIZE = 8;
+
+template <typename TMap>
+std::vector<std::pair<u32, std::string>> sorted_content(const TMap& map) {
+  std::vector<std::pair<u32, std::string>> content(map.begin(), map.end());
+  std::ranges::sort(content);
+  return content;
+}
+
+void check_flat_hash_map() {
+  std::mt19937 random(36);
+  std::uniform_int_distribution<u32> key(0, KEY_RANGE - 1);
+
+  uh::flat_hash_map<u32, std::string> map;
+  std::unordered_map<u32, std::string> expected;
+  bool same_results = true;
+  for (usize i = 0; i < OPERATION_COUNT; i++) {
+    const u32 k = key(random);
+    switch (random() % 5) {
+      case 0:
+      case 1:
+        same_results &= map.try_emplace(k, std::to_string(i)).second == expected.try_emplace(k, std::to_string(i)).second;
+        break;
+      case 2:
+        map[k] = std::to_string(k);
+        expected[k] = std::to_string(k);
+        break;
+      case 3:
+        same_results &= map.erase(k) == expected.erase(k);
+        break;
+      default: {
+        const auto found = map.find(k);
+        const auto expected_found = expected.find(k);
+        same_results &= (found == map.end()) == (expected_found == expected.end());
+        if (found != map.end() && expected_found != expected.end())
+          same_results &= found->second == expected_found->second;
+      }
+    }
+  }
+  check(same_results);
+  check(map.size() == expected.size());
+  check(map.load_factor() <= 7.0f / 8.0f);
+  check(sorted_content(map) == sorted_content(expected));
+
+  // Copies are deep, moves leave an empty map that can be reused
+  uh::flat_hash_map<u32, std::string> copy(map);
+  map.clear();
+  check(map.empty() && map.begin() == map.end());
+  check(sorted_content(copy) == sorted_content(expected));
+  uh::flat_hash_map<u32, std::string> moved(std::move(copy));
+  check(sorted_content(moved) == sorted_content(expected));
+  copy[1] = "one";
+  check(copy.size() == 1 && copy.at(1) == "one");
+
+  // Erasing while iterating through positions
+  for (auto it = moved.begin(); it != moved.end(); ++it)
+    if (it->first % 2 == 0)
+      moved.erase(it);
+  std::erase_if(expected, [](const auto& element) { return element.first % 2 == 0; });
+  check(sorted_content(moved) == sorted_content(expected));
+}
+
+void check_small_vector() {
+  std::mt19937 random(36);
+
+  uh::small_vector<std::string, INLINE_SIZE> vector;
+  std::vector<std::string> expected;
+  bool went_inline_to_heap = false;
+  for (usize i = 0; i < OPERATION_COUNT; i++) {
+    const usize size = expected.size();
+    switch (random() % 7) {
+      case 0:
+      case 1:
+        vector.push_back(std::to_string(i));
+        expected.push_back(std::to_string(i));
+        break;
+      case 2:
+        if (size > 0) {
+          vector.pop_back();
+          expected.pop_back();
+        }
+        break;
+      case 3: {
+        const usize index = size == 0 ? 0 : random() % (size + 1);
+        vector.insert(vector.begin() + index, std::to_string(i));
+        expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(index), std::to_string(i));
+        break;
+      }
+      case 4:
+        if (size > 0) {
+          const usize index = random() % size;
+          vector.erase(vector.begin() + index);
+          expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(index));
+        }
+        break;
+      case 5: {
+        // Mostly small sizes, so the vector keeps crossing the inline capacity
+        const usize new_size = random() % (INLINE_SIZE * 3);
+        vector.resize(new_size, "resized");
+        expected.resize(new_size, "resized");
+        break;
+      }
+      default: {
+        // Copies and moves, from inline and heap storage
+        uh::small_vector<std::string, INLINE_SIZE> copy(vector);
+        went_inline_to_heap |= !copy.is_inline();
+        vector = std::move(copy);
+      }
+    }
+  }
+  check(went_inline_to_heap);
+  check(std::ranges::equal(vector, expected));
+
+  uh::small_vector<std::string, INLINE_SIZE> inline_values{"a", "b", "c"};
+  check(inline_values.is_inline() && inline_values.size() == 3 && inline_values.back() == "c");
+}
+
+void benchmark_flat_hash_map() {
+  std::mt19937 random(36);
+  std::vector<u32> keys(BENCHMARK_COUNT);
+  for (u32& key : keys)
+    key = static_cast<u32>(random());
+
+  uh::flat_hash_map<u32, u32> map;
+  std::unordered_map<u32, u32> std_map;
+  const f64 insert_time = nanoseconds_per(keys.size(), [&] {
+    for (u32 key : keys)
+      map[key] = key;
+  });
+  const f64 std_insert_time = nanoseconds_per(keys.size(), [&] {
+    for (u32 key : keys)
+      std_map[key] = key;
+  });
+
+  std::ranges::shuffle(keys, random);
+  u64 sum = 0, std_sum = 0;
+  const f64 lookup_time = nanoseconds_per(keys.size(), [&] {
+    for (u32 key : keys)
+      sum += map.find(key)->second;
+  });
+  const f64 std_lookup_time = nanoseconds_per(keys.size(), [&] {
+    for (u32 key : keys)
+      std_sum += std_map.find(key)->second;
+  });
+  check(sum == std_sum);
+
+  std::println("[FLAT_HASH_MAP] insert: {:.1f} ns (std::unordered_map {:.1f} ns), lookup: {:.1f} ns (std::unordered_map {:.1f} ns)", insert_time,
+               std_insert_time, lookup_time, std_lookup_time);
+}
+
+// A few elements per short-lived container, like the results of se::split
+template <typename TVector>
+[[gnu::noinline]] usize fill_short_lived(usize index) {
+  TVector values;
+  for (usize i = 0; i < index % INLINE_SIZE; i++)
+    values.push_back(static_cast<u32>(index + i));
+  return values.size();
+}
+
+void benchmark_small_vector() {
+  usize count = 0, std_count = 0;
+  const f64 time = nanoseconds_per(BENCHMARK_COUNT, [&] {
+    for (usize i = 0; i < BENCHMARK_COUNT; i++)
+      count += fill_short_lived<uh::small_vector<u32, INLINE_SIZE>>(i);
+  });
+  const f64 std_time = nanoseconds_per(BENCHMARK_COUNT, [&] {
+    for (usize i = 0; i < BENCHMARK_COUNT; i++)
+      std_count += fill_short_lived<std::vector<u32>>(i);
+  });
+  check(count == std_count);
+
+  std::println("[SMALL_VECTOR] short-lived (up to {} elements): {:.1f} ns (std::vector {:.1f} ns)", INLINE_SIZE - 1, time, std_time);
+}
+
+} // namespace
+
+int main() {
+  check_flat_hash_map();
+  check_small_vector();
+
+  benchmark_flat_hash_map();
+  benchmark_small_vector();
+  return failures();
+}
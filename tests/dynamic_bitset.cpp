@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <print>
+#include <random>
+#include <unders_helpers/dynamic_bitset.hpp>
+#include <utility>
+#include <vector>
+
+#include "test.hpp"
+
+// dynamic_bitset against a std::vector<bool> reference, on sizes around the word and AVX2 block boundaries
+// Then operations between bitsets of different sizes, the shorter one read as 0 past its size()
+// Built with SDL_TEST_NATIVE_ARCH the AVX2 paths are the ones tested
+// Prints the set-bit iteration and popcount speed of a large sparse set
+
+namespace {
+
+constexpr usize BENCHMARK_BITS = 1u << 24;
+constexpr u32 BENCHMARK_DENSITY = 64; // One bit in
+
+using Reference = std::vector<bool>;
+
+uh::dynamic_bitset random_bitset(std::mt19937& random, usize size, Reference& reference) {
+  uh::dynamic_bitset bitset(size);
+  reference.assign(size, false);
+  for (usize i = 0; i < size; i++) {
+    if (random() % 3 == 0) {
+      bitset.set(i);
+      reference[i] = true;
+    }
+  }
+  return bitset;
+}
+
+bool matches(const uh::dynamic_bitset& bitset, const Reference& reference) {
+  if (bitset.size() != reference.size())
+    return false;
+
+  usize count = 0;
+  for (usize i = 0; i < reference.size(); i++) {
+    if (bitset.test(i) != reference[i])
+      return false;
+    count += reference[i] ? 1 : 0;
+  }
+  return bitset.count() == count && bitset.any() == (count > 0) && bitset.all() == (count == reference.size());
+}
+
+void check_size(std::mt19937& random, usize size) {
+  Reference a_reference, b_reference;
+  const uh::dynamic_bitset a = random_bitset(random, size, a_reference);
+  const uh::dynamic_bitset b = random_bitset(random, size, b_reference);
+  check(matches(a, a_reference));
+
+  Reference and_reference(size), or_reference(size), xor_reference(size), and_not_reference(size);
+  bool intersects = false, subset = true;
+  for (usize i = 0; i < size; i++) {
+    and_reference[i] = a_reference[i] && b_reference[i];
+    or_reference[i] = a_reference[i] || b_reference[i];
+    xor_reference[i] = a_reference[i] != b_reference[i];
+    and_not_reference[i] = a_reference[i] && !b_reference[i];
+    intersects |= and_reference[i];
+    subset &= !a_reference[i] || b_reference[i];
+  }
+  check(matches(a & b, and_reference));
+  check(matches(a | b, or_reference));
+  check(matches(a ^ b, xor_reference));
+  uh::dynamic_bitset and_not = a;
+  check(matches(and_not.and_not(b), and_not_reference));
+  check(a.intersects(b) == intersects);
+  check(a.is_subset_of(b) == subset);
+  check((a & b).is_subset_of(a));
+
+  // Iteration visits exactly the set bits, in order
+  std::vector<usize> visited, expected;
+  a.for_each_set([&](usize index) { visited.push_back(index); });
+  for (usize i = 0; i < size; i++)
+    if (a_reference[i])
+      expected.push_back(i);
+  check(visited == expected);
+
+  std::vector<usize> found;
+  for (usize index = a.find_first(); index != uh::dynamic_bitset::NPOS; index = a.find_next(index + 1))
+    found.push_back(index);
+  check(found == expected);
+
+  // Bits past size() stay clear through whole-set operations
+  uh::dynamic_bitset flipped = a;
+  flipped.flip();
+  check(flipped.count() == size - a.count());
+  flipped.set();
+  check(flipped.all() && flipped.count() == size);
+}
+
+// a <operation> b keeps a's size, a bit missing from the shorter one is 0
+void check_sizes(std::mt19937& random, usize a_size, usize b_size) {
+  Reference a_reference, b_reference;
+  const uh::dynamic_bitset a = random_bitset(random, a_size, a_reference);
+  const uh::dynamic_bitset b = random_bitset(random, b_size, b_reference);
+  b_reference.resize(std::max(a_size, b_size), false);
+
+  Reference and_reference(a_size), or_reference(a_size), xor_reference(a_size), and_not_reference(a_size);
+  bool intersects = false, subset = true;
+  for (usize i = 0; i < a_size; i++) {
+    and_reference[i] = a_reference[i] && b_reference[i];
+    or_reference[i] = a_reference[i] || b_reference[i];
+    xor_reference[i] = a_reference[i] != b_reference[i];
+    and_not_reference[i] = a_reference[i] && !b_reference[i];
+    intersects |= and_reference[i];
+    subset &= !a_reference[i] || b_reference[i];
+  }
+  check(matches(a & b, and_reference));
+  check(matches(a | b, or_reference));
+  check(matches(a ^ b, xor_reference));
+  uh::dynamic_bitset and_not = a;
+  check(matches(and_not.and_not(b), and_not_reference));
+  check(a.intersects(b) == intersects && b.intersects(a) == intersects);
+  check(a.is_subset_of(b) == subset);
+
+  // Full sets: the larger one is never a subset of the smaller, bits past a's size never leak into it
+  uh::dynamic_bitset full_a(a_size, true);
+  const uh::dynamic_bitset full_b(b_size, true);
+  check(full_a.is_subset_of(full_b) == (a_size <= b_size));
+  check((full_a | full_b).count() == a_size && (full_a ^ full_b).count() == (a_size > b_size ? a_size - b_size : 0));
+  check((full_a &= full_b).count() == std::min(a_size, b_size) && full_a.size() == a_size);
+}
+
+void benchmark() {
+  std::mt19937 random(37);
+  uh::dynamic_bitset bitset(BENCHMARK_BITS);
+  for (usize i = 0; i < BENCHMARK_BITS / BENCHMARK_DENSITY; i++)
+    bitset.set(random() % BENCHMARK_BITS);
+
+  usize sum = 0, count = 0;
+  const f64 iteration_time = nanoseconds_per(BENCHMARK_BITS, [&] { bitset.for_each_set([&](usize index) { sum += index; }); });
+  const f64 count_time = nanoseconds_per(BENCHMARK_BITS, [&] { count = bitset.count(); });
+  check(count > 0 && sum > 0);
+
+  std::println("[DYNAMIC_BITSET] {} bits, {} set: iteration {:.3f} ns/bit, count {:.4f} ns/bit", BENCHMARK_BITS, count, iteration_time, count_time);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 random(37);
+  for (usize size : {0u, 1u, 63u, 64u, 65u, 255u, 256u, 257u, 1000u, 4096u + 17u})
+    check_size(random, size);
+  for (const auto& [a_size, b_size] : {std::pair<usize, usize>{1, 0}, {64, 1}, {65, 64}, {70, 100}, {100, 70}, {257, 256}, {300, 1000}, {1000, 300}, {4096 + 17, 129}})
+    check_sizes(random, a_size, b_size);
+
+  benchmark();
+  return failures();
+}
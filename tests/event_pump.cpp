@@ -0,0 +1,240 @@
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_events.h>
+#include <SDL3/SDL_init.h>
+
+#include <atomic>
+#include <print>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/event_pump.hpp"
+#include "test.hpp"
+
+// EventPump on events pushed to SDL's queue: runs of motions of one source merged into one event (last position, summed
+// deltas) while other events and other sources keep their order, keys carried over frames, the per frame capacity
+// Snapshots: a pinned state stays unchanged over any number of pumps, while workers take and keep snapshots as fast as
+// they can during thousands of pumps
+// Prints the cost of pumping a frame of high rate mouse motions
+
+namespace {
+
+using Snapshot = EventPump::Snapshot;
+
+constexpr usize MOTIONS = 300;
+constexpr usize FRAMES = 20'000;
+constexpr usize WORKERS = 3;
+constexpr usize BENCHMARK_FRAMES = 1'000;
+
+SDL_Event motion(SDL_MouseID mouse, f32 x, f32 y, f32 dx, f32 dy) {
+  SDL_Event event{};
+  event.motion.type = SDL_EVENT_MOUSE_MOTION;
+  event.motion.which = mouse;
+  event.motion.x = x;
+  event.motion.y = y;
+  event.motion.xrel = dx;
+  event.motion.yrel = dy;
+  return event;
+}
+
+SDL_Event finger(SDL_FingerID id, f32 x, f32 dx) {
+  SDL_Event event{};
+  event.tfinger.type = SDL_EVENT_FINGER_MOTION;
+  event.tfinger.touchID = 1;
+  event.tfinger.fingerID = id;
+  event.tfinger.x = x;
+  event.tfinger.dx = dx;
+  return event;
+}
+
+SDL_Event key(SDL_Scancode scancode, bool down, bool repeat = false) {
+  SDL_Event event{};
+  event.key.type = down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+  event.key.scancode = scancode;
+  event.key.down = down;
+  event.key.repeat = repeat;
+  return event;
+}
+
+SDL_Event wheel(f32 y) {
+  SDL_Event event{};
+  event.wheel.type = SDL_EVENT_MOUSE_WHEEL;
+  event.wheel.y = y;
+  return event;
+}
+
+void push(SDL_Event event) {
+  check(SDL_PushEvent(&event));
+}
+
+void check_merging() {
+  EventPump pump;
+  (void)pump.pump(); // Whatever SDL queued on its own
+
+  // Mouse 1, a key, mouse 1 again, mouse 2, fingers 1 and 2 interleaved, a scroll
+  for (usize i = 0; i < MOTIONS; i++)
+    push(motion(1, static_cast<f32>(i), 2.0f * static_cast<f32>(i), 1.0f, -1.0f));
+  push(key(SDL_SCANCODE_A, true));
+  for (usize i = 0; i < 100; i++)
+    push(motion(1, 5.0f, 6.0f, 2.0f, 0.0f));
+  for (usize i = 0; i < 100; i++)
+    push(motion(2, 7.0f, 8.0f, 0.5f, 0.5f));
+  for (usize i = 0; i < 10; i++) {
+    push(finger(1, static_cast<f32>(i), 0.25f));
+    push(finger(2, static_cast<f32>(i), 0.25f));
+  }
+  push(wheel(3.0f));
+
+  const std::span<const SDL_Event> events = pump.pump();
+  check(pump.received() == MOTIONS + 1 + 200 + 20 + 1 && pump.delivered() == events.size());
+  if (!check(events.size() == 5 + 20))
+    return;
+
+  check(events[0].type == SDL_EVENT_MOUSE_MOTION && events[0].motion.x == MOTIONS - 1 && events[0].motion.y == 2 * (MOTIONS - 1));
+  check(events[0].motion.xrel == MOTIONS && events[0].motion.yrel == -static_cast<f32>(MOTIONS));
+  check(events[1].type == SDL_EVENT_KEY_DOWN && events[1].key.scancode == SDL_SCANCODE_A);
+  check(events[2].motion.which == 1 && events[2].motion.xrel == 200.0f && events[2].motion.x == 5.0f);
+  check(events[3].motion.which == 2 && events[3].motion.xrel == 50.0f && events[3].motion.y == 8.0f);
+  check(events[4].type == SDL_EVENT_FINGER_MOTION && events[4].tfinger.fingerID == 1 && events[5].tfinger.fingerID == 2); // Not consecutive
+  check(events.back().type == SDL_EVENT_MOUSE_WHEEL);
+
+  // The state sees every event, merged or not
+  const InputState& state = pump.state();
+  check(state.mouse_x == 7.0f && state.mouse_y == 8.0f);
+  check(state.mouse_delta_x == MOTIONS + 200.0f + 50.0f && state.mouse_delta_y == -static_cast<f32>(MOTIONS) + 50.0f);
+  check(state.wheel_y == 3.0f);
+  check(state.was_pressed(SDL_SCANCODE_A) && state.is_held(SDL_SCANCODE_A) && !state.was_released(SDL_SCANCODE_A));
+
+  // Held keys and the position carry over, per frame sums and edges do not, repeats are not presses
+  push(key(SDL_SCANCODE_A, true, true));
+  (void)pump.pump();
+  check(pump.state().is_held(SDL_SCANCODE_A) && !pump.state().was_pressed(SDL_SCANCODE_A));
+  check(pump.state().mouse_x == 7.0f && pump.state().mouse_delta_x == 0.0f && pump.state().wheel_y == 0.0f);
+
+  push(key(SDL_SCANCODE_A, false));
+  (void)pump.pump();
+  check(!pump.state().is_held(SDL_SCANCODE_A) && pump.state().was_released(SDL_SCANCODE_A));
+}
+
+// Events past CAPACITY wait for the next frame
+void check_capacity() {
+  EventPump pump;
+  (void)pump.pump();
+
+  constexpr usize EXTRA = 100;
+  for (usize i = 0; i < EventPump::CAPACITY + EXTRA; i++)
+    push(key(SDL_SCANCODE_B, i % 2 == 0));
+  check(pump.pump().size() == EventPump::CAPACITY);
+  check(pump.pump().size() == EXTRA && pump.pump().empty());
+}
+
+void check_snapshots() {
+  EventPump pump;
+  push(motion(1, 1.0f, 0.0f, 0.0f, 0.0f));
+  (void)pump.pump();
+
+  // Kept over many pumps
+  const Snapshot first = pump.snapshot();
+  check(first && first->frame == pump.state().frame && first->mouse_x == 1.0f);
+  const u64 first_frame = first->frame;
+  for (usize i = 0; i < 20; i++) {
+    push(motion(1, 2.0f + static_cast<f32>(i), 0.0f, 0.0f, 0.0f));
+    (void)pump.pump();
+  }
+  check(first->frame == first_frame && first->mouse_x == 1.0f && pump.state().frame == first_frame + 20);
+  check(pump.slots() == EventPump::STATE_SLOTS);
+
+  // More snapshots kept than slots, the pump adds some
+  std::vector<Snapshot> kept;
+  for (usize i = 0; i < 2 * EventPump::STATE_SLOTS; i++) {
+    kept.push_back(pump.snapshot());
+    push(motion(1, 100.0f + static_cast<f32>(i), 0.0f, 0.0f, 0.0f));
+    (void)pump.pump();
+  }
+  bool unchanged = true;
+  for (usize i = 0; i < kept.size(); i++)
+    unchanged &= kept[i]->frame == first_frame + 20 + i && kept[i]->mouse_x == (i == 0 ? 21.0f : 100.0f + static_cast<f32>(i - 1));
+  check(unchanged && pump.slots() > EventPump::STATE_SLOTS);
+
+  // Released, the slots are reused without allocating
+  kept.clear();
+  Snapshot moved = pump.snapshot();
+  const Snapshot taken = std::move(moved);
+  check(!moved && taken->frame == pump.state().frame);
+  const usize slots = pump.slots();
+  const u64 allocations = allocations_during([&] {
+    for (usize i = 0; i < 100; i++)
+      (void)pump.pump();
+  });
+  check(allocations == 0 && pump.slots() == slots);
+}
+
+// Frame n holds one motion to x = n and one scroll of n: any mix of two frames shows in a snapshot
+void check_concurrent_snapshots() {
+  EventPump pump;
+
+  std::atomic<bool> done = false;
+  std::atomic<usize> mismatches = 0, taken = 0;
+  const auto consistent = [](const InputState& state) { return state.mouse_x == static_cast<f32>(state.frame) && state.wheel_y == static_cast<f32>(state.frame); };
+  std::vector<std::jthread> workers;
+  for (usize worker = 0; worker < WORKERS; worker++) {
+    workers.emplace_back([&] {
+      Snapshot previous;
+      while (!done.load(std::memory_order_relaxed)) {
+        Snapshot snapshot = pump.snapshot();
+        const u64 frame = snapshot->frame;
+        std::this_thread::yield(); // Pumps go on meanwhile
+        if (!consistent(*snapshot) || snapshot->frame != frame || (previous && (!consistent(*previous) || previous->frame > frame)))
+          mismatches.fetch_add(1, std::memory_order_relaxed);
+        previous = std::move(snapshot); // Two snapshots held at a time
+        taken.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for (usize frame = 1; frame < FRAMES; frame++) {
+    push(motion(1, static_cast<f32>(frame), 0.0f, 1.0f, 0.0f));
+    push(wheel(static_cast<f32>(frame)));
+    (void)pump.pump();
+  }
+  done.store(true, std::memory_order_relaxed);
+  workers.clear();
+
+  check(mismatches.load() == 0 && taken.load() > 0);
+  check(pump.slots() <= EventPump::STATE_SLOTS + 2 * WORKERS);
+}
+
+void benchmark() {
+  EventPump pump;
+  (void)pump.pump();
+
+  usize delivered = 0;
+  const f64 time = nanoseconds_per(BENCHMARK_FRAMES, [&] {
+    for (usize frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+      for (usize i = 0; i < MOTIONS; i++)
+        push(motion(1, static_cast<f32>(i), 0.0f, 1.0f, 0.0f));
+      delivered += pump.pump().size();
+    }
+  });
+  check(delivered == BENCHMARK_FRAMES);
+
+  std::println("[EVENT_PUMP] {} motions pushed and pumped: {:.1f} us per frame", MOTIONS, time / 1000.0);
+}
+
+} // namespace
+
+int main() {
+  if (!SDL_Init(SDL_INIT_EVENTS)) {
+    std::println(stderr, "SDL_Init failed: {}", SDL_GetError());
+    return 1;
+  }
+
+  check_merging();
+  check_capacity();
+  check_snapshots();
+  check_concurrent_snapshots();
+  benchmark();
+
+  SDL_Quit();
+  return failures();
+}
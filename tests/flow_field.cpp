@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <print>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "core/flow_field.hpp"
+#include "core/flow_field_cache.hpp"
+#include "core/navigation_grid.hpp"
+#include "test.hpp"
+
+// FlowField against a plain Dijkstra over the whole grid, after compute() and after every incremental update()
+// Grid sizes aren't multiples of the tile size and targets sit on tile borders, where the wavefront hands values over
+// Prints the time of a full compute and of an update around a few changes
+
+namespace {
+
+constexpr u32 RANDOM_GRIDS = 40;
+constexpr u32 UPDATES_PER_GRID = 12;
+constexpr u32 BENCHMARK_SIZE = 512;
+constexpr u32 BENCHMARK_ROUNDS = 10;
+
+NavigationGrid make_grid(u32 width, u32 height) {
+  auto grid = NavigationGrid::create(width, height, 1.0f);
+  check(grid.has_value());
+  return std::move(*grid);
+}
+
+// Same rules as the wavefront: entering a cell costs weight * cost, diagonals can't cut wall corners
+bool can_step(const NavigationGrid& grid, u32 x, u32 y, const FlowField::Step& step) {
+  const i64 next_x = static_cast<i64>(x) + step.dx, next_y = static_cast<i64>(y) + step.dy;
+  if (next_x < 0 || next_y < 0 || next_x >= grid.width() || next_y >= grid.height())
+    return false;
+  if (!grid.is_walkable(grid.cell(static_cast<u32>(next_x), static_cast<u32>(next_y))))
+    return false;
+  return step.dx == 0 || step.dy == 0 ||
+         (grid.is_walkable(grid.cell(static_cast<u32>(next_x), y)) && grid.is_walkable(grid.cell(x, static_cast<u32>(next_y))));
+}
+
+std::vector<u32> reference_integration(const NavigationGrid& grid, u32 target) {
+  std::vector<u32> distances(grid.cell_count(), FlowField::UNREACHABLE);
+  if (!grid.is_walkable(target))
+    return distances;
+
+  using Entry = std::pair<u32, u32>; // Distance, cell
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+  distances[target] = 0;
+  queue.emplace(0, target);
+  while (!queue.empty()) {
+    const auto [distance, cell] = queue.top();
+    queue.pop();
+    if (distance != distances[cell])
+      continue;
+
+    const u32 x = cell % grid.width(), y = cell / grid.width();
+    for (const FlowField::Step& step : FlowField::STEPS) {
+      // Neighbor stepping onto cell
+      const i64 from_x = static_cast<i64>(x) - step.dx, from_y = static_cast<i64>(y) - step.dy;
+      if (from_x < 0 || from_y < 0 || from_x >= grid.width() || from_y >= grid.height())
+        continue;
+      const u32 from = grid.cell(static_cast<u32>(from_x), static_cast<u32>(from_y));
+      if (!grid.is_walkable(from) || !can_step(grid, static_cast<u32>(from_x), static_cast<u32>(from_y), step))
+        continue;
+      const u32 next_distance = distance + step.weight * grid.cost(cell);
+      if (next_distance < distances[from]) {
+        distances[from] = next_distance;
+        queue.emplace(next_distance, from);
+      }
+    }
+  }
+  return distances;
+}
+
+// Integration equal to the reference everywhere, and every direction steps to a neighbor on a cheapest path
+u32 mismatches(const NavigationGrid& grid, const FlowField& field) {
+  const std::vector<u32> expected = reference_integration(grid, field.target());
+  u32 count = 0;
+  for (u32 cell = 0; cell < grid.cell_count(); cell++) {
+    if (field.integration(cell) != expected[cell]) {
+      count++;
+      continue;
+    }
+
+    const u8 direction = field.direction_index(cell);
+    if (cell == field.target() && grid.is_walkable(cell)) {
+      count += direction != FlowField::DIRECTION_TARGET;
+    } else if (expected[cell] == FlowField::UNREACHABLE) {
+      count += direction != FlowField::DIRECTION_NONE;
+    } else if (direction >= FlowField::STEPS.size()) {
+      count++;
+    } else {
+      const FlowField::Step& step = FlowField::STEPS[direction];
+      const u32 x = cell % grid.width(), y = cell / grid.width();
+      const u32 next = grid.cell(static_cast<u32>(static_cast<i64>(x) + step.dx), static_cast<u32>(static_cast<i64>(y) + step.dy));
+      count += !can_step(grid, x, y, step) || expected[next] + step.weight * grid.cost(next) != expected[cell];
+    }
+  }
+  return count;
+}
+
+void randomize(NavigationGrid& grid, std::mt19937& random, u32 wall_percent) {
+  for (u32 cell = 0; cell < grid.cell_count(); cell++) {
+    const u32 roll = random() % 100;
+    grid.set_cost(cell, roll < wall_percent ? NavigationGrid::WALL : static_cast<u8>(1 + random() % 4));
+  }
+  grid.clear_changes();
+}
+
+// Walls and costs changed in a few small rects, sometimes on the target itself
+void random_changes(NavigationGrid& grid, std::mt19937& random, u32 target) {
+  const u32 rects = 1 + random() % 4;
+  for (u32 i = 0; i < rects; i++) {
+    const u32 x = random() % grid.width(), y = random() % grid.height();
+    const u8 cost = random() % 3 == 0 ? NavigationGrid::WALL : static_cast<u8>(1 + random() % 6);
+    grid.fill_rect(x, y, 1 + random() % 4, 1 + random() % 4, cost);
+  }
+  if (random() % 4 == 0)
+    grid.set_cost(target, static_cast<u8>(1 + random() % 6));
+}
+
+// Cases once found wrong
+void check_regressions() {
+  // The seeded target must wake the tiles around it
+  {
+    NavigationGrid grid = make_grid(23, 97);
+    const FlowField field(grid, grid.cell(15, 16));
+    check(mismatches(grid, field) == 0);
+  }
+
+  // Raising the cost of the target lengthens every path through its neighbors
+  {
+    NavigationGrid grid = make_grid(48, 51);
+    const u32 target = grid.cell(3, 0);
+    FlowField field(grid, target);
+    grid.set_cost(target, 2);
+    field.update(grid, grid.changes());
+    grid.clear_changes();
+    check(mismatches(grid, field) == 0);
+  }
+}
+
+void check_random_grids() {
+  std::mt19937 random(43);
+  for (u32 i = 0; i < RANDOM_GRIDS; i++) {
+    NavigationGrid grid = make_grid(1 + random() % 90, 1 + random() % 90);
+    randomize(grid, random, random() % 35);
+
+    // Tile corners and borders, or anywhere
+    const auto border = [&](u32 tiles, u32 size) {
+      const u32 start = static_cast<u32>(random() % tiles) * NavigationGrid::TILE_SIZE;
+      return std::min(size - 1, random() % 2 == 0 ? start : start + NavigationGrid::TILE_SIZE - 1);
+    };
+    const u32 target = i % 2 == 0 ? grid.cell(border(grid.tiles_x(), grid.width()), border(grid.tiles_y(), grid.height()))
+                                  : static_cast<u32>(random() % grid.cell_count());
+    grid.set_cost(target, 1);
+    grid.clear_changes();
+
+    FlowField field(grid, target);
+    check(mismatches(grid, field) == 0);
+
+    for (u32 update = 0; update < UPDATES_PER_GRID; update++) {
+      random_changes(grid, random, target);
+      field.update(grid, grid.changes());
+      grid.clear_changes();
+      check(mismatches(grid, field) == 0);
+    }
+  }
+}
+
+// The cache updates every field it holds from the same changes, and retargets the least recently used one when full
+void check_cache() {
+  std::mt19937 random(430);
+  NavigationGrid grid = make_grid(70, 40);
+  randomize(grid, random, 20);
+
+  FlowFieldCache cache;
+  const std::array<u32, 3> targets{grid.cell(0, 0), grid.cell(16, 15), grid.cell(69, 39)};
+  for (u32 target : targets)
+    (void)cache.get(grid, target);
+
+  for (u32 update = 0; update < UPDATES_PER_GRID; update++) {
+    random_changes(grid, random, targets[update % targets.size()]);
+    cache.update(grid);
+    for (u32 target : targets)
+      check(mismatches(grid, cache.get(grid, target)) == 0);
+  }
+
+  for (u32 i = 0; i < 2 * FlowFieldCache::MAX_FIELDS; i++) {
+    const u32 target = static_cast<u32>(random() % grid.cell_count());
+    check(mismatches(grid, cache.get(grid, target)) == 0);
+  }
+  check(cache.size() == FlowFieldCache::MAX_FIELDS);
+  cache.clear();
+  check(cache.size() == 0);
+}
+
+// Once the cache holds its fields, new goals and wall toggles reuse their buffers (counted with SDL_TEST_ALLOCATION_TRACKING)
+void check_steady_state() {
+  std::mt19937 random(4301);
+  NavigationGrid grid = make_grid(256, 256);
+  randomize(grid, random, 10);
+
+  FlowFieldCache cache;
+  cache.reserve(grid);
+  (void)cache.get(grid, grid.cell(128, 128)); // Warms up the workers' thread local buffers
+  for (u32 round = 0; round < 4; round++) {
+    const u32 target = static_cast<u32>(random() % grid.cell_count());
+    const u32 wall = static_cast<u32>(random() % grid.cell_count());
+    const u64 allocations = allocations_during([&] {
+      (void)cache.get(grid, target);
+      grid.set_cost(wall, grid.is_walkable(wall) ? NavigationGrid::WALL : 1);
+      cache.update(grid);
+    });
+    check(allocations == 0);
+    check(mismatches(grid, cache.get(grid, target)) == 0);
+  }
+}
+
+void benchmark() {
+  std::mt19937 random(4300);
+  NavigationGrid grid = make_grid(BENCHMARK_SIZE, BENCHMARK_SIZE);
+  randomize(grid, random, 15);
+  const u32 target = grid.cell(BENCHMARK_SIZE / 2, BENCHMARK_SIZE / 2);
+  grid.set_cost(target, 1);
+  grid.clear_changes();
+
+  FlowField field(grid, target);
+  f64 compute_time = 0.0, update_time = 0.0;
+  for (u32 round = 0; round < BENCHMARK_ROUNDS; round++) {
+    compute_time += nanoseconds_per(1, [&] { field.compute(grid); });
+
+    grid.fill_rect(random() % BENCHMARK_SIZE, random() % BENCHMARK_SIZE, 4, 4, round % 2 == 0 ? NavigationGrid::WALL : 1);
+    update_time += nanoseconds_per(1, [&] { field.update(grid, grid.changes()); });
+    grid.clear_changes();
+  }
+  check(mismatches(grid, field) == 0);
+
+  std::println("[FLOW_FIELD] {}x{}: compute {:.2f} ms, update around a 4x4 rect {:.3f} ms", BENCHMARK_SIZE, BENCHMARK_SIZE,
+               compute_time / BENCHMARK_ROUNDS / 1e6, update_time / BENCHMARK_ROUNDS / 1e6);
+}
+
+} // namespace
+
+int main() {
+  check_regressions();
+  check_random_grids();
+  check_cache();
+  check_steady_state();
+  benchmark();
+  return failures();
+}
@@ -0,0 +1,340 @@
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_surface.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/frame_capture.hpp"
+#include "test.hpp"
+
+// FrameCapture on frames drawn by SDL's software renderer into a surface (headless)
+// PNG: signature, chunk CRCs, IHDR, the zlib stream (header, stored blocks, Adler-32) and the decoded pixels, all checked
+// with decoders written here rather than the encoder's helpers. Raw: the pixels as is
+// Y4M: the header, one stream per size, FRAME markers and sizes, the planes against BT.601
+// Prints the time per captured frame of the PNG writer
+
+namespace {
+
+using Format = FrameCapture::Format;
+
+constexpr u32 WIDTH = 160; // (160 * 4 + 1) * 120 filtered bytes: 2 stored blocks, the first ending inside a row
+constexpr u32 HEIGHT = 120;
+constexpr u32 SMALL_WIDTH = 48;
+constexpr u32 SMALL_HEIGHT = 20;
+constexpr u64 FRAMES = 3;
+constexpr u32 FRAME_RATE = 30;
+constexpr u32 BENCHMARK_WIDTH = 320;
+constexpr u32 BENCHMARK_HEIGHT = 180;
+constexpr u64 BENCHMARK_FRAMES = 30;
+
+// Software renderer drawing into a surface
+struct Target {
+  SDL_Surface* surface = nullptr;
+  SDL_Renderer* renderer = nullptr;
+  SDL_Texture* texture = nullptr;
+  u32 width = 0, height = 0;
+
+  Target(u32 width, u32 height) : width(width), height(height) {
+    surface = SDL_CreateSurface(static_cast<int>(width), static_cast<int>(height), SDL_PIXELFORMAT_ARGB8888);
+    renderer = surface != nullptr ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    texture = renderer != nullptr ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, static_cast<int>(width), static_cast<int>(height)) : nullptr;
+    if (texture != nullptr)
+      SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+  }
+  Target(const Target&) = delete;
+  Target& operator=(const Target&) = delete;
+  ~Target() {
+    if (texture != nullptr)
+      SDL_DestroyTexture(texture);
+    if (renderer != nullptr)
+      SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(surface);
+  }
+
+  [[nodiscard]] bool valid() const noexcept { return texture != nullptr; }
+};
+
+// Red follows x, green y, blue the frame: a pixel out of place or a frame mixed up shows
+void pixel_of(u32 x, u32 y, u64 frame, u8& r, u8& g, u8& b) {
+  r = static_cast<u8>(x * 7);
+  g = static_cast<u8>(y * 5);
+  b = static_cast<u8>(frame * 50);
+}
+
+// The frame as RGBA bytes, what the capture should hold
+std::vector<u8> expected_rgba(u32 width, u32 height, u64 frame) {
+  std::vector<u8> rgba(usize{width} * height * 4);
+  for (u32 y = 0; y < height; y++) {
+    for (u32 x = 0; x < width; x++) {
+      u8* pixel = &rgba[(usize{y} * width + x) * 4];
+      pixel_of(x, y, frame, pixel[0], pixel[1], pixel[2]);
+      pixel[3] = 255;
+    }
+  }
+  return rgba;
+}
+
+void draw(Target& target, u64 frame) {
+  std::vector<u32> argb(usize{target.width} * target.height);
+  for (u32 y = 0; y < target.height; y++) {
+    for (u32 x = 0; x < target.width; x++) {
+      u8 r, g, b;
+      pixel_of(x, y, frame, r, g, b);
+      argb[usize{y} * target.width + x] = 0xFF000000u | (u32{r} << 16) | (u32{g} << 8) | b;
+    }
+  }
+  SDL_UpdateTexture(target.texture, nullptr, argb.data(), static_cast<int>(target.width * 4));
+  SDL_RenderTexture(target.renderer, target.texture, nullptr, nullptr);
+}
+
+std::vector<u8> read_file(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::filesystem::path fresh_directory(const char* name) {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(directory);
+  return directory;
+}
+
+// Keeps a slot free for the next capture, so no frame is dropped. One frame of margin: the writer counts a frame before
+// freeing the slot of the next one
+void wait_for_writer(const FrameCapture& capture, u64 captured) {
+  while (capture.written_frames() + capture.failed_frames() + FrameCapture::RING_SIZE <= captured + 1)
+    std::this_thread::yield();
+}
+
+// Captures frames_per_target frames of each target in turn (numbered from 1), then destroying the capture waits for the
+// writer. Returns whether every frame was kept
+bool capture_frames(const std::filesystem::path& directory, Format format, std::vector<Target*> targets, u64 frames_per_target) {
+  auto capture = FrameCapture::create(FrameCapture::Settings{
+      .format = format,
+      .directory = directory.string() + "/",
+      .width = targets.front()->width,
+      .height = targets.front()->height,
+      .frame_rate = FRAME_RATE,
+  });
+  if (!check(capture.has_value()))
+    return false;
+
+  u64 frame = 0;
+  for (Target* target : targets) {
+    for (u64 i = 0; i < frames_per_target; i++) {
+      draw(*target, ++frame);
+      (*capture)->capture(target->renderer);
+      wait_for_writer(**capture, frame);
+    }
+  }
+  const bool kept = (*capture)->dropped_frames() == 0;
+  capture->reset();
+  return kept;
+}
+
+/* Decoders */
+u32 big_endian(const u8* bytes) {
+  return (u32{bytes[0]} << 24) | (u32{bytes[1]} << 16) | (u32{bytes[2]} << 8) | bytes[3];
+}
+
+// Bit by bit, no table
+u32 crc32(const u8* data, usize size) {
+  u32 crc = 0xFFFFFFFFu;
+  for (usize i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (u32 bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+u32 adler32(const std::vector<u8>& data) {
+  u64 a = 1, b = 0;
+  for (const u8 byte : data) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  return static_cast<u32>((b << 16) | a);
+}
+
+struct Image {
+  u32 width = 0, height = 0;
+  std::vector<u8> rgba;
+};
+
+// RGBA8 non interlaced PNG made of stored deflate blocks, every structural check on the way
+std::optional<Image> decode_png(const std::vector<u8>& file) {
+  constexpr u8 SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (!check(file.size() > sizeof(SIGNATURE) && std::equal(std::begin(SIGNATURE), std::end(SIGNATURE), file.begin())))
+    return std::nullopt;
+
+  Image image;
+  std::vector<u8> zlib;
+  bool ended = false;
+  for (usize offset = sizeof(SIGNATURE); offset < file.size();) {
+    if (!check(!ended && offset + 12 <= file.size()))
+      return std::nullopt;
+    const u32 length = big_endian(&file[offset]);
+    const std::string type(reinterpret_cast<const char*>(&file[offset + 4]), 4);
+    if (!check(offset + 12 + length <= file.size()))
+      return std::nullopt;
+    const u8* data = &file[offset + 8];
+    if (!check(crc32(&file[offset + 4], length + 4) == big_endian(data + length)))
+      return std::nullopt;
+
+    if (type == "IHDR") {
+      if (!check(length == 13 && data[8] == 8 && data[9] == 6 && data[10] == 0 && data[11] == 0 && data[12] == 0))
+        return std::nullopt;
+      image.width = big_endian(data);
+      image.height = big_endian(data + 4);
+    } else if (type == "IDAT") {
+      zlib.insert(zlib.end(), data, data + length);
+    } else if (type == "IEND") {
+      ended = check(length == 0);
+    }
+    offset += 12 + length;
+  }
+  if (!check(ended && image.width > 0 && image.height > 0 && zlib.size() >= 6))
+    return std::nullopt;
+
+  // zlib: deflate, no preset dictionary, header checksum
+  if (!check((zlib[0] & 0x0F) == 8 && (zlib[1] & 0x20) == 0 && (zlib[0] * 256 + zlib[1]) % 31 == 0))
+    return std::nullopt;
+
+  std::vector<u8> filtered;
+  usize offset = 2;
+  for (bool last = false; !last;) {
+    if (!check(offset + 5 <= zlib.size() && ((zlib[offset] >> 1) & 3) == 0)) // Stored
+      return std::nullopt;
+    last = zlib[offset] & 1;
+    const u32 length = zlib[offset + 1] | (u32{zlib[offset + 2]} << 8);
+    const u32 complement = zlib[offset + 3] | (u32{zlib[offset + 4]} << 8);
+    if (!check((length ^ 0xFFFFu) == complement && offset + 5 + length <= zlib.size()))
+      return std::nullopt;
+    filtered.insert(filtered.end(), zlib.begin() + static_cast<std::ptrdiff_t>(offset + 5), zlib.begin() + static_cast<std::ptrdiff_t>(offset + 5 + length));
+    offset += 5 + length;
+  }
+  if (!check(offset + 4 == zlib.size() && adler32(filtered) == big_endian(&zlib[offset])))
+    return std::nullopt;
+
+  // Rows behind a filter byte, all 0 (none)
+  const usize row_size = usize{image.width} * 4;
+  if (!check(filtered.size() == (row_size + 1) * image.height))
+    return std::nullopt;
+  for (usize row = 0; row < image.height; row++) {
+    const auto start = filtered.begin() + static_cast<std::ptrdiff_t>(row * (row_size + 1));
+    if (!check(*start == 0))
+      return std::nullopt;
+    image.rgba.insert(image.rgba.end(), start + 1, start + 1 + static_cast<std::ptrdiff_t>(row_size));
+  }
+  return image;
+}
+
+void check_png(Target& target) {
+  const std::filesystem::path directory = fresh_directory("sdl_test_frame_capture_png");
+  check(capture_frames(directory, Format::Png, {&target}, FRAMES));
+
+  for (u64 frame = 1; frame <= FRAMES; frame++) {
+    const std::optional<Image> image = decode_png(read_file(directory / std::format("frame_{:06}.png", frame)));
+    check(image && image->width == WIDTH && image->height == HEIGHT && image->rgba == expected_rgba(WIDTH, HEIGHT, frame));
+  }
+  check(!std::filesystem::exists(directory / std::format("frame_{:06}.png", FRAMES + 1)));
+  std::filesystem::remove_all(directory);
+}
+
+void check_raw(Target& target) {
+  const std::filesystem::path directory = fresh_directory("sdl_test_frame_capture_raw");
+  check(capture_frames(directory, Format::Raw, {&target}, FRAMES));
+
+  for (u64 frame = 1; frame <= FRAMES; frame++)
+    check(read_file(directory / std::format("frame_{:06}_{}x{}.rgba", frame, WIDTH, HEIGHT)) == expected_rgba(WIDTH, HEIGHT, frame));
+  std::filesystem::remove_all(directory);
+}
+
+// BT.601 limited range, in floating point: the writer's integer version is within 2
+bool matches_yuv(const u8* planes, usize pixel_count, usize i, const u8* rgba) {
+  const f64 r = rgba[0], g = rgba[1], b = rgba[2];
+  const f64 y = 16.0 + (65.738 * r + 129.057 * g + 25.064 * b) / 256.0;
+  const f64 u = 128.0 + (-37.945 * r - 74.494 * g + 112.439 * b) / 256.0;
+  const f64 v = 128.0 + (112.439 * r - 94.154 * g - 18.285 * b) / 256.0;
+  return std::abs(planes[i] - y) <= 2.0 && std::abs(planes[pixel_count + i] - u) <= 2.0 && std::abs(planes[2 * pixel_count + i] - v) <= 2.0;
+}
+
+// One stream per size: frames [first_frame, first_frame + FRAMES) at width x height
+void check_y4m_stream(const std::filesystem::path& path, u32 width, u32 height, u64 first_frame) {
+  const std::vector<u8> file = read_file(path);
+  const std::string header = std::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", width, height, FRAME_RATE);
+  const usize pixel_count = usize{width} * height;
+  const usize frame_size = 6 + pixel_count * 3;
+  if (!check(file.size() == header.size() + FRAMES * frame_size && std::equal(header.begin(), header.end(), file.begin())))
+    return;
+
+  bool frames_match = true;
+  for (u64 i = 0; i < FRAMES; i++) {
+    const u8* frame = &file[header.size() + i * frame_size];
+    frames_match &= std::string(reinterpret_cast<const char*>(frame), 6) == "FRAME\n";
+
+    const std::vector<u8> rgba = expected_rgba(width, height, first_frame + i);
+    for (usize pixel = 0; pixel < pixel_count; pixel++)
+      frames_match &= matches_yuv(frame + 6, pixel_count, pixel, &rgba[pixel * 4]);
+  }
+  check(frames_match);
+}
+
+// A resize starts a new stream
+void check_y4m(Target& target, Target& small_target) {
+  const std::filesystem::path directory = fresh_directory("sdl_test_frame_capture_y4m");
+  check(capture_frames(directory, Format::Y4m, {&target, &small_target}, FRAMES));
+
+  check_y4m_stream(directory / std::format("capture_{}x{}.y4m", WIDTH, HEIGHT), WIDTH, HEIGHT, 1);
+  check_y4m_stream(directory / std::format("capture_{}x{}.y4m", SMALL_WIDTH, SMALL_HEIGHT), SMALL_WIDTH, SMALL_HEIGHT, FRAMES + 1);
+  std::filesystem::remove_all(directory);
+}
+
+void benchmark() {
+  Target target(BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+  if (!check(target.valid()))
+    return;
+  draw(target, 1);
+
+  const std::filesystem::path directory = fresh_directory("sdl_test_frame_capture_benchmark");
+  u64 written = 0;
+  const f64 time = nanoseconds_per(BENCHMARK_FRAMES, [&] {
+    auto capture = FrameCapture::create(FrameCapture::Settings{.format = Format::Png, .directory = directory.string() + "/", .width = BENCHMARK_WIDTH, .height = BENCHMARK_HEIGHT});
+    if (!check(capture.has_value()))
+      return;
+    for (u64 frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+      (*capture)->capture(target.renderer);
+      wait_for_writer(**capture, frame + 1);
+    }
+    capture->reset(); // Waits for the writer
+  });
+  for (const auto& entry : std::filesystem::directory_iterator(directory))
+    written += entry.is_regular_file();
+  check(written == BENCHMARK_FRAMES);
+  std::filesystem::remove_all(directory);
+
+  std::println("[CAPTURE] {}x{} PNG: {:.2f} ms per frame, read back to written", BENCHMARK_WIDTH, BENCHMARK_HEIGHT, time / 1e6);
+}
+
+} // namespace
+
+int main() {
+  Target target(WIDTH, HEIGHT), small_target(SMALL_WIDTH, SMALL_HEIGHT);
+  if (!check(target.valid() && small_target.valid()))
+    return failures();
+
+  check_png(target);
+  check_raw(target);
+  check_y4m(target, small_target);
+  benchmark();
+  return failures();
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <memory>
+#include <print>
+#include <unders_helpers/object_pool.hpp>
+#include <utility>
+#include <vector>
+
+#include "test.hpp"
+
+// object_pool handles: stale handles are refused, freed slots are reused last freed first, a slot is retired once its
+// generation runs out (u32 handles) and kept going with u64 handles, erasing inside for_each and moving pools
+// Prints create/erase churn against std::make_unique
+// Built with SDL_TEST_ALLOCATION_TRACKING, churn on a reserved pool is also checked not to allocate
+
+namespace {
+
+constexpr usize CHURN_COUNT = 1'000'000;
+constexpr usize LIVE_COUNT = 256;
+
+// Counts live instances, erased and pooled elements must be destroyed exactly once
+struct Tracked {
+  static inline i64 live = 0;
+  u32 value = 0;
+
+  explicit Tracked(u32 value) noexcept : value(value) { live++; }
+  Tracked(const Tracked&) = delete;
+  Tracked& operator=(const Tracked&) = delete;
+  ~Tracked() { live--; }
+};
+
+void check_stale_handles() {
+  uh::object_pool<Tracked> pool;
+  check(!pool.contains({}) && pool.get({}) == nullptr); // Null handle
+
+  const auto first = pool.emplace(1u);
+  const auto second = pool.emplace(2u);
+  check(pool.size() == 2 && pool.get(first)->value == 1 && pool.get(second)->value == 2);
+
+  check(pool.erase(first));
+  check(!pool.erase(first) && !pool.contains(first) && pool.get(first) == nullptr);
+  check(pool.get(second) != nullptr && pool.size() == 1);
+
+  // Same slot, new generation: the old handle stays stale
+  const auto reused = pool.emplace(3u);
+  check(reused.index() == first.index() && reused.generation() != first.generation());
+  check(pool.get(first) == nullptr && pool.get(reused)->value == 3);
+
+  // Out of range index
+  check(!pool.contains(uh::handle<Tracked>(1000, 1)));
+
+  pool.clear();
+  check(pool.empty() && Tracked::live == 0);
+  check(pool.get(second) == nullptr);
+}
+
+void check_reuse_and_retirement() {
+  // Last freed, first reused
+  {
+    uh::object_pool<u32> pool;
+    std::vector<uh::handle<u32>> handles;
+    for (u32 i = 0; i < 8; i++)
+      handles.push_back(pool.emplace(i));
+    pool.erase(handles[2]);
+    pool.erase(handles[5]);
+    check(pool.emplace(0u).index() == handles[5].index());
+    check(pool.emplace(0u).index() == handles[2].index());
+    check(pool.emplace(0u).index() == 8);
+  }
+
+  // u32: 12 generation bits, a slot is handed out 2048 times then retired
+  {
+    using Handle = uh::handle<u32>;
+    uh::object_pool<u32> pool;
+    Handle last;
+    bool same_slot = true;
+    for (u32 i = 0; i < (Handle::MAX_GENERATION + 1) / 2; i++) {
+      last = pool.emplace(i);
+      same_slot &= last.index() == 0;
+      pool.erase(last);
+    }
+    check(same_slot);
+    check(last.generation() == Handle::MAX_GENERATION && !pool.contains(last));
+    check(pool.emplace(0u).index() == 1);
+  }
+
+  // u64: the same churn never leaves the first slot nor the first block
+  {
+    uh::object_pool<u32, u64> pool;
+    bool same_slot = true;
+    for (u32 i = 0; i < 100'000; i++) {
+      const auto handle = pool.emplace(i);
+      same_slot &= handle.index() == 0;
+      pool.erase(handle);
+    }
+    check(same_slot && pool.capacity() == uh::object_pool<u32, u64>::block_size);
+  }
+}
+
+void check_iteration() {
+  uh::object_pool<Tracked, u32, 16> pool; // Small blocks, iteration crosses them
+  for (u32 i = 0; i < 100; i++)
+    pool.emplace(i);
+
+  // Erasing the current element while iterating
+  pool.for_each([&](uh::handle<Tracked> handle, Tracked& element) {
+    if (element.value % 2 == 0)
+      pool.erase(handle);
+  });
+  check(pool.size() == 50 && Tracked::live == 50);
+
+  std::vector<u32> values;
+  std::as_const(pool).for_each([&](uh::handle<Tracked> handle, const Tracked& element) {
+    check(pool.get(handle) == &element);
+    values.push_back(element.value);
+  });
+  check(values.size() == 50 && std::ranges::all_of(values, [](u32 value) { return value % 2 == 1; }));
+  check(std::ranges::is_sorted(values)); // Slot order
+}
+
+void check_move() {
+  {
+    uh::object_pool<Tracked> source;
+    const auto handle = source.emplace(7u);
+    Tracked* address = source.get(handle);
+
+    uh::object_pool<Tracked> destination;
+    destination.emplace(1u);
+    destination.emplace(2u);
+    destination = std::move(source);
+
+    // The destination's elements are destroyed, the source's keep their address and handles
+    check(Tracked::live == 1);
+    check(destination.get(handle) == address && destination.size() == 1);
+    check(source.empty() && source.get(handle) == nullptr);
+
+    // The moved from pool is usable again
+    source.emplace(3u);
+    check(source.size() == 1 && Tracked::live == 2);
+
+    uh::object_pool<Tracked> constructed(std::move(destination));
+    check(constructed.get(handle) == address && destination.empty());
+  }
+  check(Tracked::live == 0);
+}
+
+// Erasing and creating at a steady count stays within the reserved blocks (u64 handles, see the pool's header)
+void check_steady_state() {
+  uh::object_pool<u32, u64> pool;
+  pool.reserve(LIVE_COUNT);
+  std::vector<uh::handle<u32, u64>> handles;
+  handles.reserve(LIVE_COUNT);
+  for (u32 i = 0; i < LIVE_COUNT; i++)
+    handles.push_back(pool.emplace(i));
+
+  const usize capacity = pool.capacity();
+  const u64 allocations = allocations_during([&] {
+    for (usize i = 0; i < 100 * CHURN_COUNT / LIVE_COUNT; i++) {
+      auto& handle = handles[i % LIVE_COUNT];
+      pool.erase(handle);
+      handle = pool.emplace(static_cast<u32>(i));
+    }
+  });
+  check(allocations == 0 && pool.capacity() == capacity);
+}
+
+void benchmark() {
+  uh::object_pool<u64, u64> pool;
+  std::vector<uh::handle<u64, u64>> handles(LIVE_COUNT);
+  std::vector<std::unique_ptr<u64>> pointers(LIVE_COUNT);
+  for (usize i = 0; i < LIVE_COUNT; i++) {
+    handles[i] = pool.emplace(i);
+    pointers[i] = std::make_unique<u64>(i);
+  }
+
+  const f64 pool_time = nanoseconds_per(CHURN_COUNT, [&] {
+    for (usize i = 0; i < CHURN_COUNT; i++) {
+      auto& handle = handles[(i * 7) % LIVE_COUNT];
+      pool.erase(handle);
+      handle = pool.emplace(i);
+    }
+  });
+  const f64 unique_time = nanoseconds_per(CHURN_COUNT, [&] {
+    for (usize i = 0; i < CHURN_COUNT; i++)
+      pointers[(i * 7) % LIVE_COUNT] = std::make_unique<u64>(i);
+  });
+  check(pool.size() == LIVE_COUNT);
+
+  std::println("[OBJECT_POOL] erase + emplace: {:.1f} ns (std::make_unique {:.1f} ns)", pool_time, unique_time);
+}
+
+} // namespace
+
+int main() {
+  check_stale_handles();
+  check_reuse_and_retirement();
+  check_iteration();
+  check_move();
+  check_steady_state();
+  benchmark();
+  return failures();
+}
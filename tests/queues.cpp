@@ -0,0 +1,204 @@
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <span>
+#include <thread>
+#include <unders_helpers/mpmc_queue.hpp>
+#include <unders_helpers/spsc_queue.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+// Stress tests of the lock-free queues: every value pushed is popped exactly once, in order for the SPSC ring, with
+// single and batch operations mixed on both sides
+// Prints the throughput of both queues next to a mutex protected std::deque doing the same work
+
+namespace {
+
+constexpr usize ITEM_COUNT = 2'000'000; // Per producer
+constexpr usize THREAD_COUNT = 4;       // MPMC producers, and as many consumers
+constexpr usize CAPACITY = 1024;
+constexpr usize BATCH_SIZE = 16;
+
+// Counts live instances, leftovers must be destroyed with the queue
+struct Tracked {
+  static inline std::atomic<i64> live{0};
+  u64 value = 0;
+
+  Tracked() noexcept { live++; }
+  explicit Tracked(u64 value) noexcept : value(value) { live++; }
+  Tracked(const Tracked& other) noexcept : value(other.value) { live++; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+  Tracked& operator=(const Tracked&) noexcept = default;
+  Tracked& operator=(Tracked&&) noexcept = default;
+  ~Tracked() { live--; }
+};
+
+// Single push and pop alternate with batches of BATCH_SIZE, on both sides
+template <typename TQueue>
+void produce(TQueue& queue, u64 first, u64 count) {
+  std::array<u64, BATCH_SIZE> batch{};
+  for (u64 next = first, end = first + count; next < end;) {
+    if ((next / BATCH_SIZE) % 2 == 0) {
+      if (!queue.try_push(next)) {
+        std::this_thread::yield();
+        continue;
+      }
+      next++;
+    } else {
+      const usize size = static_cast<usize>(std::min<u64>(BATCH_SIZE, end - next));
+      for (usize i = 0; i < size; i++)
+        batch[i] = next + i;
+      const usize pushed = queue.try_push_n(std::span<const u64>(batch.data(), size));
+      if (pushed == 0)
+        std::this_thread::yield();
+      next += pushed;
+    }
+  }
+}
+
+// Calls consume() on each popped value until count values were popped
+template <typename TQueue, typename TConsume>
+void consume(TQueue& queue, u64 count, TConsume&& consume) {
+  std::array<u64, BATCH_SIZE> batch{};
+  for (u64 popped = 0; popped < count;) {
+    usize size = 0;
+    if (popped % 3 == 0) {
+      size = queue.try_pop(batch[0]) ? 1 : 0;
+    } else {
+      size = queue.try_pop_n(std::span<u64>(batch.data(), static_cast<usize>(std::min<u64>(BATCH_SIZE, count - popped))));
+    }
+
+    if (size == 0)
+      std::this_thread::yield();
+    for (usize i = 0; i < size; i++)
+      consume(batch[i]);
+    popped += size;
+  }
+}
+
+// SPSC: values come out in push order
+f64 stress_spsc() {
+  auto queue = std::make_unique<uh::spsc_queue<u64, CAPACITY>>();
+  u64 expected = 0;
+  bool ordered = true;
+
+  const f64 time = nanoseconds_per(ITEM_COUNT, [&] {
+    std::jthread producer([&] { produce(*queue, 0, ITEM_COUNT); });
+    consume(*queue, ITEM_COUNT, [&](u64 value) { ordered &= value == expected++; });
+  });
+
+  check(ordered);
+  check(expected == ITEM_COUNT);
+  check(queue->empty_approx());
+  return time;
+}
+
+// MPMC: each producer pushes its own range, every value is seen exactly once across consumers
+f64 stress_mpmc() {
+  auto queue = std::make_unique<uh::mpmc_queue<u64, CAPACITY>>();
+  auto seen = std::make_unique<std::atomic<u8>[]>(ITEM_COUNT * THREAD_COUNT);
+  std::atomic<u64> duplicates{0};
+
+  const f64 time = nanoseconds_per(ITEM_COUNT * THREAD_COUNT, [&] {
+    std::vector<std::jthread> threads;
+    for (usize i = 0; i < THREAD_COUNT; i++)
+      threads.emplace_back([&, i] { produce(*queue, i * ITEM_COUNT, ITEM_COUNT); });
+    for (usize i = 0; i < THREAD_COUNT; i++) {
+      threads.emplace_back([&] {
+        consume(*queue, ITEM_COUNT, [&](u64 value) {
+          if (seen[value].fetch_add(1, std::memory_order_relaxed) != 0)
+            duplicates.fetch_add(1, std::memory_order_relaxed);
+        });
+      });
+    }
+  });
+
+  check(duplicates.load() == 0);
+  bool all_seen = true;
+  for (usize i = 0; i < ITEM_COUNT * THREAD_COUNT; i++)
+    all_seen &= seen[i].load(std::memory_order_relaxed) == 1;
+  check(all_seen);
+  check(queue->empty_approx());
+  return time;
+}
+
+// Baseline, same threads and items through a locked deque
+f64 stress_mutex_deque() {
+  std::mutex mutex;
+  std::deque<u64> queue;
+  std::atomic<u64> sum{0};
+
+  const f64 time = nanoseconds_per(ITEM_COUNT * THREAD_COUNT, [&] {
+    std::vector<std::jthread> threads;
+    for (usize i = 0; i < THREAD_COUNT; i++) {
+      threads.emplace_back([&, i] {
+        for (u64 value = i * ITEM_COUNT; value < (i + 1) * ITEM_COUNT; value++) {
+          std::scoped_lock lock(mutex);
+          queue.push_back(value);
+        }
+      });
+    }
+    for (usize i = 0; i < THREAD_COUNT; i++) {
+      threads.emplace_back([&] {
+        for (u64 popped = 0; popped < ITEM_COUNT;) {
+          std::unique_lock lock(mutex);
+          if (queue.empty()) {
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+          }
+          sum.fetch_add(queue.front(), std::memory_order_relaxed);
+          queue.pop_front();
+          popped++;
+        }
+      });
+    }
+  });
+
+  const u64 total = ITEM_COUNT * THREAD_COUNT;
+  check(sum.load() == total * (total - 1) / 2);
+  return time;
+}
+
+// Full and empty edges, and elements left in a queue are destroyed with it
+void check_edges() {
+  {
+    uh::spsc_queue<Tracked, 4> spsc;
+    std::array<Tracked, 6> values{};
+    check(spsc.try_push_n(std::span<const Tracked>(values)) == 4);
+    check(!spsc.try_push(Tracked(7)));
+    check(spsc.front() != nullptr && spsc.front()->value == 0);
+    spsc.pop();
+    check(spsc.try_emplace(9u));
+    check(spsc.size_approx() == 4);
+
+    uh::mpmc_queue<Tracked, 4> mpmc;
+    check(mpmc.try_push_n(std::span<const Tracked>(values)) == 4);
+    check(!mpmc.try_emplace(7u));
+    Tracked popped;
+    check(mpmc.try_pop(popped));
+    std::array<Tracked, 8> out{};
+    check(mpmc.try_pop_n(std::span<Tracked>(out)) == 3);
+    check(!mpmc.try_pop(popped));
+    check(mpmc.try_emplace(11u));
+  }
+  check(Tracked::live.load() == 0);
+}
+
+} // namespace
+
+int main() {
+  check_edges();
+
+  const f64 spsc_time = stress_spsc();
+  const f64 mpmc_time = stress_mpmc();
+  const f64 mutex_time = stress_mutex_deque();
+
+  std::println("[QUEUES] spsc (1 -> 1): {:.1f} ns/item, mpmc ({} -> {}): {:.1f} ns/item, mutex deque ({} -> {}): {:.1f} ns/item", spsc_time,
+               THREAD_COUNT, THREAD_COUNT, mpmc_time, THREAD_COUNT, THREAD_COUNT, mutex_time);
+  return failures();
+}
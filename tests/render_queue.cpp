@@ -0,0 +1,266 @@
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_surface.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <print>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/render_queue.hpp"
+#include "test.hpp"
+
+// RenderQueue sort against std::stable_sort on random keys: fully random, built from layers/blend modes/textures/depths,
+// differing in a single byte (every other pass skipped), all equal, few distinct values (stability), every size up to a few
+// Then batching on SDL's software renderer: merged FillRect/Rect runs draw the same pixels as every command drawn on its
+// own with its own state, and the draw call and state change counts of a known sequence
+// Prints the sort time per command against std::stable_sort
+
+namespace {
+
+using BlendMode = RenderQueue::BlendMode;
+using Command = RenderQueue::Command;
+using SortKey = RenderQueue::SortKey;
+using Type = RenderQueue::Type;
+
+constexpr usize LARGE_COUNT = 5'000;
+constexpr u32 WIDTH = 96;
+constexpr u32 HEIGHT = 64;
+constexpr usize SCENE_COMMANDS = 400;
+constexpr usize BENCHMARK_COUNT = 10'000;
+constexpr usize BENCHMARK_ROUNDS = 200;
+
+// The submission index rides in the destination, so the sorted order can be compared, not only the keys
+Command marker(u32 index) {
+  return Command{Type::FillRect, BlendMode::None, {255, 255, 255, 255}, nullptr, {}, {static_cast<f32>(index), 0.0f, 0.0f, 0.0f}};
+}
+
+bool sorts_like_stable_sort(const std::vector<u64>& keys) {
+  RenderQueue queue;
+  std::vector<std::pair<u64, u32>> expected;
+  for (u32 i = 0; i < keys.size(); i++) {
+    queue.submit(keys[i], marker(i));
+    expected.emplace_back(keys[i], i);
+  }
+  std::ranges::stable_sort(expected, {}, &std::pair<u64, u32>::first);
+
+  std::vector<std::pair<u64, u32>> sorted;
+  queue.visit_sorted([&](u64 key, const Command& command) { sorted.emplace_back(key, static_cast<u32>(command.destination.x)); });
+  return sorted == expected;
+}
+
+void check_sort() {
+  std::mt19937_64 random_engine{42};
+  std::uniform_int_distribution<u64> any;
+  std::uniform_int_distribution<u32> layer(0, 3), blend(0, 4), texture(0, 5), depth;
+
+  const auto generate = [&](usize count, auto&& make_key) {
+    std::vector<u64> keys(count);
+    for (u64& key : keys)
+      key = make_key();
+    return keys;
+  };
+
+  for (const usize count : {usize{0}, usize{1}, usize{2}, usize{3}, usize{17}, usize{256}, LARGE_COUNT}) {
+    // Fully random
+    check(sorts_like_stable_sort(generate(count, [&] { return any(random_engine); })));
+    // As the helpers build them, the texture's high bits and the unused blend bits stay constant
+    check(sorts_like_stable_sort(generate(count, [&] {
+      return SortKey::make(static_cast<u8>(layer(random_engine)), static_cast<BlendMode>(blend(random_engine)), texture(random_engine), depth(random_engine));
+    })));
+    // One byte differs, the 7 other passes are skipped: every byte position in turn
+    for (u32 byte = 0; byte < 8; byte++)
+      check(sorts_like_stable_sort(generate(count, [&] { return 0x0123456789ABCDEFull ^ ((any(random_engine) & 0xFF) << (byte * 8)); })));
+    // All equal: nothing moves
+    check(sorts_like_stable_sort(std::vector<u64>(count, SortKey::make(1, BlendMode::Blend, 2, 3))));
+    // Few distinct keys spread over several bytes, equal keys must keep their submission order
+    check(sorts_like_stable_sort(generate(count, [&] { return (any(random_engine) % 4) * 0x0101010101010101ull; })));
+  }
+
+  // The queue is reused: a second frame sorts its own commands only
+  RenderQueue queue;
+  for (u32 i = 0; i < 100; i++)
+    queue.submit(static_cast<u64>(100 - i), marker(i));
+  queue.clear();
+  queue.submit(2, marker(0));
+  queue.submit(1, marker(1));
+  std::vector<u32> order;
+  queue.visit_sorted([&](u64, const Command& command) { order.push_back(static_cast<u32>(command.destination.x)); });
+  check(order == std::vector<u32>{1, 0});
+}
+
+// Software renderer drawing into a surface
+struct Target {
+  SDL_Surface* surface = nullptr;
+  SDL_Renderer* renderer = nullptr;
+
+  Target() {
+    surface = SDL_CreateSurface(static_cast<int>(WIDTH), static_cast<int>(HEIGHT), SDL_PIXELFORMAT_ARGB8888);
+    renderer = surface != nullptr ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+  }
+  Target(const Target&) = delete;
+  Target& operator=(const Target&) = delete;
+  ~Target() {
+    if (renderer != nullptr)
+      SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(surface);
+  }
+
+  void clear() {
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 20, 30, 40, 255);
+    SDL_RenderClear(renderer);
+  }
+
+  [[nodiscard]] std::vector<u32> pixels() {
+    SDL_FlushRenderer(renderer);
+    std::vector<u32> pixels(usize{WIDTH} * HEIGHT);
+    for (u32 y = 0; y < HEIGHT; y++)
+      std::memcpy(&pixels[usize{y} * WIDTH], static_cast<const u8*>(surface->pixels) + usize{y} * static_cast<usize>(surface->pitch), WIDTH * sizeof(u32));
+    return pixels;
+  }
+};
+
+SDL_BlendMode to_sdl(BlendMode blend) {
+  switch (blend) {
+    case BlendMode::None: return SDL_BLENDMODE_NONE;
+    case BlendMode::Blend: return SDL_BLENDMODE_BLEND;
+    case BlendMode::Add: return SDL_BLENDMODE_ADD;
+    case BlendMode::Mod: return SDL_BLENDMODE_MOD;
+    case BlendMode::Mul: return SDL_BLENDMODE_MUL;
+  }
+  return SDL_BLENDMODE_NONE;
+}
+
+// Every command on its own, its whole state set before it
+void draw_one_by_one(SDL_Renderer* renderer, const Command& command) {
+  SDL_SetRenderDrawBlendMode(renderer, to_sdl(command.blend));
+  SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+  const SDL_FRect& rect = command.destination;
+  switch (command.type) {
+    case Type::FillRect: SDL_RenderFillRect(renderer, &rect); break;
+    case Type::Rect: SDL_RenderRect(renderer, &rect); break;
+    case Type::Line: SDL_RenderLine(renderer, rect.x, rect.y, rect.w, rect.h); break;
+    case Type::Texture: break;
+  }
+}
+
+// Overlapping fills, outlines and lines in a few colors, blend modes and layers: long runs sharing a state get merged,
+// and a run must stop at the first command with another color, blend mode or type
+void submit_scene(RenderQueue& queue, std::mt19937& random_engine) {
+  constexpr SDL_Color COLORS[] = {{250, 60, 30, 255}, {40, 200, 90, 128}, {30, 80, 240, 200}};
+  constexpr BlendMode BLENDS[] = {BlendMode::None, BlendMode::Blend, BlendMode::Add};
+  std::uniform_int_distribution<u32> pick(0, 2), type(0, 5), depth(0, 8);
+  std::uniform_real_distribution<f32> x(-8.0f, WIDTH), y(-8.0f, HEIGHT), size(1.0f, 40.0f);
+
+  for (usize i = 0; i < SCENE_COMMANDS; i++) {
+    const SDL_FRect rect{std::floor(x(random_engine)), std::floor(y(random_engine)), std::floor(size(random_engine)), std::floor(size(random_engine))};
+    const SDL_Color color = COLORS[pick(random_engine)];
+    const BlendMode blend = BLENDS[pick(random_engine)];
+    const u8 layer = static_cast<u8>(pick(random_engine));
+    const u32 command_depth = depth(random_engine); // Few depths: runs of equal keys interleave types and colors
+    switch (type(random_engine)) {
+      case 0:
+      case 1:
+      case 2: queue.fill_rect(rect, color, layer, command_depth, blend); break;
+      case 3:
+      case 4: queue.rect(rect, color, layer, command_depth, blend); break;
+      default: queue.line(rect.x, rect.y, rect.x + rect.w, rect.y + rect.h, color, layer, command_depth, blend); break;
+    }
+  }
+}
+
+void check_batches() {
+  Target batched, reference;
+  if (!check(batched.renderer != nullptr && reference.renderer != nullptr))
+    return;
+
+  // Known sequence: 10 red fills, 5 red outlines, 1 green fill, 3 green fills blended, all in one layer
+  {
+    RenderQueue queue;
+    constexpr SDL_Color RED{255, 0, 0, 255}, GREEN{0, 255, 0, 255};
+    for (u32 i = 0; i < 10; i++)
+      queue.fill_rect({static_cast<f32>(i), 0.0f, 2.0f, 2.0f}, RED, 0, i);
+    for (u32 i = 0; i < 5; i++)
+      queue.rect({static_cast<f32>(i), 4.0f, 2.0f, 2.0f}, RED, 0, 10 + i);
+    queue.fill_rect({0.0f, 8.0f, 2.0f, 2.0f}, GREEN, 0, 15);
+    for (u32 i = 0; i < 3; i++)
+      queue.fill_rect({static_cast<f32>(i), 12.0f, 2.0f, 2.0f}, GREEN, 0, i, BlendMode::Blend);
+    queue.flush(batched.renderer);
+
+    // Blend + color, nothing, color, blend
+    const RenderQueue::Stats& stats = queue.stats();
+    check(stats.commands == 19 && stats.draw_calls == 4 && stats.state_changes == 4);
+  }
+
+  // Random scenes, batched against one by one in the same order
+  std::mt19937 random_engine{7};
+  usize commands = 0, draw_calls = 0;
+  bool same_pixels = true;
+  for (usize scene = 0; scene < 20; scene++) {
+    RenderQueue queue, copy;
+    std::mt19937 copy_engine = random_engine;
+    submit_scene(queue, random_engine);
+    submit_scene(copy, copy_engine);
+
+    batched.clear();
+    reference.clear();
+    queue.flush(batched.renderer);
+    copy.visit_sorted([&](u64, const Command& command) { draw_one_by_one(reference.renderer, command); });
+    copy.clear();
+
+    same_pixels &= batched.pixels() == reference.pixels();
+    commands += queue.stats().commands;
+    draw_calls += queue.stats().draw_calls;
+  }
+  check(same_pixels);
+  check(commands == 20 * SCENE_COMMANDS && draw_calls < commands); // Some runs were merged
+}
+
+void benchmark() {
+  std::mt19937_64 random_engine{42};
+  std::uniform_int_distribution<u32> layer(0, 3), texture(0, 15), depth;
+  std::vector<u64> keys(BENCHMARK_COUNT);
+  for (u64& key : keys)
+    key = SortKey::make(static_cast<u8>(layer(random_engine)), BlendMode::Blend, texture(random_engine), depth(random_engine));
+
+  RenderQueue queue;
+  usize visited = 0;
+  const f64 radix_time = nanoseconds_per(BENCHMARK_ROUNDS * BENCHMARK_COUNT, [&] {
+    for (usize round = 0; round < BENCHMARK_ROUNDS; round++) {
+      for (u32 i = 0; i < keys.size(); i++)
+        queue.submit(keys[i], marker(i));
+      queue.visit_sorted([&](u64, const Command&) { visited++; });
+      queue.clear();
+    }
+  });
+  check(visited == BENCHMARK_ROUNDS * BENCHMARK_COUNT);
+
+  std::vector<std::pair<u64, u32>> entries;
+  std::vector<Command> commands;
+  const f64 stable_time = nanoseconds_per(BENCHMARK_ROUNDS * BENCHMARK_COUNT, [&] {
+    for (usize round = 0; round < BENCHMARK_ROUNDS; round++) {
+      entries.clear();
+      commands.clear();
+      for (u32 i = 0; i < keys.size(); i++) {
+        entries.emplace_back(keys[i], i);
+        commands.push_back(marker(i));
+      }
+      std::ranges::stable_sort(entries, {}, &std::pair<u64, u32>::first);
+    }
+  });
+  check(entries.size() == BENCHMARK_COUNT);
+
+  std::println("[RENDER_QUEUE] submit + sort {} commands: {:.1f} ns per command (std::stable_sort {:.1f} ns)", BENCHMARK_COUNT, radix_time, stable_time);
+}
+
+} // namespace
+
+int main() {
+  check_sort();
+  check_batches();
+  benchmark();
+  return failures();
+}
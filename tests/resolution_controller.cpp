@@ -0,0 +1,150 @@
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_init.h>
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_surface.h>
+
+#include <cmath>
+#include <print>
+
+#include "core/renderer.hpp"
+#include "core/resolution_controller.hpp"
+#include "core/window.hpp"
+#include "test.hpp"
+
+// ResolutionController rules: nothing changes inside a window, over budget the scale drops by the square root of the
+// ratio (at least one step, at most MAX_DROP), under RAISE_THRESHOLD it climbs one step per window, always on a step and
+// between min_scale and max_scale
+// Then Renderer's upscale at half resolution on the software renderer: the whole drawn part is shown, unstretched, and
+// the edges don't blend with what lies past the drawn part of the target
+
+namespace {
+
+using Settings = ResolutionController::Settings;
+
+constexpr f64 BUDGET = 10.0; // ms
+constexpr f64 STEP = ResolutionController::STEP;
+constexpr u32 WIDTH = 64;
+constexpr u32 HEIGHT = 48;
+
+// A whole window of frames at frame_time, returns whether its last frame changed the scale (the others never do)
+bool run_window(ResolutionController& controller, f64 frame_time) {
+  for (usize i = 0; i + 1 < ResolutionController::WINDOW_SIZE; i++)
+    check(!controller.update(frame_time));
+  return controller.update(frame_time);
+}
+
+bool on_step(f64 scale) {
+  return std::floor(scale / STEP) == scale / STEP;
+}
+
+void check_drops() {
+  ResolutionController controller(Settings{.budget = BUDGET});
+  check(controller.scale() == 1.0);
+
+  // On budget, or under it without reaching the raise threshold
+  check(!run_window(controller, BUDGET) && controller.scale() == 1.0 && controller.average_frame_time() == BUDGET);
+  check(!run_window(controller, BUDGET * 0.8) && controller.scale() == 1.0);
+
+  // Barely over: one step
+  check(run_window(controller, BUDGET * 1.01) && controller.scale() == 31.0 * STEP);
+  // 30% over: sqrt(1 / 1.3) = 0.877, 31/32 * 0.877 = 0.850 rounded down
+  check(run_window(controller, BUDGET * 1.3) && controller.scale() == 27.0 * STEP);
+  // Twice the budget: sqrt(1 / 2) = 0.707, capped to 0.75, 27/32 * 0.75 = 0.633 rounded down
+  check(run_window(controller, BUDGET * 2.0) && controller.scale() == 20.0 * STEP);
+  // Far over: capped, 20/32 * 0.75 = 15/32 then clamped to min_scale
+  check(run_window(controller, BUDGET * 100.0) && controller.scale() == 0.5);
+  check(!run_window(controller, BUDGET * 100.0) && controller.scale() == 0.5);
+
+  // The average is over the whole window
+  for (usize i = 0; i < ResolutionController::WINDOW_SIZE; i++)
+    (void)controller.update(i % 2 == 0 ? BUDGET * 0.5 : BUDGET * 1.5);
+  check(controller.average_frame_time() == BUDGET && controller.scale() == 0.5);
+}
+
+void check_raises() {
+  ResolutionController controller(Settings{.budget = BUDGET, .min_scale = 0.25, .max_scale = 0.75});
+  check(controller.scale() == 0.75);
+  while (run_window(controller, BUDGET * 4.0)) {
+  }
+  check(controller.scale() == 0.25);
+
+  // Exactly at the threshold: kept
+  check(!run_window(controller, BUDGET * ResolutionController::RAISE_THRESHOLD) && controller.scale() == 0.25);
+
+  // Under it: one step per window up to max_scale
+  usize raises = 0;
+  bool stepped = true;
+  while (run_window(controller, BUDGET * 0.5)) {
+    raises++;
+    stepped &= on_step(controller.scale());
+  }
+  check(stepped && raises == static_cast<usize>((0.75 - 0.25) / STEP) && controller.scale() == 0.75);
+
+  // A single slow frame in a window under budget doesn't drop anything
+  for (usize i = 0; i + 1 < ResolutionController::WINDOW_SIZE; i++)
+    check(!controller.update(BUDGET * 0.5));
+  check(!controller.update(BUDGET * 2.0) && controller.scale() == 0.75);
+}
+
+// Left half red, right half blue, drawn at half resolution on a black target then upscaled
+void check_upscale() {
+  if (!check(SDL_Init(SDL_INIT_VIDEO))) {
+    std::println(stderr, "SDL_Init failed: {}", SDL_GetError());
+    return;
+  }
+
+  {
+    auto window = Window::create("resolution_controller test", WIDTH, HEIGHT, Window::Flags::Hidden);
+    if (!check(window.has_value()))
+      return;
+    auto renderer = Renderer::create(*window, Renderer::Driver::Software);
+    if (!check(renderer.has_value()))
+      return;
+    if (!check(renderer->enable_dynamic_resolution(Settings{.budget = 1000.0, .min_scale = 0.5, .max_scale = 0.5}).has_value()))
+      return;
+
+    renderer->begin_frame();
+    renderer->clear(0, 0, 0);
+    renderer->queue().fill_rect({0.0f, 0.0f, WIDTH / 2.0f, HEIGHT}, {255, 0, 0, 255});
+    renderer->queue().fill_rect({WIDTH / 2.0f, 0.0f, WIDTH / 2.0f, HEIGHT}, {0, 0, 255, 255});
+    renderer->resolve();
+
+    SDL_Surface* read = SDL_RenderReadPixels(renderer->get_raw(), nullptr);
+    SDL_Surface* frame = read != nullptr ? SDL_ConvertSurface(read, SDL_PIXELFORMAT_ARGB8888) : nullptr;
+    SDL_DestroySurface(read);
+    if (!check(frame != nullptr && frame->w == static_cast<int>(WIDTH) && frame->h == static_cast<int>(HEIGHT))) {
+      SDL_DestroySurface(frame);
+      return;
+    }
+
+    const auto pixel = [&](u32 x, u32 y) { return static_cast<const u32*>(frame->pixels)[y * (static_cast<u32>(frame->pitch) / 4) + x]; };
+    const auto red = [&](u32 x, u32 y) { return (pixel(x, y) >> 16) & 0xFF; };
+    const auto blue = [&](u32 x, u32 y) { return pixel(x, y) & 0xFF; };
+
+    // Nothing darkened by the black past the drawn part, the outer columns and the bottom row keep their colour
+    bool lit = true, edges = true;
+    for (u32 y = 0; y < HEIGHT; y++) {
+      for (u32 x = 0; x < WIDTH; x++)
+        lit &= red(x, y) + blue(x, y) >= 250;
+      edges &= red(0, y) >= 250 && blue(WIDTH - 1, y) >= 250;
+    }
+    for (u32 x = 0; x < WIDTH; x++)
+      edges &= x < WIDTH / 2 - 1 ? red(x, HEIGHT - 1) >= 250 : x > WIDTH / 2 ? blue(x, HEIGHT - 1) >= 250 : true;
+    check(lit && edges);
+
+    // The colours meet in the middle, not stretched to the right
+    check(red(WIDTH / 2 - 1, HEIGHT / 2) > blue(WIDTH / 2 - 1, HEIGHT / 2) && blue(WIDTH / 2, HEIGHT / 2) > red(WIDTH / 2, HEIGHT / 2));
+    SDL_DestroySurface(frame);
+  }
+
+  SDL_Quit();
+}
+
+} // namespace
+
+int main() {
+  check_drops();
+  check_raises();
+  check_upscale();
+  return failures();
+}
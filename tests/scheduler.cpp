@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <print>
+#include <vector>
+
+#include "core/scheduler.hpp"
+#include "test.hpp"
+
+// Scheduler frames: the budget cuts a frame short and the rest carries over ahead of newly ready tasks, timers,
+// pollables and awaited tasks resume when due, and finished task frames are reused by the pool
+// Prints the cost of spawning and running a short task
+
+namespace {
+
+constexpr f64 FRAME_TIME = 16.0; // In ms
+constexpr usize TASK_COUNT = 1000;
+constexpr usize BENCHMARK_COUNT = 100'000;
+
+// Gives the frame address of the awaiting task without suspending it
+struct FrameAddress {
+  void** address;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) const noexcept {
+    *address = handle.address();
+    return false;
+  }
+  void await_resume() const noexcept {}
+};
+
+struct Flag {
+  bool value = false;
+
+  [[nodiscard]] bool is_ready() const noexcept { return value; }
+};
+
+void spin(std::chrono::microseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+Task record(std::vector<u32>& order, u32 id, u32 frames) {
+  for (u32 i = 0; i < frames; i++) {
+    order.push_back(id);
+    co_await Scheduler::next_frame();
+  }
+}
+
+Task busy(usize& finished) {
+  spin(std::chrono::microseconds(1000));
+  finished++;
+  co_return;
+}
+
+Task address_of(void*& address) {
+  co_await FrameAddress{&address};
+}
+
+Task child(std::vector<u32>& order) {
+  order.push_back(1);
+  co_await Scheduler::next_frame();
+  order.push_back(2);
+}
+
+Task parent(std::vector<u32>& order) {
+  order.push_back(0);
+  co_await child(order);
+  order.push_back(3);
+}
+
+// A zero budget resumes exactly one task per frame, carried over tasks go before the ones ready since
+void check_carry_over() {
+  Scheduler scheduler;
+  scheduler.set_budget(0.0);
+  std::vector<u32> order;
+  for (u32 id = 0; id < 3; id++)
+    scheduler.spawn(record(order, id, 2));
+
+  scheduler.run(FRAME_TIME);
+  check(order == std::vector<u32>{0});
+  check(scheduler.carried_over() == 2);
+
+  // Task 0 is ready again but waits behind 1 and 2
+  for (u32 frame = 0; frame < 5; frame++)
+    scheduler.run(FRAME_TIME);
+  check(order == std::vector<u32>{0, 1, 2, 0, 1, 2});
+  check(scheduler.task_count() == 3 && scheduler.carried_over() == 2);
+
+  for (u32 frame = 0; frame < 3; frame++)
+    scheduler.run(FRAME_TIME);
+  check(scheduler.task_count() == 0);
+
+  // A large budget runs everything ready in one frame
+  order.clear();
+  scheduler.set_budget(1000.0);
+  for (u32 id = 0; id < 3; id++)
+    scheduler.spawn(record(order, id, 1));
+  scheduler.run(FRAME_TIME);
+  check(order == std::vector<u32>{0, 1, 2} && scheduler.carried_over() == 0);
+}
+
+// Tasks of 1 ms each against a 2.5 ms budget: the frame stops after the task crossing it, at least one always runs
+void check_budget() {
+  Scheduler scheduler;
+  scheduler.set_budget(2.5);
+  usize finished = 0;
+  constexpr usize BUSY_TASKS = 10;
+  for (usize i = 0; i < BUSY_TASKS; i++)
+    scheduler.spawn(busy(finished));
+
+  scheduler.run(FRAME_TIME);
+  check(finished >= 1 && finished <= 3);
+  check(scheduler.carried_over() == BUSY_TASKS - finished);
+
+  for (usize frame = 0; frame < BUSY_TASKS && scheduler.task_count() > 0; frame++)
+    scheduler.run(FRAME_TIME);
+  check(finished == BUSY_TASKS && scheduler.task_count() == 0);
+}
+
+void check_awaitables() {
+  Scheduler scheduler;
+  std::vector<u32> order;
+  Flag flag;
+  bool timer_done = false, flag_done = false;
+
+  // 50 ms from the first frame: not after 3 more frames of 16 ms, after the 4th
+  scheduler.spawn([](bool& done) -> Task {
+    co_await Scheduler::seconds(0.05);
+    done = true;
+  }(timer_done));
+  scheduler.spawn([](const Flag& flag, bool& done) -> Task {
+    co_await flag;
+    done = true;
+  }(flag, flag_done));
+  scheduler.spawn(parent(order));
+
+  for (u32 frame = 0; frame < 4; frame++)
+    scheduler.run(FRAME_TIME);
+  check(!timer_done && !flag_done);
+  check(order == std::vector<u32>{0, 1, 2, 3}); // The child hands back to its parent in the same frame
+
+  flag.value = true;
+  scheduler.run(FRAME_TIME);
+  check(timer_done && flag_done);
+  check(scheduler.task_count() == 0);
+}
+
+// Finished frames go back to the pool and the next tasks of the same size get them
+void check_frame_reuse() {
+  Scheduler scheduler;
+  std::vector<void*> first(TASK_COUNT), second(TASK_COUNT);
+  for (void*& address : first)
+    scheduler.spawn(address_of(address));
+  scheduler.run(FRAME_TIME);
+  check(scheduler.task_count() == 0);
+
+  for (void*& address : second)
+    scheduler.spawn(address_of(address));
+  scheduler.run(FRAME_TIME);
+
+  std::ranges::sort(first);
+  std::ranges::sort(second);
+  check(std::ranges::adjacent_find(first) == first.end());
+  check(first == second);
+
+  // Frames of tasks destroyed unfinished are returned too
+  void* unfinished = nullptr;
+  {
+    Scheduler other;
+    other.spawn([](void*& address) -> Task {
+      co_await FrameAddress{&address};
+      co_await Scheduler::seconds(1000.0);
+    }(unfinished));
+    other.run(FRAME_TIME);
+  }
+  void* reused = nullptr;
+  scheduler.spawn([](void*& address) -> Task {
+    co_await FrameAddress{&address};
+    co_await Scheduler::seconds(1000.0);
+  }(reused));
+  scheduler.run(FRAME_TIME);
+  check(unfinished != nullptr && reused == unfinished);
+}
+
+void benchmark() {
+  Scheduler scheduler;
+  usize count = 0;
+  const f64 time = nanoseconds_per(BENCHMARK_COUNT, [&] {
+    for (usize i = 0; i < BENCHMARK_COUNT; i++) {
+      scheduler.spawn([](usize& count) -> Task {
+        count++;
+        co_return;
+      }(count));
+      scheduler.run(FRAME_TIME);
+    }
+  });
+  check(count == BENCHMARK_COUNT);
+
+  std::println("[SCHEDULER] spawn and run a short task: {:.1f} ns", time);
+}
+
+} // namespace
+
+int main() {
+  check_carry_over();
+  check_budget();
+  check_awaitables();
+  check_frame_reuse();
+  benchmark();
+  return failures();
+}
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "core/snapshot.hpp"
+#include "test.hpp"
+
+// Snapshot round trips (full, then diffs applied in sequence), validation of corrupted section tables, the background
+// saver writing files in submission order, and saving without allocations once the buffers are sized
+
+namespace {
+
+constexpr u32 SECTION_ID = 7;
+constexpr usize ELEMENT_COUNT = 10'000; // Several pages
+
+struct Element {
+  f32 x;
+  f32 y;
+  u32 value;
+  u32 padding = 0; // Explicit, sections are compared byte for byte
+};
+
+std::vector<Element> make_elements() {
+  std::vector<Element> elements(ELEMENT_COUNT);
+  for (usize i = 0; i < elements.size(); i++)
+    elements[i] = Element{static_cast<f32>(i), static_cast<f32>(i) * 0.5f, static_cast<u32>(i)};
+  return elements;
+}
+
+bool same_bytes(std::span<const Element> a, std::span<const Element> b) {
+  return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+void check_round_trip() {
+  std::vector<Element> elements = make_elements();
+  SnapshotWriter writer;
+  writer.add_section(SECTION_ID, std::span<const Element>(elements));
+  const std::span<const std::byte> written = writer.write_full();
+  const std::vector<std::byte> full(written.begin(), written.end());
+
+  auto full_view = SnapshotView::create(full);
+  check(full_view.has_value());
+  auto section = full_view->section<Element>(SECTION_ID);
+  check(section.has_value() && same_bytes(*section, elements));
+  check(!full_view->section<u32>(SECTION_ID).has_value()); // Element size mismatch
+  check(!full_view->section<Element>(SECTION_ID + 1).has_value());
+
+  // Two diffs, the second one touching a single page
+  std::vector<Element> restored(section->begin(), section->end());
+  for (u32 round = 0; round < 2; round++) {
+    for (usize i = round == 0 ? 0 : ELEMENT_COUNT / 2; i < ELEMENT_COUNT; i += round == 0 ? 97 : ELEMENT_COUNT)
+      elements[i].value += 1'000;
+    writer.add_section(SECTION_ID, std::span<const Element>(elements));
+    auto diff = writer.write_diff();
+    check(diff.has_value());
+    const std::vector<std::byte> diff_bytes(diff->begin(), diff->end());
+    if (round == 1)
+      check(diff_bytes.size() < 2 * SnapshotWriter::PAGE_SIZE + 512);
+
+    auto diff_view = SnapshotView::create(diff_bytes);
+    check(diff_view.has_value() && diff_view->header().sequence == round + 1);
+    check(diff_view->apply(SECTION_ID, std::as_writable_bytes(std::span(restored))).has_value());
+    check(same_bytes(restored, elements));
+  }
+
+  // The same state gives the same bytes
+  SnapshotWriter other;
+  other.add_section(SECTION_ID, std::span<const Element>(elements));
+  SnapshotWriter again;
+  again.add_section(SECTION_ID, std::span<const Element>(elements));
+  const std::span<const std::byte> first = other.write_full(), second = again.write_full();
+  check(std::ranges::equal(first, second));
+}
+
+// Section tables pointing outside the snapshot are refused, including sizes wrapping around past the offset
+void check_corrupted() {
+  const std::vector<Element> elements = make_elements();
+  SnapshotWriter writer;
+  writer.add_section(SECTION_ID, std::span<const Element>(elements));
+  const std::span<const std::byte> written = writer.write_full();
+  const std::vector<std::byte> valid(written.begin(), written.end());
+
+  const usize table_offset = (sizeof(SnapshotHeader) + alignof(SnapshotSection) - 1) / alignof(SnapshotSection) * alignof(SnapshotSection);
+  const auto corrupt = [&](auto&& change) {
+    std::vector<std::byte> bytes = valid;
+    SnapshotSection section;
+    std::memcpy(&section, bytes.data() + table_offset, sizeof(section));
+    change(section);
+    std::memcpy(bytes.data() + table_offset, &section, sizeof(section));
+    return SnapshotView::create(bytes).has_value();
+  };
+
+  check(corrupt([](SnapshotSection&) {}));
+  check(!corrupt([&](SnapshotSection& section) { section.offset = valid.size() + 1; }));
+  check(!corrupt([&](SnapshotSection& section) { section.size = valid.size(); }));
+  check(!corrupt([](SnapshotSection& section) { section.size = ~u64{0} - section.offset + 1; })); // offset + size == 0
+
+  std::vector<std::byte> truncated(valid.begin(), valid.begin() + static_cast<std::ptrdiff_t>(valid.size() / 2));
+  check(!SnapshotView::create(truncated).has_value());
+}
+
+// Files written in order, a new chain removes the previous diffs, and saves reuse the job buffers
+void check_saver() {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "sdl_test_snapshot";
+  std::filesystem::create_directories(directory);
+  std::vector<std::string> paths;
+  for (u32 sequence = 0; sequence < 3; sequence++)
+    paths.push_back((directory / std::format("snapshot_{}.bin", sequence)).string());
+
+  std::vector<std::byte> bytes(3 * SnapshotWriter::PAGE_SIZE, std::byte{42});
+  auto saver = SnapshotSaver::create(paths, bytes.size());
+  if (!check(saver.has_value()))
+    return;
+
+  (*saver)->save(0, bytes);
+  bytes.assign(bytes.size(), std::byte{7}); // The saver has its own copy
+  const u64 allocations = allocations_during([&] {
+    for (usize i = 0; i < 2 * SnapshotSaver::QUEUE_SIZE; i++)
+      (*saver)->save(1 + static_cast<u32>(i % 2), bytes);
+  });
+  check(allocations == 0);
+  (*saver)->wait();
+
+  check((*saver)->failed_saves() == 0);
+  std::vector<char> read(bytes.size() + 1);
+  std::FILE* file = std::fopen(paths[0].c_str(), "rb");
+  check(file != nullptr && std::fread(read.data(), 1, read.size(), file) == bytes.size() && read.front() == 42 && read[bytes.size() - 1] == 42);
+  if (file != nullptr)
+    std::fclose(file);
+  check(std::filesystem::file_size(paths[1]) == bytes.size() && std::filesystem::file_size(paths[2]) == bytes.size());
+
+  (*saver)->save(0, bytes); // Removes the diffs before writing
+  (*saver)->wait();
+  check(std::filesystem::exists(paths[0]) && !std::filesystem::exists(paths[1]) && !std::filesystem::exists(paths[2]));
+  saver->reset();
+  std::filesystem::remove_all(directory);
+}
+
+// Once a full snapshot was built, diffs (even of every page) and new chains reuse the writer's buffer
+void check_writer_steady_state() {
+  std::vector<Element> elements = make_elements();
+  SnapshotWriter writer;
+  writer.add_section(SECTION_ID, std::span<const Element>(elements));
+  (void)writer.write_full();
+  writer.add_section(SECTION_ID, std::span<const Element>(elements));
+  (void)writer.write_diff();
+  writer.reset();
+  check(!writer.has_base());
+
+  const u64 allocations = allocations_during([&] {
+    writer.add_section(SECTION_ID, std::span<const Element>(elements));
+    (void)writer.write_full();
+    for (Element& element : elements)
+      element.value++;
+    writer.add_section(SECTION_ID, std::span<const Element>(elements));
+    check(writer.write_diff().has_value());
+  });
+  check(allocations == 0);
+}
+
+} // namespace
+
+int main() {
+  check_round_trip();
+  check_corrupted();
+  check_saver();
+  check_writer_steady_state();
+  return failures();
+}
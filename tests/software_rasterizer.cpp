@@ -0,0 +1,314 @@
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_init.h>
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_surface.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <format>
+#include <print>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "core/render_driver_benchmark.hpp"
+#include "core/render_queue.hpp"
+#include "core/software_rasterizer.hpp"
+#include "test.hpp"
+
+// SoftwareRasterizer output:
+// - Rows blended by the vector paths against blend_pixel() for every blend mode, with and without modulation, on every
+//   length and alignment (so the scalar tails too)
+// - Tiles drawn by 1 and several threads against the same frame built pixel by pixel with blend_pixel()
+// - Fill rects, rects, lines and textures (scaled, then rotated) against SDL's software renderer drawing the same
+//   RenderQueue
+// Prints the cost of a blended row per pixel (vector and scalar), then the frame time of every render driver and of the
+// rasterizer on RenderDriverBenchmark's scene
+
+namespace {
+
+using BlendMode = SoftwareRasterizer::BlendMode;
+using Command = SoftwareRasterizer::Command;
+
+constexpr u32 WIDTH = 200; // Not a multiple of the tile size, the last tiles are partial
+constexpr u32 HEIGHT = 150;
+constexpr u32 WHITE = 0xFFFFFFFFu;
+constexpr SDL_Color BACKGROUND{16, 24, 32, 255};
+constexpr std::array BLEND_MODES{BlendMode::None, BlendMode::Blend, BlendMode::Add, BlendMode::Mod, BlendMode::Mul};
+constexpr std::array<u32, 3> MODULATIONS{WHITE, 0x80FF4020u, 0xFF7F7F7Fu};
+constexpr usize MAX_ROW = 40;             // Longer than 4 AVX2 vectors
+constexpr u32 TOLERANCE = 4;              // Per channel, SDL rounds its blending differently
+constexpr u32 TEXTURE_SIZE = 16;
+constexpr usize BENCHMARK_PIXELS = 1 << 24;
+
+constexpr u32 argb(SDL_Color color) noexcept {
+  return u32{color.a} << 24 | u32{color.r} << 16 | u32{color.g} << 8 | u32{color.b};
+}
+
+u32* pixel_row(const SDL_Surface* surface, i32 y) {
+  return reinterpret_cast<u32*>(static_cast<u8*>(surface->pixels) + static_cast<usize>(surface->pitch) * static_cast<usize>(y));
+}
+
+bool close(u32 a, u32 b, u32 tolerance) {
+  for (u32 shift = 0; shift < 32; shift += 8) {
+    const i32 difference = static_cast<i32>((a >> shift) & 0xFF) - static_cast<i32>((b >> shift) & 0xFF);
+    if (static_cast<u32>(std::abs(difference)) > tolerance)
+      return false;
+  }
+  return true;
+}
+
+// Pixels further than tolerance apart
+usize mismatches(const SDL_Surface* a, const SDL_Surface* b, u32 tolerance) {
+  usize count = 0;
+  for (i32 y = 0; y < a->h; y++) {
+    const u32 *row_a = pixel_row(a, y), *row_b = pixel_row(b, y);
+    for (i32 x = 0; x < a->w; x++)
+      count += close(row_a[x], row_b[x], tolerance) ? 0 : 1;
+  }
+  return count;
+}
+
+// Quarters of different colors and alpha, with a lighter border
+std::array<u32, TEXTURE_SIZE * TEXTURE_SIZE> texture_pixels() {
+  constexpr std::array<u32, 4> quarters{0xFFE04030u, 0xC030C060u, 0x804080F0u, 0xFFF0D020u};
+  std::array<u32, TEXTURE_SIZE * TEXTURE_SIZE> pixels{};
+  for (u32 y = 0; y < TEXTURE_SIZE; y++) {
+    for (u32 x = 0; x < TEXTURE_SIZE; x++) {
+      const bool border = x == 0 || y == 0 || x == TEXTURE_SIZE - 1 || y == TEXTURE_SIZE - 1;
+      pixels[y * TEXTURE_SIZE + x] = border ? 0xFFFFFFFFu : quarters[(y / (TEXTURE_SIZE / 2)) * 2 + x / (TEXTURE_SIZE / 2)];
+    }
+  }
+  return pixels;
+}
+
+void check_rows() {
+  std::mt19937 random_engine{42};
+  std::uniform_int_distribution<u32> random_pixel;
+  std::array<u32, MAX_ROW + 8> destination, expected;
+  std::array<u32, MAX_ROW> source;
+
+  for (const BlendMode blend : BLEND_MODES) {
+    bool rows_match = true, fills_match = true;
+    for (const u32 modulation : MODULATIONS) {
+      for (usize count = 0; count <= MAX_ROW; count++) {
+        for (usize offset = 0; offset < 4; offset++) {
+          // Pixels past the row must be left alone
+          std::ranges::generate(destination, [&] { return random_pixel(random_engine); });
+          std::ranges::generate(source, [&] { return random_pixel(random_engine); });
+          expected = destination;
+          for (usize i = 0; i < count; i++)
+            expected[offset + i] = SoftwareRasterizer::blend_pixel(destination[offset + i], source[i], blend, modulation);
+          SoftwareRasterizer::blend_row(destination.data() + offset, source.data(), count, modulation, blend);
+          rows_match &= destination == expected;
+
+          // Fills, translucent then opaque (stored without blending)
+          for (const u32 color : {source[0], source[0] | 0xFF000000u}) {
+            expected = destination;
+            for (usize i = 0; i < count; i++)
+              expected[offset + i] = SoftwareRasterizer::blend_pixel(destination[offset + i], color, blend);
+            SoftwareRasterizer::fill_row(destination.data() + offset, count, color, blend);
+            fills_match &= destination == expected;
+          }
+        }
+      }
+    }
+    check(rows_match);
+    check(fills_match);
+  }
+}
+
+// Fills and unscaled textures over tile borders and out of the frame, in every blend mode, against the frame built
+// one pixel at a time
+void check_tiles(u32 threads) {
+  auto rasterizer = SoftwareRasterizer::create(WIDTH, HEIGHT, SoftwareRasterizer::Settings{.threads = threads});
+  if (!check(rasterizer.has_value()))
+    return;
+
+  // Never drawn through SDL, any address will do as a key
+  const std::array<u32, TEXTURE_SIZE * TEXTURE_SIZE> pixels = texture_pixels();
+  SDL_Texture* texture = reinterpret_cast<SDL_Texture*>(0x1000);
+  (*rasterizer)->add_image(texture, SDL_PIXELFORMAT_ARGB8888, TEXTURE_SIZE, TEXTURE_SIZE);
+  (*rasterizer)->update_image(texture, pixels.data(), TEXTURE_SIZE * sizeof(u32));
+
+  std::mt19937 random_engine{7};
+  std::uniform_int_distribution<i32> position(-20, static_cast<i32>(WIDTH));
+  std::uniform_int_distribution<i32> size(1, 90);
+  std::uniform_int_distribution<u32> channel(0, 255);
+  std::vector<Command> commands;
+  for (usize i = 0; i < 200; i++) {
+    const BlendMode blend = BLEND_MODES[i % BLEND_MODES.size()];
+    const SDL_Color color{static_cast<u8>(channel(random_engine)), static_cast<u8>(channel(random_engine)), static_cast<u8>(channel(random_engine)), static_cast<u8>(channel(random_engine))};
+    const SDL_FRect rect{static_cast<f32>(position(random_engine)), static_cast<f32>(position(random_engine)), static_cast<f32>(size(random_engine)), static_cast<f32>(size(random_engine))};
+    if (i % 3 == 0)
+      commands.push_back(Command{RenderQueue::Type::Texture, blend, i % 2 == 0 ? SDL_Color{255, 255, 255, 255} : color, texture, SDL_FRect{}, SDL_FRect{rect.x, rect.y, TEXTURE_SIZE, TEXTURE_SIZE}});
+    else
+      commands.push_back(Command{RenderQueue::Type::FillRect, blend, color, nullptr, SDL_FRect{}, rect});
+  }
+
+  std::vector<u32> expected(usize{WIDTH} * HEIGHT, argb(BACKGROUND));
+  for (const Command& command : commands) {
+    const i32 x0 = static_cast<i32>(command.destination.x), y0 = static_cast<i32>(command.destination.y);
+    const i32 x1 = x0 + static_cast<i32>(command.destination.w), y1 = y0 + static_cast<i32>(command.destination.h);
+    for (i32 y = std::max(y0, 0); y < std::min(y1, static_cast<i32>(HEIGHT)); y++) {
+      for (i32 x = std::max(x0, 0); x < std::min(x1, static_cast<i32>(WIDTH)); x++) {
+        u32& pixel = expected[static_cast<usize>(y) * WIDTH + static_cast<usize>(x)];
+        pixel = command.type == RenderQueue::Type::FillRect
+                    ? SoftwareRasterizer::blend_pixel(pixel, argb(command.color), command.blend)
+                    : SoftwareRasterizer::blend_pixel(pixel, pixels[static_cast<usize>(y - y0) * TEXTURE_SIZE + static_cast<usize>(x - x0)], command.blend, argb(command.color));
+      }
+    }
+  }
+
+  // Twice, the second frame reuses the bins of the first
+  for (usize frame = 0; frame < 2; frame++) {
+    (*rasterizer)->clear(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b);
+    for (const Command& command : commands)
+      (*rasterizer)->submit(command);
+    (*rasterizer)->render();
+
+    const SDL_Surface* framebuffer = (*rasterizer)->framebuffer();
+    bool frame_matches = true;
+    for (u32 y = 0; y < HEIGHT; y++)
+      frame_matches &= std::equal(expected.begin() + y * WIDTH, expected.begin() + (y + 1) * WIDTH, pixel_row(framebuffer, static_cast<i32>(y)));
+    check(frame_matches);
+  }
+}
+
+// The same queue drawn by SDL's software renderer and by the rasterizer, both on ARGB8888 surfaces
+struct SdlTarget {
+  SDL_Surface* surface = nullptr;
+  SDL_Renderer* renderer = nullptr;
+  SDL_Texture* texture = nullptr;
+
+  SdlTarget() {
+    surface = SDL_CreateSurface(WIDTH, HEIGHT, SDL_PIXELFORMAT_ARGB8888);
+    renderer = surface != nullptr ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    texture = renderer != nullptr ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, TEXTURE_SIZE, TEXTURE_SIZE) : nullptr;
+  }
+  SdlTarget(const SdlTarget&) = delete;
+  SdlTarget& operator=(const SdlTarget&) = delete;
+  ~SdlTarget() {
+    if (texture != nullptr)
+      SDL_DestroyTexture(texture);
+    if (renderer != nullptr)
+      SDL_DestroyRenderer(renderer);
+    if (surface != nullptr)
+      SDL_DestroySurface(surface);
+  }
+};
+
+// Draws the scene with both, returns the pixels further than TOLERANCE apart
+template <typename TScene>
+usize compare_with_sdl(SdlTarget& target, SoftwareRasterizer& rasterizer, TScene&& scene) {
+  RenderQueue queue;
+  SDL_SetRenderDrawColor(target.renderer, BACKGROUND.r, BACKGROUND.g, BACKGROUND.b, BACKGROUND.a);
+  SDL_RenderClear(target.renderer);
+  scene(queue);
+  queue.flush(target.renderer);
+  SDL_FlushRenderer(target.renderer);
+
+  rasterizer.clear(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b);
+  scene(queue);
+  queue.flush(rasterizer);
+
+  return mismatches(target.surface, rasterizer.framebuffer(), TOLERANCE);
+}
+
+void check_against_sdl() {
+  SdlTarget target;
+  auto rasterizer = SoftwareRasterizer::create(WIDTH, HEIGHT, SoftwareRasterizer::Settings{.threads = 1});
+  if (!check(target.texture != nullptr && rasterizer.has_value()))
+    return;
+
+  const std::array<u32, TEXTURE_SIZE * TEXTURE_SIZE> pixels = texture_pixels();
+  SDL_UpdateTexture(target.texture, nullptr, pixels.data(), TEXTURE_SIZE * sizeof(u32));
+  SDL_SetTextureScaleMode(target.texture, SDL_SCALEMODE_NEAREST);
+  (*rasterizer)->add_image(target.texture, SDL_PIXELFORMAT_ARGB8888, TEXTURE_SIZE, TEXTURE_SIZE);
+  (*rasterizer)->update_image(target.texture, pixels.data(), TEXTURE_SIZE * sizeof(u32));
+
+  // Pixel aligned shapes, each blend mode on fills, opaque outlines and lines (horizontal, vertical and diagonal so
+  // every line algorithm picks the same pixels), textures scaled by whole factors
+  check(compare_with_sdl(target, **rasterizer, [&](RenderQueue& queue) {
+          for (usize i = 0; i < BLEND_MODES.size(); i++) {
+            const f32 x = 4.0f + 38.0f * static_cast<f32>(i);
+            queue.fill_rect({x, 4.0f, 30.0f, 60.0f}, {200, 120, 40, 255}, 0, 0, BlendMode::None);
+            queue.fill_rect({x + 10.0f, 20.0f, 27.0f, 50.0f}, {40, 160, 220, 140}, 1, static_cast<u32>(i), BLEND_MODES[i]);
+          }
+          queue.rect({10.0f, 80.0f, 41.0f, 23.0f}, {250, 250, 250, 255}, 2);
+          queue.rect({12.0f, 82.0f, 1.0f, 1.0f}, {250, 0, 0, 255}, 2);
+          queue.line(60.0f, 80.0f, 120.0f, 80.0f, {0, 250, 0, 255}, 2);
+          queue.line(60.0f, 82.0f, 60.0f, 140.0f, {0, 250, 0, 255}, 2);
+          queue.line(62.0f, 84.0f, 112.0f, 134.0f, {0, 250, 250, 255}, 2);
+          queue.line(190.0f, 84.0f, 140.0f, 134.0f, {250, 0, 250, 255}, 2);
+          queue.texture(target.texture, nullptr, {120.0f, 84.0f, 32.0f, 32.0f}, 3);
+          queue.texture(target.texture, nullptr, {150.0f, 100.0f, 32.0f, 48.0f}, 3, 0, BlendMode::Blend, {255, 128, 64, 200});
+          const SDL_FRect source{4.0f, 4.0f, 8.0f, 8.0f};
+          queue.texture(target.texture, &source, {4.0f, 110.0f, 24.0f, 24.0f}, 3, 0, BlendMode::None);
+        }) == 0);
+
+  // Rotated, SDL rotates a scaled copy of the texture: only the edges and the borders between the quarters may differ
+  const usize rotated_mismatches = compare_with_sdl(target, **rasterizer, [&](RenderQueue& queue) {
+    queue.texture_rotated(target.texture, nullptr, {20.0f, 20.0f, 48.0f, 48.0f}, 90.0f);
+    queue.texture_rotated(target.texture, nullptr, {80.0f, 20.0f, 48.0f, 48.0f}, 180.0f);
+    queue.texture_rotated(target.texture, nullptr, {40.0f, 80.0f, 48.0f, 48.0f}, 30.0f, 0, 0, BlendMode::None);
+    queue.texture_rotated(target.texture, nullptr, {120.0f, 80.0f, 48.0f, 48.0f}, -60.0f, 0, 0, BlendMode::Blend, {255, 255, 255, 160});
+  });
+  constexpr usize ROTATED_AREA = 4 * 48 * 48;
+  check(rotated_mismatches * 10 <= ROTATED_AREA);
+}
+
+void benchmark_rows() {
+  std::vector<u32> destination(MAX_ROW * 64, 0xFF203040u), source(MAX_ROW * 64, 0x80E0A060u);
+  constexpr usize ROUNDS = BENCHMARK_PIXELS / (MAX_ROW * 64);
+  const usize pixels = ROUNDS * destination.size();
+  const f64 vector_time = nanoseconds_per(pixels, [&] {
+    for (usize round = 0; round < ROUNDS; round++)
+      SoftwareRasterizer::blend_row(destination.data(), source.data(), destination.size(), WHITE, BlendMode::Blend);
+  });
+  const f64 scalar_time = nanoseconds_per(pixels, [&] {
+    for (usize round = 0; round < ROUNDS; round++) {
+      for (usize i = 0; i < destination.size(); i++)
+        destination[i] = SoftwareRasterizer::blend_pixel(destination[i], source[i], BlendMode::Blend);
+    }
+  });
+  check(destination.front() != 0);
+
+  std::println("[RASTERIZER] blended row: {:.2f} ns per pixel (scalar {:.2f} ns)", vector_time, scalar_time);
+}
+
+// Frame times of every render driver, then of the rasterizer on one thread and on every core
+void benchmark_drivers() {
+  if (!SDL_Init(SDL_INIT_VIDEO)) {
+    std::println("[RENDER] skipped, no video: {}", SDL_GetError());
+    return;
+  }
+
+  for (const RenderDriverBenchmark::Result& result : RenderDriverBenchmark::run())
+    std::println("[RENDER] {:<24} {:8.3f} ms", result.driver, result.frame_time * 1000.0);
+
+  const auto measure_rasterizer = [](u32 threads) {
+    if (std::optional<f64> frame_time = RenderDriverBenchmark::measure_rasterizer(SoftwareRasterizer::Settings{.threads = threads}))
+      std::println("[RENDER] {:<24} {:8.3f} ms", std::format("rasterizer ({} threads)", threads), *frame_time * 1000.0);
+  };
+
+  const u32 threads = static_cast<u32>(std::clamp<usize>(std::thread::hardware_concurrency(), 1, SoftwareRasterizer::MAX_THREADS));
+  measure_rasterizer(1);
+  if (threads > 1)
+    measure_rasterizer(threads);
+
+  SDL_Quit();
+}
+
+} // namespace
+
+int main() {
+  check_rows();
+  check_tiles(1);
+  check_tiles(4);
+  check_against_sdl();
+  benchmark_rows();
+  benchmark_drivers();
+  return failures();
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <print>
+#include <random>
+#include <vector>
+
+#include "core/spatial_hash.hpp"
+#include "test.hpp"
+
+// SpatialHash queries against testing every object, after inserts, moves across cells and removals, with objects
+// spanning several cells and crowds spilling a cell past its inline ids
+// Prints the time per tick of moving every object then querying around each of them
+// Built with SDL_TEST_ALLOCATION_TRACKING, moving inside a reserved world is also checked not to allocate
+
+namespace {
+
+constexpr usize OBJECT_COUNT = 4'000;
+constexpr usize TICKS = 60;
+constexpr usize WARMUP_TICKS = 3'000; // Until the busiest cells and the spare buffers stop growing
+constexpr f32 WORLD_SIZE = 2'000.0f;
+constexpr f32 CELL_SIZE = 64.0f;
+constexpr f32 MAX_HALF_SIZE = 40.0f; // Up to 2 cells wide
+constexpr f32 MAX_SPEED = 24.0f;     // Per tick
+constexpr f32 QUERY_RADIUS = 48.0f;
+
+using Id = SpatialHash::Id;
+using Bounds = SpatialHash::Bounds;
+
+struct Object {
+  glm::vec2 position;
+  glm::vec2 velocity;
+  f32 half_size;
+  bool alive = true;
+};
+
+Bounds bounds_of(const Object& object) {
+  return {object.position - glm::vec2(object.half_size), object.position + glm::vec2(object.half_size)};
+}
+
+// Same inclusive overlap tests as the hash
+bool overlaps(const Bounds& a, const Bounds& b) {
+  return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+bool within(const Bounds& bounds, glm::vec2 center, f32 radius) {
+  const glm::vec2 delta = center - glm::clamp(center, bounds.min, bounds.max);
+  return delta.x * delta.x + delta.y * delta.y <= radius * radius;
+}
+
+std::vector<Object> make_objects(std::mt19937& random_engine) {
+  std::uniform_real_distribution<f32> position(0.0f, WORLD_SIZE);
+  std::uniform_real_distribution<f32> velocity(-MAX_SPEED, MAX_SPEED);
+  std::uniform_real_distribution<f32> half_size(1.0f, MAX_HALF_SIZE);
+  std::vector<Object> objects(OBJECT_COUNT);
+  for (Object& object : objects)
+    object = Object{{position(random_engine), position(random_engine)}, {velocity(random_engine), velocity(random_engine)}, half_size(random_engine)};
+  return objects;
+}
+
+void step(std::vector<Object>& objects, SpatialHash& hash) {
+  for (usize i = 0; i < objects.size(); i++) {
+    Object& object = objects[i];
+    object.position += object.velocity;
+    for (i32 axis = 0; axis < 2; axis++) {
+      if (object.position[axis] < 0.0f || object.position[axis] > WORLD_SIZE) {
+        object.position[axis] = std::clamp(object.position[axis], 0.0f, WORLD_SIZE);
+        object.velocity[axis] = -object.velocity[axis];
+      }
+    }
+    if (object.alive)
+      hash.move(static_cast<Id>(i), bounds_of(object));
+  }
+}
+
+// Every query of the hash returns each matching object exactly once
+bool queries_match(const std::vector<Object>& objects, const SpatialHash& hash, std::mt19937& random_engine) {
+  std::uniform_real_distribution<f32> position(-100.0f, WORLD_SIZE + 100.0f);
+  std::uniform_real_distribution<f32> extent(0.0f, 300.0f);
+  std::vector<Id> found, expected;
+  for (usize query = 0; query < 50; query++) {
+    const glm::vec2 corner{position(random_engine), position(random_engine)};
+    const Bounds rect{corner, corner + glm::vec2(extent(random_engine), extent(random_engine))};
+    const f32 radius = extent(random_engine);
+
+    found.clear();
+    expected.clear();
+    hash.query_rect(rect, found);
+    for (usize i = 0; i < objects.size(); i++) {
+      if (objects[i].alive && overlaps(bounds_of(objects[i]), rect))
+        expected.push_back(static_cast<Id>(i));
+    }
+    std::ranges::sort(found);
+    if (found != expected)
+      return false;
+
+    found.clear();
+    expected.clear();
+    hash.query_radius(corner, radius, found);
+    for (usize i = 0; i < objects.size(); i++) {
+      if (objects[i].alive && within(bounds_of(objects[i]), corner, radius))
+        expected.push_back(static_cast<Id>(i));
+    }
+    std::ranges::sort(found);
+    if (found != expected)
+      return false;
+  }
+  return true;
+}
+
+void check_queries() {
+  std::mt19937 random_engine{42};
+  std::vector<Object> objects = make_objects(random_engine);
+  SpatialHash hash(CELL_SIZE);
+  for (usize i = 0; i < objects.size(); i++)
+    hash.insert(static_cast<Id>(i), bounds_of(objects[i]));
+  check(queries_match(objects, hash, random_engine));
+
+  // Moves, then a third of the objects removed, then some of them inserted again
+  for (usize tick = 0; tick < 10; tick++)
+    step(objects, hash);
+  check(queries_match(objects, hash, random_engine));
+
+  for (usize i = 0; i < objects.size(); i += 3) {
+    hash.remove(static_cast<Id>(i));
+    objects[i].alive = false;
+  }
+  hash.remove(static_cast<Id>(0)); // Twice
+  check(!hash.contains(0) && hash.contains(1));
+  for (usize tick = 0; tick < 10; tick++)
+    step(objects, hash);
+  check(queries_match(objects, hash, random_engine));
+
+  for (usize i = 0; i < objects.size(); i += 6) {
+    objects[i].alive = true;
+    hash.insert(static_cast<Id>(i), bounds_of(objects[i]));
+  }
+  hash.insert(static_cast<Id>(1), bounds_of(objects[1])); // Already there
+  check(queries_match(objects, hash, random_engine));
+
+  hash.clear();
+  std::vector<Id> found;
+  hash.query_rect({glm::vec2(0.0f), glm::vec2(WORLD_SIZE)}, found);
+  check(found.empty() && !hash.contains(1));
+}
+
+// A crowd walking through a row of cells: every cell spills then empties in turn
+void check_crowd() {
+  constexpr usize CROWD = 3 * SpatialHash::INLINE_CELL_IDS;
+  SpatialHash hash(CELL_SIZE);
+  hash.reserve({glm::vec2(0.0f), glm::vec2(WORLD_SIZE)});
+
+  auto place = [&](f32 x) {
+    for (Id id = 0; id < CROWD; id++) {
+      const glm::vec2 position{x + 0.5f * static_cast<f32>(id % 4), CELL_SIZE / 2.0f};
+      hash.move(id, {position, position});
+    }
+  };
+
+  bool all_found = true;
+  std::vector<Id> found;
+  for (f32 x = 1.0f; x < WORLD_SIZE - 4.0f; x += CELL_SIZE / 4.0f) {
+    place(x);
+    found.clear();
+    hash.query_radius({x, CELL_SIZE / 2.0f}, 4.0f, found);
+    all_found &= found.size() == CROWD;
+  }
+  check(all_found);
+
+  // Back and forth, the buffers spilled on the first pass are handed from cell to cell
+  const u64 allocations = allocations_during([&] {
+    for (usize pass = 0; pass < 4; pass++) {
+      for (f32 x = 1.0f; x < WORLD_SIZE - 4.0f; x += CELL_SIZE / 4.0f)
+        place(pass % 2 == 0 ? WORLD_SIZE - 4.0f - x : x);
+    }
+  });
+  check(allocations == 0);
+}
+
+// Objects wandering a reserved world, including bounds sticking out of it by their size
+void check_steady_state() {
+  std::mt19937 random_engine{7};
+  std::vector<Object> objects = make_objects(random_engine);
+  SpatialHash hash(CELL_SIZE);
+  hash.reserve({glm::vec2(-MAX_HALF_SIZE), glm::vec2(WORLD_SIZE + MAX_HALF_SIZE)});
+  for (usize i = 0; i < objects.size(); i++)
+    hash.insert(static_cast<Id>(i), bounds_of(objects[i]));
+  for (usize tick = 0; tick < WARMUP_TICKS; tick++)
+    step(objects, hash);
+
+  std::vector<Id> found;
+  found.reserve(OBJECT_COUNT);
+  const u64 allocations = allocations_during([&] {
+    for (usize tick = 0; tick < TICKS; tick++) {
+      step(objects, hash);
+      found.clear();
+      hash.query_radius(objects[tick].position, QUERY_RADIUS, found);
+    }
+  });
+  check(allocations == 0);
+}
+
+void benchmark() {
+  std::mt19937 random_engine{42};
+  std::vector<Object> objects = make_objects(random_engine);
+  SpatialHash hash(CELL_SIZE);
+  hash.reserve({glm::vec2(-MAX_HALF_SIZE), glm::vec2(WORLD_SIZE + MAX_HALF_SIZE)});
+  for (usize i = 0; i < objects.size(); i++)
+    hash.insert(static_cast<Id>(i), bounds_of(objects[i]));
+
+  std::vector<Id> found;
+  usize neighbors = 0;
+  const f64 time = nanoseconds_per(TICKS, [&] {
+    for (usize tick = 0; tick < TICKS; tick++) {
+      step(objects, hash);
+      for (const Object& object : objects) {
+        found.clear();
+        hash.query_radius(object.position, QUERY_RADIUS, found);
+        neighbors += found.size();
+      }
+    }
+  });
+  check(neighbors >= TICKS * OBJECT_COUNT); // Every object finds itself
+
+  std::println("[SPATIAL_HASH] {} objects, move + radius query each: {:.3f} ms per tick", OBJECT_COUNT, time / 1e6);
+}
+
+} // namespace
+
+int main() {
+  check_queries();
+  check_crowd();
+  check_steady_state();
+  benchmark();
+  return failures();
+}
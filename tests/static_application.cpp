@@ -0,0 +1,81 @@
+#include <SDL3/SDL_events.h>
+
+#include <algorithm>
+#include <print>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "core/static_application.hpp"
+#include "test.hpp"
+
+// Per-event dispatch overhead of the frame loop: input() called through the vtable (Application) or on the final type
+// (StaticApplication), with the same result check run_loop() does
+
+namespace {
+
+constexpr usize EVENT_COUNT = 2'000'000;
+constexpr usize ROUNDS = 5; // Best round is kept
+
+class CountingApplication final : public StaticApplication<CountingApplication> {
+ public:
+  u64 sum = 0;
+
+  explicit CountingApplication(Application&& app) : StaticApplication(std::move(app)) {}
+
+  re::expected<re::AnyError> setup() noexcept override { return re::expected<re::AnyError>(); }
+  re::expected<re::AnyError> input(const SDL_Event& event) noexcept override {
+    if (event.type == SDL_EVENT_KEY_DOWN)
+      sum += event.key.scancode;
+    return re::expected<re::AnyError>();
+  }
+  re::expected<re::AnyError> update(double UNUSED(delta_time)) noexcept override { return re::expected<re::AnyError>(); }
+  re::expected<re::AnyError> draw() const noexcept override { return re::expected<re::AnyError>(); }
+};
+
+// Not inlined, so the dynamic type stays unknown to the virtual loop
+[[gnu::noinline]] bool dispatch_virtual(Application& app, std::span<const SDL_Event> events) {
+  for (const SDL_Event& event : events)
+    if (auto result = app.input(event); !result) [[unlikely]]
+      return false;
+  return true;
+}
+
+template <typename TSelf>
+[[gnu::noinline]] bool dispatch_static(TSelf& self, std::span<const SDL_Event> events) {
+  for (const SDL_Event& event : events)
+    if (auto result = self.input(event); !result) [[unlikely]]
+      return false;
+  return true;
+}
+
+} // namespace
+
+int main() {
+  auto app = Application::create("static_application test", 64, 64, Window::Flags::Hidden, Renderer::Driver::Software);
+  if (!check(app.has_value()))
+    return failures();
+  CountingApplication counting(std::move(*app));
+
+  std::vector<SDL_Event> events(EVENT_COUNT);
+  for (usize i = 0; i < events.size(); i++) {
+    events[i].type = i % 2 == 0 ? SDL_EVENT_KEY_DOWN : SDL_EVENT_MOUSE_MOTION;
+    events[i].key.scancode = static_cast<SDL_Scancode>(i % 64);
+  }
+
+  f64 virtual_time = 1e9, static_time = 1e9;
+  u64 virtual_sum = 0, static_sum = 0;
+  for (usize round = 0; round < ROUNDS; round++) {
+    counting.sum = 0;
+    virtual_time = std::min(virtual_time, nanoseconds_per(events.size(), [&] { check(dispatch_virtual(counting, events)); }));
+    virtual_sum = counting.sum;
+
+    counting.sum = 0;
+    static_time = std::min(static_time, nanoseconds_per(events.size(), [&] { check(dispatch_static(counting, events)); }));
+    static_sum = counting.sum;
+  }
+  check(virtual_sum == static_sum);
+
+  std::println("[DISPATCH] virtual: {:.2f} ns/event, static: {:.2f} ns/event ({} events)", virtual_time, static_time, events.size());
+  return failures();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <print>
+#include <source_location>
+#include <unders_helpers/types.hpp>
+
+#include "core/allocation_tracker.hpp"
+
+// Helpers shared by the test executables
+// A failed check prints where it failed, main() returns failures() so ctest reports the test as failed
+// Benchmarks only print their timings, they never fail a test
+
+inline u32 check_failures = 0;
+
+inline bool check(bool condition, std::source_location location = std::source_location::current()) {
+  if (!condition) [[unlikely]] {
+    check_failures++;
+    std::println(stderr, "[FAILED] {}:{}", location.file_name(), location.line());
+  }
+  return condition;
+}
+
+[[nodiscard]] inline int failures() {
+  return check_failures == 0 ? 0 : 1;
+}
+
+// Average duration of run() per item, in ns
+template <typename TFunction>
+[[nodiscard]] f64 nanoseconds_per(usize items, TFunction&& run) {
+  const auto start = std::chrono::steady_clock::now();
+  run();
+  return std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<f64>(items);
+}
+
+// Heap allocations made by run() on the calling thread, only counted when built with SDL_TEST_ALLOCATION_TRACKING
+// (always 0 otherwise, the checks on it then pass without testing anything)
+template <typename TFunction>
+[[nodiscard]] u64 allocations_during(TFunction&& run) {
+  AllocationTracker::end_frame();
+  AllocationTracker::set_phase(AllocationTracker::Phase::Update);
+  run();
+  AllocationTracker::set_phase(AllocationTracker::Phase::Count);
+  return AllocationTracker::end_frame().allocations();
+}